@@ -0,0 +1,95 @@
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <vector>
+
+namespace {
+  std::atomic<std::uint64_t> gAllocations(0);
+}
+
+void* operator new(std::size_t size) {
+  ++gAllocations;
+  void* memory = std::malloc(size > 0 ? size : 1);
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+  
+  return memory;
+}
+
+void operator delete(void* memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t size) noexcept {
+  std::free(memory);
+}
+
+namespace quip {
+  namespace {
+    std::vector<Benchmark*>& registry() {
+      static std::vector<Benchmark*> benchmarks;
+      return benchmarks;
+    }
+  }
+  
+  Benchmark::Benchmark(const std::string& name, BodyType body)
+  : m_name(name)
+  , m_body(body) {
+    registry().emplace_back(this);
+  }
+  
+  const std::string& Benchmark::name() const {
+    return m_name;
+  }
+  
+  void Benchmark::measure(const std::string& label, std::size_t iterations, FunctionType function) {
+    measure(label, iterations, 0, function);
+  }
+  
+  void Benchmark::measure(const std::string& label, std::size_t iterations, std::size_t bytes, FunctionType function) {
+    typedef std::chrono::high_resolution_clock Clock;
+    
+    double best = std::numeric_limits<double>::max();
+    for (std::size_t iteration = 0; iteration < iterations; ++iteration) {
+      Clock::time_point start = Clock::now();
+      function();
+      std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+      best = std::min(best, elapsed.count());
+    }
+    
+    if (bytes > 0) {
+      double throughput = (bytes / (1024.0 * 1024.0)) / (best / 1000.0);
+      std::printf("  %-48s %10.3f ms %10.1f MB/s\n", label.c_str(), best, throughput);
+    } else {
+      std::printf("  %-48s %10.3f ms\n", label.c_str(), best);
+    }
+  }
+  
+  void Benchmark::report(const std::string& label, double value, const std::string& unit) {
+    std::printf("  %-48s %10.3f %s\n", label.c_str(), value, unit.c_str());
+  }
+  
+  std::uint64_t Benchmark::allocations() {
+    return gAllocations.load();
+  }
+  
+  int Benchmark::runAll(const std::string& filter) {
+    for (Benchmark* benchmark : registry()) {
+      if (benchmark->name().find(filter) == std::string::npos) {
+        continue;
+      }
+      
+      std::printf("%s\n", benchmark->name().c_str());
+      benchmark->m_body(*benchmark);
+    }
+    
+    return 0;
+  }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace quip {
+  // A named group of related measurements.
+  //
+  // Benchmarks register themselves when constructed, so defining one at namespace scope in any
+  // source file of the benchmark executable is enough for the driver to run it.
+  struct Benchmark {
+    typedef std::function<void (Benchmark&)> BodyType;
+    typedef std::function<void ()> FunctionType;
+    
+    Benchmark(const std::string& name, BodyType body);
+    
+    const std::string& name() const;
+    
+    // Run a function the specified number of times and report the fastest run. If a byte
+    // count is given, the throughput of the fastest run is also reported.
+    void measure(const std::string& label, std::size_t iterations, FunctionType function);
+    void measure(const std::string& label, std::size_t iterations, std::size_t bytes, FunctionType function);
+    
+    // Report a value that isn't a running time, such as a memory footprint.
+    void report(const std::string& label, double value, const std::string& unit);
+    
+    // The number of allocations the process has made so far. The benchmark executable replaces
+    // the global operator new in order to count them.
+    static std::uint64_t allocations();
+    
+    // Run every registered benchmark whose name contains the filter text.
+    static int runAll(const std::string& filter);
+    
+  private:
+    std::string m_name;
+    BodyType m_body;
+  };
+}
@@ -0,0 +1,71 @@
+#include "Benchmark.hpp"
+
+#include "Document.hpp"
+#include "Selection.hpp"
+#include "SelectionSet.hpp"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace quip;
+
+namespace {
+  typedef std::chrono::high_resolution_clock Clock;
+  
+  std::string generateText(std::size_t rows) {
+    std::string result;
+    for (std::size_t row = 0; row < rows; ++row) {
+      result += "    std::size_t value" + std::to_string(row) + " = compute(row, column);\n";
+    }
+    
+    return result;
+  }
+  
+  // Repeat an operation too quick to time on its own, reporting the average time and
+  // allocations of each repetition.
+  void measureEach(Benchmark& benchmark, const std::string& label, std::size_t repetitions, const std::function<void ()>& operation) {
+    std::uint64_t allocations = Benchmark::allocations();
+    Clock::time_point start = Clock::now();
+    for (std::size_t index = 0; index < repetitions; ++index) {
+      operation();
+    }
+    
+    std::chrono::duration<double, std::micro> elapsed = Clock::now() - start;
+    benchmark.report(label + ", each", elapsed.count() / repetitions, "us");
+    benchmark.report(label + ", allocations each", static_cast<double>(Benchmark::allocations() - allocations) / repetitions, "");
+  }
+  
+  Benchmark benchmark("Document", [] (Benchmark& benchmark) {
+    std::vector<std::shared_ptr<const Document>> snapshots;
+    snapshots.reserve(10000);
+    
+    // Taking a snapshot costs the same however large the document is.
+    Document small(generateText(1000));
+    measureEach(benchmark, "Snapshot of 1000 rows", 10000, [&] () {
+      snapshots.push_back(small.snapshot());
+    });
+    
+    snapshots.clear();
+    
+    Document large(generateText(1000000));
+    measureEach(benchmark, "Snapshot of 1000000 rows", 10000, [&] () {
+      snapshots.push_back(large.snapshot());
+    });
+    
+    snapshots.clear();
+    
+    // An edit made while a snapshot is held copies the document's index of chunks, but none of
+    // the chunks it didn't touch.
+    measureEach(benchmark, "Editing 1000000 rows", 1000, [&] () {
+      large.insert(Selection(Location(4, 500000)), "x");
+    });
+    
+    measureEach(benchmark, "Editing 1000000 rows with a snapshot held", 1000, [&] () {
+      snapshots.push_back(large.snapshot());
+      large.insert(Selection(Location(4, 500000)), "x");
+    });
+  });
+}
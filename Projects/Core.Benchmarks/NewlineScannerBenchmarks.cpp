@@ -0,0 +1,78 @@
+#include "Benchmark.hpp"
+
+#include "Document.hpp"
+#include "NewlineScanner.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace quip;
+
+namespace {
+  // Roughly source-code-shaped text: rows of varying length, a few of them blank.
+  std::string generateText(std::size_t size) {
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<std::size_t> lengths(0, 120);
+    
+    std::string result;
+    result.reserve(size);
+    while (result.size() < size) {
+      result.append(lengths(generator), 'x');
+      result += '\n';
+    }
+    
+    return result;
+  }
+  
+  // The row decomposition Document used before the vectorized scanner.
+  std::vector<std::string> decomposeByFind(const std::string& text) {
+    std::vector<std::string> results;
+    std::string::size_type start = 0;
+    while (start < text.size()) {
+      std::string::size_type end = text.find_first_of('\n', start);
+      if (end != std::string::npos) {
+        results.emplace_back(text.substr(start, end - start + 1));
+        start = end + 1;
+      } else {
+        results.emplace_back(text.substr(start));
+        break;
+      }
+    }
+    
+    return results;
+  }
+  
+  Benchmark benchmark("NewlineScanner", [] (Benchmark& benchmark) {
+    const std::size_t size = 100 * 1024 * 1024;
+    std::string text = generateText(size);
+    
+    std::vector<std::size_t> offsets;
+    benchmark.measure("find_first_of scan", 5, text.size(), [&] {
+      offsets.clear();
+      std::string::size_type cursor = text.find_first_of('\n');
+      while (cursor != std::string::npos) {
+        offsets.push_back(cursor);
+        cursor = text.find_first_of('\n', cursor + 1);
+      }
+    });
+    
+    benchmark.measure("findNewlinesScalar", 5, text.size(), [&] {
+      offsets.clear();
+      findNewlinesScalar(text.data(), text.size(), offsets);
+    });
+    
+    benchmark.measure("findNewlines", 5, text.size(), [&] {
+      offsets.clear();
+      findNewlines(text.data(), text.size(), offsets);
+    });
+    
+    benchmark.measure("decompose into rows (find_first_of, substr)", 3, text.size(), [&] {
+      decomposeByFind(text);
+    });
+    
+    benchmark.measure("Document load (piece table index)", 3, text.size(), [&] {
+      Document document(text);
+    });
+  });
+}
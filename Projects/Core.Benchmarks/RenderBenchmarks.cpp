@@ -0,0 +1,205 @@
+#include "Benchmark.hpp"
+
+#include "Color.hpp"
+#include "CTokenizer.hpp"
+#include "DamageTracker.hpp"
+#include "Document.hpp"
+#include "EditContext.hpp"
+#include "InsertTransaction.hpp"
+#include "Mode.hpp"
+#include "RecordingDrawingService.hpp"
+#include "Rectangle.hpp"
+#include "ScriptHost.hpp"
+#include "SelectionDrawInfo.hpp"
+#include "SyntaxHighlighter.hpp"
+#include "ViewportModel.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace quip;
+
+namespace {
+  typedef std::chrono::high_resolution_clock Clock;
+  
+  std::string generateSource(std::size_t rows) {
+    const char* lines[] = {
+      "#include \"Document.hpp\"\n",
+      "  std::size_t Document::rows() const {\n",
+      "    return m_rows.rows(); /* the row count */\n",
+      "  }\n",
+      "\n",
+      "  /* A comment that spans\n",
+      "     several rows. */\n",
+      "#if defined(QUIP_FEATURE)\n",
+    };
+    
+    std::string result;
+    for (std::size_t row = 0; row < rows; ++row) {
+      result += lines[row % (sizeof(lines) / sizeof(lines[0]))];
+    }
+    
+    return result;
+  }
+  
+  // Draws frames of a view the way the text view does, into a recording drawing service.
+  struct Renderer {
+    EditContext& context;
+    const SyntaxHighlighter& highlighter;
+    RecordingDrawingService service;
+    ViewportModel viewport;
+    SelectionDrawInfo overlay;
+    
+    Renderer(EditContext& context, const SyntaxHighlighter& highlighter)
+    : context(context)
+    , highlighter(highlighter)
+    , service(Extent(7.0f, 14.0f)) {
+      viewport.setCellSize(service.cellSize());
+      overlay.primaryColor = Color::green();
+      overlay.secondaryColor = Color::green();
+      overlay.style = CursorStyle::Underline;
+      overlay.flags = CursorFlags::None;
+    }
+    
+    void scrollTo(std::size_t row, std::size_t rows) {
+      float height = viewport.cellSize().height();
+      viewport.setRows(context.document().rows());
+      viewport.setViewport(row * height, rows * height);
+    }
+    
+    // Draw the rows within the given band of the document.
+    void draw(float top, float bottom) {
+      top = std::max(top, viewport.scrollOffset());
+      bottom = std::min(bottom, viewport.scrollOffset() + viewport.height());
+      if (bottom <= top) {
+        return;
+      }
+      
+      Document& document = context.document();
+      float height = viewport.cellSize().height();
+      Rectangle frame(1.0f, 0.0f, 800.0f, height * (document.rows() + 1));
+      viewport.setRows(document.rows());
+      
+      service.clear();
+      service.fillRectangle(Rectangle(0.0f, frame.height() - bottom, frame.width(), bottom - top), Color::white());
+      
+      SelectionDrawInfo drawInfo;
+      drawInfo.primaryColor = Color::blue();
+      drawInfo.secondaryColor = Color::blue();
+      drawInfo.flags = context.mode().cursorFlags();
+      drawInfo.style = context.mode().cursorStyle();
+      drawInfo.selections = context.selections();
+      viewport.drawSelections(service, document, drawInfo, frame, true);
+      viewport.drawSelections(service, document, overlay, frame, true);
+      
+      viewport.drawText(service, document, highlighter, frame, top, bottom);
+    }
+    
+    void drawViewport() {
+      draw(viewport.scrollOffset(), viewport.scrollOffset() + viewport.height());
+    }
+    
+    // Draw only the damaged rows, as the text view invalidates them.
+    void drawDamage() {
+      DamageTracker& tracker = context.damageTracker();
+      tracker.trackSelections(context.selections());
+      
+      float height = viewport.cellSize().height();
+      for (const DamageTracker::Range& range : tracker.ranges()) {
+        float bottom = range.lastRow == DamageTracker::EndOfView ? std::numeric_limits<float>::max() : (range.lastRow + 1.0f) * height;
+        draw(range.firstRow * height, bottom);
+      }
+      
+      tracker.clear();
+    }
+  };
+  
+  // Run a number of frames, reporting the average time and allocations of drawing each. The
+  // work that sets up each frame, such as scrolling or editing the document, isn't measured.
+  void measureFrames(Benchmark& benchmark, const std::string& label, std::size_t frames, const std::function<void (std::size_t)>& prepare, const std::function<void ()>& draw) {
+    std::uint64_t allocations = 0;
+    Clock::duration elapsed = Clock::duration::zero();
+    for (std::size_t index = 0; index < frames; ++index) {
+      prepare(index);
+      
+      std::uint64_t allocated = Benchmark::allocations();
+      Clock::time_point start = Clock::now();
+      draw();
+      elapsed += Clock::now() - start;
+      allocations += Benchmark::allocations() - allocated;
+    }
+    
+    benchmark.report(label + ", per frame", std::chrono::duration<double, std::milli>(elapsed).count() / frames, "ms");
+    benchmark.report(label + ", allocations per frame", static_cast<double>(allocations) / frames, "");
+  }
+  
+  Benchmark benchmark("Render", [] (Benchmark& benchmark) {
+    ScriptHost host(QUIP_BENCHMARK_RUNTIME_PATH);
+    host.addNativePackagePath(QUIP_BENCHMARK_NATIVE_PATH);
+    
+    std::shared_ptr<Document> document = std::make_shared<Document>(generateSource(100000));
+    EditContext context(nullptr, nullptr, &host, document);
+    SyntaxHighlighter highlighter(*document, host);
+    Renderer renderer(context, highlighter);
+    
+    // A window sixty rows tall, with a search overlay matching every eighth row.
+    const std::size_t rows = 60;
+    std::vector<Selection> matches;
+    for (std::size_t row = 0; row < document->rows(); row += 8) {
+      matches.emplace_back(Location(1, row), Location(8, row));
+    }
+    
+    renderer.overlay.selections = SelectionSet(matches);
+    
+    // Highlighting is measured by the syntax benchmarks, so the rows scrolled through are
+    // highlighted up front.
+    const std::size_t scrolledRows = 3 * 2000 + rows;
+    highlighter.setSyntax(host.getSyntax(host.scriptRootPath() + "/syntax/cpp.lua"), std::make_shared<CTokenizer>());
+    highlighter.prepare(0, scrolledRows);
+    highlighter.wait();
+    
+    measureFrames(benchmark, "Scrolling", 2000, [&] (std::size_t frame) {
+      renderer.scrollTo(frame * 3, rows);
+      highlighter.prepare(renderer.viewport.firstVisibleRow(), renderer.viewport.lastVisibleRow());
+      highlighter.poll();
+    }, [&] () {
+      renderer.drawViewport();
+    });
+    
+    benchmark.report("Scrolling, commands per frame", renderer.service.commands().size(), "");
+    
+    // Typing into the middle of the window, drawing either all of it or only what changed.
+    renderer.scrollTo(50000, rows);
+    context.selections().replace(Selection(Location(4, 50030)));
+    context.damageTracker().trackSelections(context.selections());
+    context.damageTracker().clear();
+    
+    measureFrames(benchmark, "Typing, viewport drawn", 1000, [&] (std::size_t frame) {
+      context.damageTracker().clear();
+      context.performTransaction(InsertTransaction::create(context.selections(), "x"));
+    }, [&] () {
+      renderer.drawViewport();
+    });
+    
+    context.damageTracker().clear();
+    measureFrames(benchmark, "Typing, damaged rows drawn", 1000, [&] (std::size_t frame) {
+      context.performTransaction(InsertTransaction::create(context.selections(), "x"));
+    }, [&] () {
+      renderer.drawDamage();
+    });
+    
+    benchmark.report("Typing, commands per damaged frame", renderer.service.commands().size(), "");
+    
+    // Entering new rows moves every row below them, so everything below is drawn again.
+    measureFrames(benchmark, "Entering rows", 200, [&] (std::size_t frame) {
+      context.performTransaction(InsertTransaction::create(context.selections(), "\n"));
+    }, [&] () {
+      renderer.drawDamage();
+    });
+  });
+}
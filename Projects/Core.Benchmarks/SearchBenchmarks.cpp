@@ -0,0 +1,89 @@
+#include "Benchmark.hpp"
+
+#include "Document.hpp"
+#include "SearchEngine.hpp"
+#include "SearchExpression.hpp"
+#include "SelectionSet.hpp"
+
+#include <memory>
+#include <random>
+#include <regex>
+#include <string>
+
+using namespace quip;
+
+namespace {
+  // Rows of identifier-like words, with the searched-for identifier on roughly one row in 500.
+  std::string generateText(std::size_t size) {
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<std::size_t> lengths(1, 12);
+    
+    std::string result;
+    result.reserve(size);
+    for (std::size_t row = 0; result.size() < size; ++row) {
+      for (std::size_t word = 0; word < 6; ++word) {
+        for (std::size_t length = lengths(generator); length > 0; --length) {
+          result += static_cast<char>('a' + generator() % 26);
+        }
+        
+        result += ' ';
+      }
+      
+      result += row % 500 == 0 ? "documentModified\n" : "\n";
+    }
+    
+    return result;
+  }
+  
+  std::size_t countMatches(const SearchEngine& engine, const std::string& text) {
+    std::unique_ptr<SearchEngine::State> state = engine.createState();
+    std::size_t count = 0;
+    SearchMatch match;
+    std::size_t offset = 0;
+    while (offset < text.size() && engine.search(text.data(), text.size(), offset, true, true, *state, match)) {
+      ++count;
+      offset = match.position + match.length;
+    }
+    
+    return count;
+  }
+  
+  Benchmark benchmark("Search", [] (Benchmark& benchmark) {
+    const std::size_t size = 64 * 1024 * 1024;
+    std::string text = generateText(size);
+    Document document(text);
+    
+    benchmark.measure("std::regex, literal", 1, text.size(), [&] {
+      std::regex pattern("documentModified");
+      std::sregex_iterator end;
+      std::size_t count = 0;
+      for (std::sregex_iterator cursor(text.begin(), text.end(), pattern); cursor != end; ++cursor) {
+        ++count;
+      }
+    });
+    
+    SearchExpression literal("documentModified");
+    benchmark.measure("literal engine", 5, text.size(), [&] {
+      countMatches(literal.engine(), text);
+    });
+    
+    SearchExpression ignoringCase("documentmodified", true);
+    benchmark.measure("literal engine, ignoring case", 5, text.size(), [&] {
+      countMatches(ignoringCase.engine(), text);
+    });
+    
+    SearchExpression prefixed("document[A-Z]\\w+");
+    benchmark.measure("automaton engine, literal prefix", 5, text.size(), [&] {
+      countMatches(prefixed.engine(), text);
+    });
+    
+    SearchExpression unprefixed("[dD]ocument[A-Z]\\w+");
+    benchmark.measure("automaton engine, no prefix", 1, text.size(), [&] {
+      countMatches(unprefixed.engine(), text);
+    });
+    
+    benchmark.measure("Document::matches, literal", 5, text.size(), [&] {
+      document.matches(literal);
+    });
+  });
+}
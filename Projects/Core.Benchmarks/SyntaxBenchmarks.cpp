@@ -0,0 +1,149 @@
+#include "Benchmark.hpp"
+
+#include "AttributeArena.hpp"
+#include "AttributeRegistry.hpp"
+#include "CTokenizer.hpp"
+#include "Document.hpp"
+#include "Script.hpp"
+#include "ScriptHost.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace quip;
+
+namespace {
+  // C++-shaped rows, with the occasional preprocessor directive and block comment.
+  std::string generateSource(std::size_t rows) {
+    const char* lines[] = {
+      "#include \"Document.hpp\"\n",
+      "  std::size_t Document::rows() const {\n",
+      "    return m_rows.rows(); /* the row count */\n",
+      "  }\n",
+      "\n",
+      "  /* A comment that spans\n",
+      "     several rows. */\n",
+      "#if defined(QUIP_FEATURE)\n",
+    };
+    
+    std::string result;
+    for (std::size_t row = 0; row < rows; ++row) {
+      result += lines[row % (sizeof(lines) / sizeof(lines[0]))];
+    }
+    
+    return result;
+  }
+  
+  Benchmark benchmark("Syntax", [] (Benchmark& benchmark) {
+    ScriptHost host(QUIP_BENCHMARK_RUNTIME_PATH);
+    host.addNativePackagePath(QUIP_BENCHMARK_NATIVE_PATH);
+    
+    std::string path = host.scriptRootPath() + "/syntax/cpp.lua";
+    Script script = host.getSyntax(path);
+    
+    // A viewport's worth of rows.
+    const std::size_t rows = 200;
+    Document document(generateSource(rows));
+    
+    // Syntax scripts used to be run in their entirety for every row, building their grammar
+    // each time. A module that runs the real one for every row reproduces that.
+    char rebuildingPath[] = "/tmp/QuipSyntaxBenchmarks.XXXXXX";
+    int descriptor = mkstemp(rebuildingPath);
+    std::string rebuildingSource = "return function (line, state) return dofile(\"" + path + "\")(line, state) end\n";
+    write(descriptor, rebuildingSource.data(), rebuildingSource.size());
+    close(descriptor);
+    Script rebuilding = host.getSyntax(rebuildingPath);
+    
+    benchmark.measure("parseSyntax, grammar built per row", 5, [&] {
+      std::string state;
+      std::string endState;
+      for (std::size_t row = 0; row < rows; ++row) {
+        host.parseSyntax(rebuilding, document.row(row), state, endState);
+        state = endState;
+      }
+    });
+    
+    benchmark.measure("parseSyntax, grammar built once", 50, [&] {
+      std::string state;
+      std::string endState;
+      for (std::size_t row = 0; row < rows; ++row) {
+        host.parseSyntax(script, document.row(row), state, endState);
+        state = endState;
+      }
+    });
+    
+    benchmark.measure("parseSyntaxRange, one call per viewport", 50, [&] {
+      std::vector<std::string> endStates;
+      host.parseSyntaxRange(script, document, 0, rows - 1, "", endStates);
+    });
+    
+    CTokenizer tokenizer;
+    benchmark.measure("CTokenizer, one call per viewport", 50, [&] {
+      std::vector<std::string> endStates;
+      tokenizer.tokenizeRange(document, 0, rows - 1, "", endStates);
+    });
+    
+    // A whole file, to compare the native and script throughput.
+    std::string source = generateSource(200000);
+    std::size_t bytes = source.size();
+    Document file(source);
+    
+    benchmark.measure("parseSyntaxRange, whole file", 3, bytes, [&] {
+      std::vector<std::string> endStates;
+      host.parseSyntaxRange(script, file, 0, file.rows() - 1, "", endStates);
+    });
+    
+    benchmark.measure("CTokenizer, whole file", 3, bytes, [&] {
+      std::vector<std::string> endStates;
+      tokenizer.tokenizeRange(file, 0, file.rows() - 1, "", endStates);
+    });
+    
+    // Attributes used to be stored as a vector of ranges for each row, each range carrying a copy
+    // of its attribute's name. The footprint of that layout ignores names too long to be stored
+    // inline, so it is if anything an underestimate.
+    struct NamedRange {
+      std::string name;
+      std::size_t start;
+      std::size_t length;
+    };
+    
+    std::vector<std::string> endStates;
+    std::vector<RowAttributeRange> ranges = tokenizer.tokenizeRange(file, 0, file.rows() - 1, "", endStates);
+    
+    std::vector<std::vector<NamedRange>> namedRows;
+    benchmark.measure("Named ranges per row, whole file", 3, [&] {
+      namedRows = std::vector<std::vector<NamedRange>>(file.rows());
+      for (const RowAttributeRange& range : ranges) {
+        namedRows[range.row].push_back(NamedRange{AttributeRegistry::shared().name(range.attribute), range.start, range.length});
+      }
+    });
+    
+    AttributeArena arena;
+    benchmark.measure("AttributeArena, whole file", 3, [&] {
+      arena = AttributeArena(file.rows());
+      std::vector<RowAttributeRange>::const_iterator first = ranges.cbegin();
+      while (first != ranges.cend()) {
+        std::size_t row = first->row;
+        std::vector<RowAttributeRange>::const_iterator last = std::find_if(first, ranges.cend(), [row] (const RowAttributeRange& range) {
+          return range.row != row;
+        });
+        
+        arena.assign(row, first, last);
+        first = last;
+      }
+    });
+    
+    std::size_t namedBytes = namedRows.capacity() * sizeof(std::vector<NamedRange>);
+    for (const std::vector<NamedRange>& row : namedRows) {
+      namedBytes += row.capacity() * sizeof(NamedRange);
+    }
+    
+    benchmark.report("Named ranges per row, footprint", namedBytes / (1024.0 * 1024.0), "MB");
+    benchmark.report("AttributeArena, footprint", arena.footprint() / (1024.0 * 1024.0), "MB");
+    
+    unlink(rebuildingPath);
+  });
+}
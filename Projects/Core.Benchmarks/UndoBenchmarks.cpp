@@ -0,0 +1,149 @@
+#include "Benchmark.hpp"
+
+#include "Document.hpp"
+#include "EditContext.hpp"
+#include "EraseTransaction.hpp"
+#include "InsertTransaction.hpp"
+#include "Key.hpp"
+#include "Modifiers.hpp"
+#include "ScriptHost.hpp"
+#include "Selection.hpp"
+#include "SelectionSet.hpp"
+#include "UndoLog.hpp"
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace quip;
+
+namespace {
+  std::string generateText(std::size_t rows) {
+    std::string result;
+    for (std::size_t row = 0; row < rows; ++row) {
+      result += "    std::size_t value" + std::to_string(row) + " = compute(row, column);\n";
+    }
+    
+    return result;
+  }
+  
+  // Type a session's worth of keystrokes at the selections, mostly letters, with the occasional
+  // newline and backspace.
+  void type(EditContext& context, std::size_t keystrokes) {
+    std::mt19937 generator(7);
+    for (std::size_t keystroke = 0; keystroke < keystrokes; ++keystroke) {
+      std::size_t choice = generator() % 40;
+      if (choice == 0) {
+        context.performTransaction(InsertTransaction::create(context.selections(), "\n"));
+      } else if (choice < 4) {
+        std::vector<Selection> previous;
+        for (const Selection& selection : context.selections()) {
+          Location origin = selection.origin();
+          previous.emplace_back(origin.column() > 0 ? origin.adjustBy(-1, 0) : origin);
+        }
+        
+        context.performTransaction(EraseTransaction::create(SelectionSet(previous)));
+      } else {
+        context.performTransaction(InsertTransaction::create(context.selections(), std::string(1, 'a' + choice % 26)));
+      }
+    }
+  }
+  
+  void measureSession(Benchmark& benchmark, ScriptHost& host, const std::string& label, std::size_t cursors, std::size_t keystrokes) {
+    std::shared_ptr<Document> document = std::make_shared<Document>(generateText(10000));
+    EditContext context(nullptr, nullptr, &host, document);
+    
+    std::vector<Selection> selections;
+    for (std::size_t cursor = 0; cursor < cursors; ++cursor) {
+      selections.emplace_back(Location(4, 5000 + cursor * 100));
+    }
+    
+    context.selections().replace(SelectionSet(selections));
+    type(context, keystrokes);
+    
+    UndoLog& log = context.undoLog();
+    benchmark.report(label + ", undo history per edit", static_cast<double>(log.footprint()) / log.steps(), "bytes");
+    
+    benchmark.measure(label + ", undo and redo everything", 1, [&] () {
+      while (context.canUndo()) {
+        context.undo();
+      }
+      
+      while (context.canRedo()) {
+        context.redo();
+      }
+    });
+  }
+  
+  Benchmark benchmark("Undo", [] (Benchmark& benchmark) {
+    ScriptHost host(QUIP_BENCHMARK_RUNTIME_PATH);
+    host.addNativePackagePath(QUIP_BENCHMARK_NATIVE_PATH);
+    
+    measureSession(benchmark, host, "Typing", 1, 20000);
+    measureSession(benchmark, host, "Typing with 10 cursors", 10, 20000);
+    
+    // Typing in edit mode coalesces each run of keystrokes into a single step.
+    {
+      std::shared_ptr<Document> document = std::make_shared<Document>(generateText(10000));
+      EditContext context(nullptr, nullptr, &host, document);
+      context.selections().replace(Selection(Location(4, 5000)));
+      context.enterMode("EditMode");
+      
+      std::mt19937 generator(7);
+      const std::size_t keystrokes = 20000;
+      for (std::size_t keystroke = 0; keystroke < keystrokes; ++keystroke) {
+        std::size_t choice = generator() % 40;
+        if (choice == 0) {
+          context.processKeyEvent(Key::Return, Modifiers(), "\n");
+        } else if (choice < 4) {
+          context.processKeyEvent(Key::Delete, Modifiers(), "");
+        } else {
+          context.processKeyEvent(Key::A, Modifiers(), std::string(1, 'a' + choice % 26));
+        }
+      }
+      
+      benchmark.report("Coalesced typing, undo history per keystroke", static_cast<double>(context.undoLog().footprint()) / keystrokes, "bytes");
+      benchmark.report("Coalesced typing, steps", context.undoLog().steps(), "");
+      benchmark.measure("Coalesced typing, undo and redo everything", 1, [&] () {
+        context.undo();
+        context.redo();
+      });
+    }
+    
+    // Travelling back through a long session on a large file restores the nearest checkpoint and
+    // replays a few steps from it, where undoing replays every step in between.
+    {
+      std::shared_ptr<Document> document = std::make_shared<Document>(generateText(200000));
+      EditContext context(nullptr, nullptr, &host, document);
+      context.selections().replace(Selection(Location(4, 100000)));
+      type(context, 100);
+      UndoLog::Clock::time_point time = UndoLog::Clock::now();
+      type(context, 20000);
+      
+      benchmark.measure("Large file, travel back 20000 steps", 1, [&] () {
+        context.travelTo(time);
+      });
+      
+      benchmark.measure("Large file, travel forward 20000 steps", 1, [&] () {
+        context.travelTo(UndoLog::Clock::now());
+      });
+      
+      benchmark.measure("Large file, undo 20000 steps", 1, [&] () {
+        for (std::size_t step = 0; step < 20000; ++step) {
+          context.undo();
+        }
+      });
+    }
+    
+    // A long session within a bounded history keeps only its newest edits.
+    std::shared_ptr<Document> document = std::make_shared<Document>(generateText(10000));
+    EditContext context(nullptr, nullptr, &host, document);
+    context.undoLog().setCapacity(256 * 1024);
+    context.selections().replace(Selection(Location(4, 5000)));
+    type(context, 100000);
+    
+    benchmark.report("Bounded session, history kept", context.undoLog().footprint(), "bytes");
+    benchmark.report("Bounded session, edits kept", context.undoLog().steps(), "");
+  });
+}
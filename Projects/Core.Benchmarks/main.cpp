@@ -0,0 +1,6 @@
+#include "Benchmark.hpp"
+
+int main(int argc, char** argv) {
+  // An optional argument restricts the run to benchmarks whose name contains it.
+  return quip::Benchmark::runAll(argc > 1 ? argv[1] : "");
+}
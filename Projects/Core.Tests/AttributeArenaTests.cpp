@@ -0,0 +1,132 @@
+#include "catch.hpp"
+
+#include "AttributeArena.hpp"
+#include "AttributeRegistry.hpp"
+#include "DocumentChange.hpp"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace quip;
+
+namespace {
+  // A run of the given number of ranges, each naming its row and position within it.
+  std::vector<AttributeRange> makeRanges(std::size_t row, std::size_t count) {
+    std::vector<AttributeRange> ranges;
+    for (std::size_t index = 0; index < count; ++index) {
+      ranges.emplace_back(static_cast<AttributeId>(row), index, index + 1);
+    }
+    
+    return ranges;
+  }
+  
+  bool matches(AttributeSpan span, const std::vector<AttributeRange>& ranges) {
+    if (span.size() != ranges.size()) {
+      return false;
+    }
+    
+    for (std::size_t index = 0; index < ranges.size(); ++index) {
+      if (span[index].attribute != ranges[index].attribute || span[index].start != ranges[index].start || span[index].length != ranges[index].length) {
+        return false;
+      }
+    }
+    
+    return true;
+  }
+}
+
+TEST_CASE("Attribute registries give each name one ID.", "[AttributeArenaTests]") {
+  AttributeRegistry& registry = AttributeRegistry::shared();
+  
+  AttributeId comment = registry.intern("AttributeArenaTests.Comment");
+  AttributeId keyword = registry.intern(std::string("AttributeArenaTests.Keyword"));
+  REQUIRE(comment != keyword);
+  REQUIRE(registry.intern("AttributeArenaTests.Comment") == comment);
+  REQUIRE(registry.intern("AttributeArenaTests.Keyword.Other", 27) == keyword);
+  
+  REQUIRE(registry.name(comment) == "AttributeArenaTests.Comment");
+  REQUIRE(comment < registry.count());
+  REQUIRE(registry.name(static_cast<AttributeId>(registry.count())).empty());
+}
+
+TEST_CASE("Attribute arenas start with empty rows.", "[AttributeArenaTests]") {
+  AttributeArena arena(10);
+  
+  REQUIRE(arena.rows() == 10);
+  for (std::size_t row = 0; row < arena.rows(); ++row) {
+    REQUIRE(arena.attributes(row).empty());
+  }
+}
+
+TEST_CASE("Attribute arenas replace the ranges of a row.", "[AttributeArenaTests]") {
+  AttributeArena arena(3);
+  
+  std::vector<AttributeRange> three = makeRanges(1, 3);
+  arena.assign(1, three.begin(), three.end());
+  REQUIRE(matches(arena.attributes(1), three));
+  REQUIRE(arena.attributes(0).empty());
+  REQUIRE(arena.attributes(2).empty());
+  
+  // Fewer ranges take the place of the old ones.
+  const AttributeRange* first = arena.attributes(1).begin();
+  std::vector<AttributeRange> two = makeRanges(7, 2);
+  arena.assign(1, two.begin(), two.end());
+  REQUIRE(matches(arena.attributes(1), two));
+  REQUIRE(arena.attributes(1).begin() == first);
+  
+  std::vector<AttributeRange> four = makeRanges(8, 4);
+  arena.assign(1, four.begin(), four.end());
+  REQUIRE(matches(arena.attributes(1), four));
+  
+  arena.clear(1);
+  REQUIRE(arena.attributes(1).empty());
+}
+
+TEST_CASE("Attribute arenas follow modifications of a document.", "[AttributeArenaTests]") {
+  AttributeArena arena(5);
+  for (std::size_t row = 0; row < arena.rows(); ++row) {
+    std::vector<AttributeRange> ranges = makeRanges(row, 2);
+    arena.assign(row, ranges.begin(), ranges.end());
+  }
+  
+  // Row 1 was edited and two rows inserted after it.
+  arena.apply(DocumentChange(1, 1, 3));
+  REQUIRE(arena.rows() == 7);
+  REQUIRE(matches(arena.attributes(0), makeRanges(0, 2)));
+  REQUIRE(arena.attributes(1).empty());
+  REQUIRE(arena.attributes(2).empty());
+  REQUIRE(arena.attributes(3).empty());
+  REQUIRE(matches(arena.attributes(4), makeRanges(2, 2)));
+  REQUIRE(matches(arena.attributes(6), makeRanges(4, 2)));
+  
+  // Rows 3 through 5 were joined into one.
+  arena.apply(DocumentChange(3, 3, 1));
+  REQUIRE(arena.rows() == 5);
+  REQUIRE(arena.attributes(3).empty());
+  REQUIRE(matches(arena.attributes(4), makeRanges(4, 2)));
+}
+
+TEST_CASE("Attribute arenas reclaim abandoned ranges.", "[AttributeArenaTests]") {
+  const std::size_t rows = 500;
+  AttributeArena arena(rows);
+  std::vector<std::size_t> counts(rows, 0);
+  
+  // Growing rows keep abandoning their old ranges; the arena must not grow without bound.
+  std::mt19937 generator(17);
+  std::size_t largest = 0;
+  for (std::size_t pass = 0; pass < 20000; ++pass) {
+    std::size_t row = generator() % rows;
+    counts[row] = counts[row] % 16 + 1;
+    std::vector<AttributeRange> ranges = makeRanges(row, counts[row]);
+    arena.assign(row, ranges.begin(), ranges.end());
+    largest = std::max(largest, arena.footprint());
+  }
+  
+  for (std::size_t row = 0; row < rows; ++row) {
+    REQUIRE(matches(arena.attributes(row), makeRanges(row, counts[row])));
+  }
+  
+  REQUIRE(largest < 16 * rows * sizeof(AttributeRange) * 4);
+}
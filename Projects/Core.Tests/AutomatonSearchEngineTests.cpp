@@ -0,0 +1,146 @@
+#include "catch.hpp"
+
+#include "AutomatonSearchEngine.hpp"
+
+#include <memory>
+#include <random>
+#include <regex>
+
+using namespace quip;
+
+namespace {
+  typedef std::pair<std::size_t, std::size_t> Range;
+  
+  // Every search reuses the same state, which is left with threads still running whenever a
+  // match is found.
+  std::vector<Range> findAll(const SearchEngine& engine, const std::string& text) {
+    std::unique_ptr<SearchEngine::State> state = engine.createState();
+    std::vector<Range> results;
+    SearchMatch match;
+    std::size_t offset = 0;
+    while (offset < text.size() && engine.search(text.data(), text.size(), offset, true, true, *state, match)) {
+      results.emplace_back(match.position, match.length);
+      offset = match.position + match.length;
+    }
+    
+    return results;
+  }
+  
+  std::vector<Range> findAllWithRegex(const std::string& expression, const std::string& text, bool ignoresCase) {
+    std::vector<Range> results;
+    std::regex pattern(expression, ignoresCase ? std::regex::ECMAScript | std::regex::icase : std::regex::ECMAScript);
+    std::sregex_iterator end;
+    for (std::sregex_iterator cursor(text.begin(), text.end(), pattern, std::regex_constants::match_not_null); cursor != end; ++cursor) {
+      results.emplace_back(cursor->position(), cursor->length());
+    }
+    
+    return results;
+  }
+}
+
+TEST_CASE("Automaton search engines find literal text.", "[AutomatonSearchEngineTests]") {
+  std::shared_ptr<AutomatonSearchEngine> engine = AutomatonSearchEngine::create("foo", false);
+  REQUIRE(engine != nullptr);
+  
+  std::vector<Range> results = findAll(*engine, "a foo and a foo");
+  REQUIRE(results.size() == 2);
+  REQUIRE((results[0] == Range(2, 3)));
+  REQUIRE((results[1] == Range(12, 3)));
+}
+
+TEST_CASE("Automaton search engines prefer earlier alternatives and greedy repetition.", "[AutomatonSearchEngineTests]") {
+  std::shared_ptr<AutomatonSearchEngine> engine = AutomatonSearchEngine::create("a|ab|a+?b*", false);
+  REQUIRE(engine != nullptr);
+  
+  std::vector<Range> results = findAll(*engine, "abb");
+  REQUIRE(results.size() == 1);
+  REQUIRE((results[0] == Range(0, 1)));
+}
+
+TEST_CASE("Automaton search engines only match anchors at the edges of the document.", "[AutomatonSearchEngineTests]") {
+  std::shared_ptr<AutomatonSearchEngine> engine = AutomatonSearchEngine::create("^a|a$", false);
+  REQUIRE(engine != nullptr);
+  
+  SearchMatch match;
+  std::string text = "aba";
+  REQUIRE(engine->search(text.data(), text.size(), 0, true, false, match));
+  REQUIRE(match.position == 0);
+  REQUIRE_FALSE(engine->search(text.data(), text.size(), 1, true, false, match));
+  REQUIRE(engine->search(text.data(), text.size(), 1, true, true, match));
+  REQUIRE(match.position == 2);
+}
+
+TEST_CASE("Automaton search engines bound the rows their matches can span.", "[AutomatonSearchEngineTests]") {
+  REQUIRE(AutomatonSearchEngine::create("foo.*bar", false)->maximumNewlines() == 0);
+  REQUIRE(AutomatonSearchEngine::create("[^\\n]+\\b", false)->maximumNewlines() == 0);
+  REQUIRE(AutomatonSearchEngine::create("a\\n(b|\\n\\n)c", false)->maximumNewlines() == 3);
+  REQUIRE(AutomatonSearchEngine::create("(\\s\\S){2,4}", false)->maximumNewlines() == 4);
+  REQUIRE(AutomatonSearchEngine::create("a\\s+b", false)->maximumNewlines() == SearchEngine::UnboundedNewlines);
+  REQUIRE(AutomatonSearchEngine::create("a[^z]*b", false)->maximumNewlines() == SearchEngine::UnboundedNewlines);
+}
+
+TEST_CASE("Automaton search engines reject unsupported syntax.", "[AutomatonSearchEngineTests]") {
+  REQUIRE(AutomatonSearchEngine::create("(a)\\1", false) == nullptr);
+  REQUIRE(AutomatonSearchEngine::create("a(?=b)", false) == nullptr);
+  REQUIRE(AutomatonSearchEngine::create("[a-z", false) == nullptr);
+  REQUIRE(AutomatonSearchEngine::create("a**", false) == nullptr);
+  REQUIRE(AutomatonSearchEngine::create("a{2,1}", false) == nullptr);
+  REQUIRE(AutomatonSearchEngine::create("\\", false) == nullptr);
+}
+
+TEST_CASE("Automaton search engines run in linear time on pathological expressions.", "[AutomatonSearchEngineTests]") {
+  std::string text(100000, 'a');
+  std::vector<std::string> expressions({ "(a*)*b", "(a|a)*b", "(a|aa)*c", "(a?){30}a{30}b" });
+  for (const std::string& expression : expressions) {
+    std::shared_ptr<AutomatonSearchEngine> engine = AutomatonSearchEngine::create(expression, false);
+    REQUIRE(engine != nullptr);
+    
+    SearchMatch match;
+    REQUIRE_FALSE(engine->search(text.data(), text.size(), 0, true, true, match));
+  }
+}
+
+TEST_CASE("Automaton search engines match the same text as std::regex.", "[AutomatonSearchEngineTests]") {
+  std::vector<std::string> expressions({
+    "a", "ab", "a|b", "a*", "a+b", "a*?b", "(ab)+", "(?:a|b)*c", "[ab]+", "[^a\\n]+", "a{2}", "a{1,3}",
+    "a{2,}b", "a{1,3}?", ".", ".+", "\\w+", "\\W", "\\d+", "\\s+", "\\S+", "\\ba", "a\\b", "\\Bb",
+    "^a", "b$", "^", "(a|ab)(c|bcd)", "(a*)+", "(a|)+b", "[a-c]{2,3}", "\\x61", "\\n[ab]", "a.?c",
+    "(a|ab)*c", "a{0,2}?b", "[\\d_]+", "[-a]+", "[a-]", "\\.", "[^\\s]\\s"
+  });
+  
+  std::mt19937 generator(42);
+  for (std::size_t iteration = 0; iteration < 200; ++iteration) {
+    std::string text;
+    std::size_t size = generator() % 30;
+    for (std::size_t index = 0; index < size; ++index) {
+      text += "abcd_1 \n"[generator() % 8];
+    }
+    
+    for (const std::string& expression : expressions) {
+      INFO("Searching \"" << text << "\" for \"" << expression << "\"");
+      std::shared_ptr<AutomatonSearchEngine> engine = AutomatonSearchEngine::create(expression, false);
+      REQUIRE(engine != nullptr);
+      REQUIRE(findAll(*engine, text) == findAllWithRegex(expression, text, false));
+    }
+  }
+}
+
+TEST_CASE("Automaton search engines match the same text as std::regex when ignoring case.", "[AutomatonSearchEngineTests]") {
+  std::vector<std::string> expressions({ "a", "ab+", "[a-b]+", "[^a]", "A|b", "\\w+B", "ab.*C" });
+  
+  std::mt19937 generator(42);
+  for (std::size_t iteration = 0; iteration < 200; ++iteration) {
+    std::string text;
+    std::size_t size = generator() % 30;
+    for (std::size_t index = 0; index < size; ++index) {
+      text += "abcABC_ \n"[generator() % 9];
+    }
+    
+    for (const std::string& expression : expressions) {
+      INFO("Searching \"" << text << "\" for \"" << expression << "\"");
+      std::shared_ptr<AutomatonSearchEngine> engine = AutomatonSearchEngine::create(expression, true);
+      REQUIRE(engine != nullptr);
+      REQUIRE(findAll(*engine, text) == findAllWithRegex(expression, text, true));
+    }
+  }
+}
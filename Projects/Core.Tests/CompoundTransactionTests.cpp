@@ -0,0 +1,148 @@
+#include "catch.hpp"
+
+#include "ChangeType.hpp"
+#include "CompoundTransaction.hpp"
+#include "Document.hpp"
+#include "DocumentChange.hpp"
+#include "EditContext.hpp"
+#include "EraseTransaction.hpp"
+#include "InsertTransaction.hpp"
+#include "Key.hpp"
+#include "Modifiers.hpp"
+#include "Selection.hpp"
+#include "SelectionSet.hpp"
+#include "TestScriptHost.hpp"
+#include "UndoLog.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace quip;
+
+TEST_CASE("Compound transactions are performed as a single step.", "[CompoundTransactionTests]") {
+  TestScriptHost host;
+  std::shared_ptr<Document> document = std::make_shared<Document>("abc\ndef\nghi\n");
+  EditContext context(nullptr, nullptr, &host, document);
+  
+  std::vector<DocumentChange> changes;
+  document->onDocumentModified().connect([&changes] (const DocumentChange& change) {
+    changes.push_back(change);
+  });
+  
+  std::size_t applied = 0;
+  context.onTransactionApplied().connect([&applied] (ChangeType) {
+    ++applied;
+  });
+  
+  context.selections().replace(Selection(Location(1, 0)));
+  context.performTransaction(CompoundTransaction::create({
+    EraseTransaction::create(SelectionSet(Selection(Location(1, 0)))),
+    InsertTransaction::create(SelectionSet(Selection(Location(0, 2))), "x\n"),
+    InsertTransaction::create(SelectionSet(Selection(Location(3, 1))), "y")
+  }));
+  
+  REQUIRE(document->contents() == "ac\ndefy\nx\nghi\n");
+  REQUIRE(changes.size() == 1);
+  REQUIRE(changes[0].firstRow == 0);
+  REQUIRE(changes[0].removedRows == 3);
+  REQUIRE(changes[0].insertedRows == 4);
+  REQUIRE(applied == 1);
+  REQUIRE(context.undoLog().steps() == 1);
+  
+  context.undo();
+  REQUIRE(document->contents() == "abc\ndef\nghi\n");
+  REQUIRE(context.selections()[0] == Selection(Location(1, 0)));
+  REQUIRE_FALSE(context.canUndo());
+  
+  context.redo();
+  REQUIRE(document->contents() == "ac\ndefy\nx\nghi\n");
+}
+
+TEST_CASE("Edit contexts group the transactions of a batch into one step.", "[CompoundTransactionTests]") {
+  TestScriptHost host;
+  std::shared_ptr<Document> document = std::make_shared<Document>("abc\ndef\n");
+  EditContext context(nullptr, nullptr, &host, document);
+  
+  std::size_t modified = 0;
+  document->onDocumentModified().connect([&modified] (const DocumentChange&) {
+    ++modified;
+  });
+  
+  std::size_t applied = 0;
+  context.onTransactionApplied().connect([&applied] (ChangeType) {
+    ++applied;
+  });
+  
+  context.performTransaction(InsertTransaction::create(SelectionSet(Selection(Location(0, 0))), "1"));
+  
+  context.beginBatch();
+  context.performTransaction(InsertTransaction::create(SelectionSet(Selection(Location(0, 1))), "2"));
+  
+  context.beginBatch();
+  context.coalesceTransaction(InsertTransaction::create(SelectionSet(Selection(Location(4, 1))), "3"));
+  context.coalesceTransaction(InsertTransaction::create(SelectionSet(Selection(Location(5, 1))), "4"));
+  context.endBatch();
+  
+  REQUIRE(modified == 1);
+  REQUIRE(applied == 1);
+  REQUIRE_FALSE(context.canUndo());
+  
+  context.performTransaction(EraseTransaction::create(SelectionSet(Selection(Location(0, 0)))));
+  context.endBatch();
+  
+  REQUIRE(document->contents() == "abc\n2def34\n");
+  REQUIRE(modified == 2);
+  REQUIRE(applied == 2);
+  REQUIRE(context.undoLog().steps() == 2);
+  
+  // Typing after the batch starts a step of its own.
+  context.coalesceTransaction(InsertTransaction::create(context.selections(), "5"));
+  REQUIRE(context.undoLog().steps() == 3);
+  
+  context.undo();
+  context.undo();
+  REQUIRE(document->contents() == "1abc\ndef\n");
+  
+  // A batch that performs nothing leaves no step behind, and reports nothing.
+  context.beginBatch();
+  context.endBatch();
+  REQUIRE(context.undoLog().steps() == 3);
+  REQUIRE(applied == 5);
+}
+
+TEST_CASE("Shifting the indentation of several rows is a single step.", "[CompoundTransactionTests]") {
+  TestScriptHost host;
+  std::shared_ptr<Document> document = std::make_shared<Document>("abc\ndef\nghi\n");
+  EditContext context(nullptr, nullptr, &host, document);
+  
+  std::size_t modified = 0;
+  document->onDocumentModified().connect([&modified] (const DocumentChange&) {
+    ++modified;
+  });
+  
+  Modifiers shift;
+  shift.shift = true;
+  
+  context.selections().replace(SelectionSet(std::vector<Selection>({ Selection(Location(1, 0)), Selection(Location(2, 2)) })));
+  context.processKeyEvent(Key::Period, shift, ">");
+  REQUIRE(document->contents() == "  abc\ndef\n  ghi\n");
+  REQUIRE(context.selections()[0] == Selection(Location(3, 0)));
+  REQUIRE(context.selections()[1] == Selection(Location(4, 2)));
+  REQUIRE(modified == 1);
+  REQUIRE(context.undoLog().steps() == 1);
+  
+  context.processKeyEvent(Key::Comma, shift, "<");
+  REQUIRE(document->contents() == "abc\ndef\nghi\n");
+  REQUIRE(modified == 2);
+  REQUIRE(context.undoLog().steps() == 2);
+  
+  context.undo();
+  REQUIRE(document->contents() == "  abc\ndef\n  ghi\n");
+  REQUIRE(context.selections()[0] == Selection(Location(3, 0)));
+  
+  context.undo();
+  REQUIRE(document->contents() == "abc\ndef\nghi\n");
+  REQUIRE(context.selections()[0] == Selection(Location(1, 0)));
+  REQUIRE_FALSE(context.canUndo());
+}
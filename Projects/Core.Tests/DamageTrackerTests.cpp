@@ -0,0 +1,147 @@
+#include "catch.hpp"
+
+#include "DamageTracker.hpp"
+#include "Document.hpp"
+#include "EditContext.hpp"
+#include "InsertTransaction.hpp"
+#include "Selection.hpp"
+#include "SelectionSet.hpp"
+#include "TestScriptHost.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace quip;
+
+namespace {
+  // Describe the damaged rows as "first-last", with "end" for the end of the view.
+  std::vector<std::string> describe(const DamageTracker& tracker) {
+    std::vector<std::string> result;
+    for (const DamageTracker::Range& range : tracker.ranges()) {
+      std::string last = range.lastRow == DamageTracker::EndOfView ? "end" : std::to_string(range.lastRow);
+      result.emplace_back(std::to_string(range.firstRow) + "-" + last);
+    }
+    
+    return result;
+  }
+  
+  std::string makeText(std::size_t rows) {
+    std::string text;
+    for (std::size_t row = 0; row < rows; ++row) {
+      text += "row " + std::to_string(row) + "\n";
+    }
+    
+    return text;
+  }
+}
+
+TEST_CASE("Damage trackers merge the rows they're given.", "[DamageTrackerTests]") {
+  Document document(makeText(100));
+  DamageTracker tracker(document);
+  REQUIRE_FALSE(tracker.isDamaged());
+  
+  tracker.damageRows(10, 12);
+  tracker.damageRows(2, 3);
+  tracker.damageRows(20, 20);
+  REQUIRE(describe(tracker) == std::vector<std::string>({"2-3", "10-12", "20-20"}));
+  
+  // Adjacent and overlapping ranges are merged.
+  tracker.damageRows(4, 5);
+  tracker.damageRows(11, 19);
+  REQUIRE(describe(tracker) == std::vector<std::string>({"2-5", "10-20"}));
+  
+  tracker.damageRows(15, DamageTracker::EndOfView);
+  REQUIRE(describe(tracker) == std::vector<std::string>({"2-5", "10-end"}));
+  
+  tracker.damageRows(30, 40);
+  REQUIRE(describe(tracker) == std::vector<std::string>({"2-5", "10-end"}));
+  
+  tracker.clear();
+  REQUIRE_FALSE(tracker.isDamaged());
+  
+  tracker.damageAll();
+  REQUIRE(describe(tracker) == std::vector<std::string>({"0-end"}));
+}
+
+TEST_CASE("Damage trackers damage the rows a modification replaced.", "[DamageTrackerTests]") {
+  Document document(makeText(100));
+  DamageTracker tracker(document);
+  
+  document.insert(Selection(Location(0, 10)), "x");
+  document.erase(Selection(Location(0, 20), Location(2, 20)));
+  REQUIRE(describe(tracker) == std::vector<std::string>({"10-10", "20-20"}));
+  REQUIRE_FALSE(tracker.hasShiftedRows());
+}
+
+TEST_CASE("Damage trackers damage every row that moved.", "[DamageTrackerTests]") {
+  Document document(makeText(100));
+  DamageTracker tracker(document);
+  
+  tracker.damageRows(5, 5);
+  tracker.damageRows(50, 60);
+  document.insert(Selection(Location(0, 30)), "x\ny\n");
+  REQUIRE(describe(tracker) == std::vector<std::string>({"5-5", "30-end"}));
+  REQUIRE(tracker.hasShiftedRows());
+  
+  tracker.clear();
+  document.erase(Selection(Location(0, 70), Location(0, 72)));
+  REQUIRE(describe(tracker) == std::vector<std::string>({"70-end"}));
+  REQUIRE(tracker.hasShiftedRows());
+}
+
+TEST_CASE("Damage trackers damage the rows of selections that changed.", "[DamageTrackerTests]") {
+  Document document(makeText(100));
+  DamageTracker tracker(document);
+  
+  SelectionSet selections(std::vector<Selection>({Selection(Location(0, 3)), Selection(Location(0, 8), Location(2, 10))}));
+  tracker.trackSelections(selections);
+  REQUIRE(describe(tracker) == std::vector<std::string>({"3-3", "8-10"}));
+  
+  // Tracking the same selections again damages nothing.
+  tracker.clear();
+  tracker.trackSelections(selections);
+  REQUIRE_FALSE(tracker.isDamaged());
+  
+  // Both where the selections were and where they are now need to be drawn.
+  selections.replace(Selection(Location(1, 40)));
+  tracker.trackSelections(selections);
+  REQUIRE(describe(tracker) == std::vector<std::string>({"3-3", "8-10", "40-40"}));
+}
+
+TEST_CASE("Edit contexts damage the rows their transactions change.", "[DamageTrackerTests]") {
+  TestScriptHost host;
+  std::shared_ptr<Document> document = std::make_shared<Document>(makeText(100));
+  EditContext context(nullptr, nullptr, &host, document);
+  DamageTracker& tracker = context.damageTracker();
+  
+  context.selections().replace(Selection(Location(0, 40)));
+  tracker.trackSelections(context.selections());
+  tracker.clear();
+  
+  // The cursor moves along the row as text is inserted into it.
+  context.performTransaction(InsertTransaction::create(context.selections(), "abc"));
+  REQUIRE(describe(tracker) == std::vector<std::string>({"40-40"}));
+  REQUIRE_FALSE(tracker.hasShiftedRows());
+  
+  tracker.clear();
+  context.performTransaction(InsertTransaction::create(SelectionSet(Selection(Location(0, 50))), "x\n"));
+  REQUIRE(describe(tracker) == std::vector<std::string>({"40-40", "50-end"}));
+  
+  tracker.clear();
+  context.undo();
+  REQUIRE(describe(tracker) == std::vector<std::string>({"40-40", "50-end"}));
+  REQUIRE(tracker.hasShiftedRows());
+  
+  // Overlays damage the rows they cover, both when they're set and when they're cleared.
+  tracker.clear();
+  SelectionDrawInfo overlay;
+  overlay.flags = CursorFlags::None;
+  overlay.style = CursorStyle::VerticalBlock;
+  overlay.selections = SelectionSet(Selection(Location(0, 70), Location(0, 71)));
+  context.setOverlay("search", overlay);
+  REQUIRE(describe(tracker) == std::vector<std::string>({"70-71"}));
+  
+  tracker.clear();
+  context.clearOverlay("search");
+  REQUIRE(describe(tracker) == std::vector<std::string>({"70-71"}));
+}
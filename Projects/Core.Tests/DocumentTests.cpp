@@ -2,11 +2,139 @@
 
 #include "Document.hpp"
 #include "DocumentIterator.hpp"
+#include "SearchExpression.hpp"
 #include "Selection.hpp"
 #include "SelectionSet.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <regex>
+#include <thread>
+#include <unistd.h>
+
 using namespace quip;
 
+namespace {
+  std::string writeTemporaryFile(const std::string& contents) {
+    char path[] = "/tmp/QuipDocumentTests.XXXXXX";
+    int descriptor = mkstemp(path);
+    write(descriptor, contents.data(), contents.size());
+    close(descriptor);
+    return path;
+  }
+  
+  std::vector<std::string> splitRows(const std::string& text) {
+    std::vector<std::string> rows;
+    std::size_t start = 0;
+    while (start < text.size()) {
+      std::size_t newline = text.find('\n', start);
+      std::size_t end = newline == std::string::npos ? text.size() : newline + 1;
+      rows.emplace_back(text, start, end - start);
+      start = end;
+    }
+    
+    return rows;
+  }
+  
+  // The original erase algorithm, which replaces the rows of one selection at a time and
+  // shifts each subsequent selection to account for the rows and columns already removed.
+  // Used as a reference for the single-pass implementation.
+  //
+  // When a selection of more than one character ends with a newline, a selection on the next
+  // row is shifted by the extent's column rather than the origin's, so the reference is only
+  // consulted for selections that aren't arranged that way.
+  std::vector<Selection> referenceErase(std::vector<std::string>& rows, const SelectionSet& selections) {
+    std::vector<Selection> updated;
+    std::int64_t columnShift = 0;
+    std::int64_t rowShift = 0;
+    for (std::uint64_t index = 0; index < selections.count(); ++index) {
+      const Selection& selection = selections[index];
+      Location origin = selection.origin().adjustBy(columnShift, rowShift);
+      Location extent = selection.extent().adjustBy(selection.height() == 1 ? columnShift : 0, rowShift);
+      std::int64_t rowsToRemove = extent.row() - origin.row();
+      
+      bool hasLastCharacterInRow = extent.column() == rows[extent.row()].size() - 1;
+      bool hasLastRowInDocument = extent.row() == rows.size() - 1;
+      
+      std::string prefix = rows[origin.row()].substr(0, origin.column());
+      std::string suffix;
+      if (hasLastCharacterInRow && !hasLastRowInDocument) {
+        suffix = rows[extent.row() + 1];
+        ++rowsToRemove;
+      } else {
+        suffix = rows[extent.row()].substr(extent.column() + 1);
+      }
+      
+      rowShift -= rowsToRemove;
+      if (rowsToRemove > 0) {
+        columnShift = 0;
+      }
+      
+      if (index + 1 < selections.count()) {
+        const Selection& next = selections[index + 1];
+        bool hasSameLine = selection.extent().row() == next.origin().row();
+        bool hasNextLine = selection.extent().row() == next.origin().row() - 1;
+        if (hasSameLine) {
+          columnShift -= extent.column() - origin.column() + 1;
+        } else if (hasNextLine && hasLastCharacterInRow) {
+          columnShift = extent.column();
+        } else {
+          columnShift = 0;
+        }
+      }
+      
+      rows.erase(rows.begin() + origin.row(), rows.begin() + origin.row() + rowsToRemove + 1);
+      rows.insert(rows.begin() + origin.row(), prefix + suffix);
+      
+      std::size_t last = rows.size() - 1;
+      if (origin <= Location(rows[last].size() - 1, last)) {
+        updated.emplace_back(origin);
+      } else if (origin.column() > 0) {
+        updated.emplace_back(origin.adjustBy(-1, 0));
+      } else if (origin.row() > 0) {
+        std::uint64_t row = origin.row() - 1;
+        updated.emplace_back(Location(rows[row].size() - 1, row));
+      } else {
+        updated.emplace_back(Location(0, 0));
+      }
+    }
+    
+    if (rows.size() == 1 && rows[0].empty()) {
+      rows.clear();
+    }
+    
+    return updated;
+  }
+  
+  Location locationOfPosition(const std::vector<std::string>& rows, std::size_t position) {
+    std::size_t row = 0;
+    while (position >= rows[row].size()) {
+      position -= rows[row].size();
+      ++row;
+    }
+    
+    return Location(position, row);
+  }
+  
+  // Find matches by searching the entire contents of a document at once.
+  std::vector<Selection> referenceMatches(const std::string& text, const std::string& expression) {
+    std::vector<std::string> rows = splitRows(text);
+    std::vector<Selection> results;
+    std::regex pattern(expression);
+    std::sregex_iterator end;
+    for (std::sregex_iterator cursor(text.begin(), text.end(), pattern); cursor != end; ++cursor) {
+      std::size_t position = cursor->position();
+      results.emplace_back(locationOfPosition(rows, position), locationOfPosition(rows, position + cursor->length() - 1));
+    }
+    
+    return results;
+  }
+}
+
 TEST_CASE("Default-construct a document.", "Document") {
   Document document;
   
@@ -250,6 +378,60 @@ TEST_CASE("Insert text with internal newlines via a single selection.", "Documen
   REQUIRE(result.primary().origin() == Location(2, 2));
 }
 
+TEST_CASE("Insert text with newlines via multiple selections on the same row.", "Document") {
+  Document document("ACE\n");
+  SelectionSet selections({
+    Selection(Location(1, 0)),
+    Selection(Location(2, 0))
+  });
+  SelectionSet result = document.insert(selections, "\nB");
+  
+  REQUIRE(document.rows() == 3);
+  REQUIRE(document.row(0) == "A\n");
+  REQUIRE(document.row(1) == "BC\n");
+  REQUIRE(document.row(2) == "BE\n");
+  REQUIRE(result.count() == 2);
+  REQUIRE(result[0].origin() == Location(1, 1));
+  REQUIRE(result[1].origin() == Location(1, 2));
+}
+
+TEST_CASE("Insert text via a selection on every row.", "Document") {
+  std::string contents;
+  std::vector<Selection> selections;
+  for (std::size_t row = 0; row < 5000; ++row) {
+    contents += "AC\n";
+    selections.emplace_back(Location(1, row));
+  }
+  
+  Document document(contents);
+  SelectionSet result = document.insert(SelectionSet(selections), "B");
+  
+  REQUIRE(document.rows() == 5000);
+  REQUIRE(document.row(0) == "ABC\n");
+  REQUIRE(document.row(4999) == "ABC\n");
+  REQUIRE(document.contents().size() == 5000 * 4);
+  REQUIRE(result.count() == 5000);
+  REQUIRE(result[4999].origin() == Location(2, 4999));
+}
+
+TEST_CASE("Insert text past the last row.", "Document") {
+  Document document("AB\nCD\n");
+  std::vector<DocumentChange> changes;
+  document.onDocumentModified().connect([&changes] (const DocumentChange& change) {
+    changes.push_back(change);
+  });
+  
+  SelectionSet result = document.insert(Selection(Location(0, 2)), "EF");
+  
+  REQUIRE(document.rows() == 3);
+  REQUIRE(document.contents() == "AB\nCD\nEF");
+  REQUIRE(result.primary().origin() == Location(2, 2));
+  REQUIRE(changes.size() == 1);
+  REQUIRE(changes[0].firstRow == 2);
+  REQUIRE(changes[0].removedRows == 0);
+  REQUIRE(changes[0].insertedRows == 1);
+}
+
 TEST_CASE("Erase text when empty.", "Document") {
   Document document;
   Selection selection(Location(0, 0));
@@ -409,3 +591,437 @@ TEST_CASE("Erase the last character of the document.", "Document") {
   REQUIRE(document.rows() == 0);
   REQUIRE(result.primary().origin() == Location(0, 0));
 }
+
+TEST_CASE("Erase text via multiple selections matches the reference implementation.", "Document") {
+  std::mt19937 generator(1234);
+  for (std::size_t iteration = 0; iteration < 3500; ++iteration) {
+    std::string text;
+    std::size_t size = 1 + generator() % 40;
+    for (std::size_t index = 0; index < size; ++index) {
+      text += "ab\n"[generator() % 3];
+    }
+    
+    std::vector<std::string> rows = splitRows(text);
+    std::vector<Selection> selections;
+    std::size_t position = generator() % 4;
+    bool isMisshifted = false;
+    while (position < text.size()) {
+      std::size_t last = std::min(text.size() - 1, position + generator() % 5);
+      if (!selections.empty()) {
+        const Selection& previous = selections.back();
+        bool hasNewline = previous.extent().column() == rows[previous.extent().row()].size() - 1;
+        bool hasNextRow = previous.extent().row() + 1 == locationOfPosition(rows, position).row();
+        isMisshifted = isMisshifted || (hasNewline && hasNextRow && !(previous.origin() == previous.extent()));
+      }
+      
+      selections.emplace_back(locationOfPosition(rows, position), locationOfPosition(rows, last));
+      position = last + 1 + generator() % 4;
+    }
+    
+    if (selections.empty() || isMisshifted) {
+      continue;
+    }
+    
+    SelectionSet set(selections);
+    Document document(text);
+    SelectionSet result = document.erase(set);
+    SelectionSet expected(referenceErase(rows, set));
+    
+    INFO("Erasing from \"" << text << "\"");
+    REQUIRE(document.rows() == rows.size());
+    for (std::size_t row = 0; row < rows.size(); ++row) {
+      REQUIRE(document.row(row) == rows[row]);
+    }
+    
+    REQUIRE(result.count() == expected.count());
+    for (std::size_t index = 0; index < expected.count(); ++index) {
+      REQUIRE(result[index].origin() == expected[index].origin());
+      REQUIRE(result[index].extent() == expected[index].extent());
+    }
+  }
+}
+
+TEST_CASE("Erase a selection ending with a newline along with one on the next row.", "Document") {
+  Document document("abc\ndef\nghi\n");
+  SelectionSet result = document.erase(SelectionSet(std::vector<Selection>({
+    Selection(Location(1, 0), Location(3, 0)),
+    Selection(Location(1, 1))
+  })));
+  
+  REQUIRE(document.contents() == "adf\nghi\n");
+  REQUIRE(result.count() == 2);
+  REQUIRE(result[0].origin() == Location(1, 0));
+  REQUIRE(result[1].origin() == Location(2, 0));
+}
+
+TEST_CASE("Find matches within rows.", "Document") {
+  Document document("foo bar\nbar foo\n");
+  SelectionSet result = document.matches(SearchExpression("foo"));
+  
+  REQUIRE(result.count() == 2);
+  REQUIRE(result[0] == Selection(Location(0, 0), Location(2, 0)));
+  REQUIRE(result[1] == Selection(Location(4, 1), Location(6, 1)));
+}
+
+TEST_CASE("Find matches spanning rows.", "Document") {
+  Document document("foo bar\nbar foo\n");
+  SelectionSet result = document.matches(SearchExpression("bar\nbar"));
+  
+  REQUIRE(result.count() == 1);
+  REQUIRE(result[0] == Selection(Location(4, 0), Location(2, 1)));
+}
+
+TEST_CASE("Find matches for expressions with a literal prefix.", "Document") {
+  Document document("foobar foobaz\nfoobar\n");
+  SelectionSet result = document.matches(SearchExpression("foo(?=bar)"));
+  
+  REQUIRE(result.count() == 2);
+  REQUIRE(result[0] == Selection(Location(0, 0), Location(2, 0)));
+  REQUIRE(result[1] == Selection(Location(0, 1), Location(2, 1)));
+}
+
+TEST_CASE("Find matches when empty.", "Document") {
+  Document document;
+  SelectionSet result = document.matches(SearchExpression("foo"));
+  
+  REQUIRE(result.count() == 0);
+}
+
+TEST_CASE("Find matches in a document larger than a search window.", "Document") {
+  std::string text;
+  for (std::size_t row = 0; text.size() < 1024 * 1024 + 1024 * 256; ++row) {
+    text += "row " + std::to_string(row) + (row % 1000 == 999 ? " foo\n" : "\n");
+  }
+  
+  text += "last row";
+  Document document(text);
+  
+  std::vector<std::string> expressions({ "^row", "row$", "foo\nrow \\d+", "\\bfoo\\b", "7 foo\n[^f]+f" });
+  for (const std::string& expression : expressions) {
+    INFO("Searching for \"" << expression << "\"");
+    SelectionSet result = document.matches(SearchExpression(expression));
+    std::vector<Selection> expected = referenceMatches(text, expression);
+    
+    REQUIRE(result.count() == expected.size());
+    for (std::size_t index = 0; index < expected.size(); ++index) {
+      REQUIRE(result[index] == expected[index]);
+    }
+  }
+}
+
+TEST_CASE("Find matches that continue past a search window.", "Document") {
+  std::string text = "a\nb\n";
+  for (std::size_t row = 0; row < 18000; ++row) {
+    text += std::string(60, 'x') + "\n";
+  }
+  
+  text += "b\n";
+  Document document(text);
+  
+  // The greedy match runs through every row to the last b, well past the first window.
+  SelectionSet result = document.matches(SearchExpression("a[^z]*b"));
+  REQUIRE(result.count() == 1);
+  REQUIRE(result[0] == Selection(Location(0, 0), Location(0, 18002)));
+  
+  // Matches spanning a bounded number of rows, and lookahead past the end of a row.
+  std::vector<std::string> expressions({ "x\n(x+\n){5}", "x\nb", "b(?=\nx)", "(x)\\1\n(?=b)" });
+  for (const std::string& expression : expressions) {
+    INFO("Searching for \"" << expression << "\"");
+    SelectionSet result = document.matches(SearchExpression(expression));
+    std::vector<Selection> expected = referenceMatches(text, expression);
+    
+    REQUIRE(result.count() == expected.size());
+    for (std::size_t index = 0; index < expected.size(); ++index) {
+      REQUIRE(result[index] == expected[index]);
+    }
+  }
+}
+
+TEST_CASE("Find matches a window at a time.", "Document") {
+  std::string text;
+  for (std::size_t row = 0; text.size() < 1024 * 1024 + 1024 * 256; ++row) {
+    text += "row " + std::to_string(row) + (row % 1000 == 999 ? " foo\n" : "\n");
+  }
+  
+  Document document(text);
+  SearchExpression expression("\\d+ foo");
+  std::vector<Selection> found;
+  std::size_t windows = 0;
+  REQUIRE(document.matches(expression, [&] (const std::vector<Selection>& matches) {
+    found.insert(found.end(), matches.begin(), matches.end());
+    ++windows;
+    return true;
+  }));
+  
+  REQUIRE(windows == 2);
+  REQUIRE(found.size() == document.matches(expression).count());
+  
+  found.clear();
+  REQUIRE_FALSE(document.matches(expression, [&] (const std::vector<Selection>& matches) {
+    found.insert(found.end(), matches.begin(), matches.end());
+    return false;
+  }));
+  
+  REQUIRE(found.size() < document.matches(expression).count());
+}
+
+TEST_CASE("Modifications report the rows they affected.", "Document") {
+  Document document("foo\nbar\nbaz\nqux\n");
+  std::vector<DocumentChange> changes;
+  document.onDocumentModified().connect([&changes] (const DocumentChange& change) {
+    changes.push_back(change);
+  });
+  
+  document.insert(Selection(Location(1, 1)), "x\ny");
+  REQUIRE(changes.back().firstRow == 1);
+  REQUIRE(changes.back().removedRows == 1);
+  REQUIRE(changes.back().insertedRows == 2);
+  
+  SelectionSet selections(std::vector<Selection>({ Selection(Location(0, 0)), Selection(Location(0, 3)) }));
+  document.insert(selections, "+");
+  REQUIRE(changes.back().firstRow == 0);
+  REQUIRE(changes.back().removedRows == 4);
+  REQUIRE(changes.back().insertedRows == 4);
+  
+  document.erase(Selection(Location(2, 1), Location(1, 3)));
+  REQUIRE(changes.back().firstRow == 1);
+  REQUIRE(changes.back().removedRows == 3);
+  REQUIRE(changes.back().insertedRows == 1);
+  REQUIRE(document.rows() == 3);
+  
+  document.erase(Selection(Location(0, 0), Location(3, 2)));
+  REQUIRE(document.isEmpty());
+  REQUIRE(changes.back().firstRow == 0);
+  REQUIRE(changes.back().removedRows == 3);
+  REQUIRE(changes.back().insertedRows == 0);
+  
+  document.insert(Selection(Location(0, 0)), "a\nb");
+  REQUIRE(changes.back().firstRow == 0);
+  REQUIRE(changes.back().removedRows == 0);
+  REQUIRE(changes.back().insertedRows == 2);
+}
+
+TEST_CASE("Snapshots are unaffected by later modifications.", "Document") {
+  Document document("foo\nbar\n");
+  document.setPath("/tmp/foo.txt");
+  std::shared_ptr<const Document> snapshot = document.snapshot();
+  
+  document.insert(Selection(Location(0, 0)), "baz\n");
+  document.erase(Selection(Location(0, 2), Location(3, 2)));
+  
+  REQUIRE(document.contents() == "baz\nfoo\n");
+  REQUIRE(snapshot->contents() == "foo\nbar\n");
+  REQUIRE(snapshot->path() == "/tmp/foo.txt");
+}
+
+TEST_CASE("Snapshots can be read on other threads while the document is edited.", "Document") {
+  std::string text;
+  for (std::size_t row = 0; row < 3000; ++row) {
+    text += "row " + std::to_string(row) + "\n";
+  }
+  
+  // Editors take turns with the document, as they would on the main thread, and publish a
+  // snapshot after each edit along with the text it should have. Readers check the snapshots
+  // they pick up without ever touching the document.
+  Document document(text);
+  std::mutex documentMutex;
+  
+  typedef std::pair<std::shared_ptr<const Document>, std::string> Published;
+  std::mutex publishedMutex;
+  Published published(document.snapshot(), text);
+  
+  std::atomic<bool> isEditing(true);
+  std::atomic<std::size_t> reads(0);
+  std::atomic<std::size_t> mismatches(0);
+  
+  std::vector<std::thread> readers;
+  for (std::size_t reader = 0; reader < 4; ++reader) {
+    readers.emplace_back([&] () {
+      std::vector<Published> held;
+      while (isEditing || reads < 100) {
+        Published current;
+        {
+          std::lock_guard<std::mutex> lock(publishedMutex);
+          current = published;
+        }
+        
+        // Older snapshots are held on to while the document moves on, and checked again.
+        held.push_back(current);
+        if (held.size() > 4) {
+          held.erase(held.begin());
+        }
+        
+        for (const Published& snapshot : held) {
+          std::string contents(snapshot.first->begin(), snapshot.first->end());
+          if (contents != snapshot.second || snapshot.first->contents() != snapshot.second) {
+            ++mismatches;
+          }
+        }
+        
+        ++reads;
+      }
+    });
+  }
+  
+  std::vector<std::thread> editors;
+  for (std::size_t editor = 0; editor < 2; ++editor) {
+    editors.emplace_back([&, editor] () {
+      std::mt19937 generator(editor);
+      for (std::size_t edit = 0; edit < 300; ++edit) {
+        std::lock_guard<std::mutex> lock(documentMutex);
+        std::size_t row = generator() % (document.rows() - 4);
+        if (edit % 3 == 2) {
+          document.erase(Selection(Location(0, row), Location(document.rowLength(row + 2) - 1, row + 2)));
+        } else {
+          document.insert(Selection(Location(1, row)), edit % 3 == 0 ? "edit\n" : "x");
+        }
+        
+        Published snapshot(document.snapshot(), document.contents());
+        std::lock_guard<std::mutex> publishedLock(publishedMutex);
+        published = snapshot;
+      }
+    });
+  }
+  
+  for (std::thread& editor : editors) {
+    editor.join();
+  }
+  
+  isEditing = false;
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+  
+  REQUIRE(reads >= 100);
+  REQUIRE(mismatches == 0);
+  REQUIRE(published.first->contents() == document.contents());
+}
+
+TEST_CASE("Restoring a snapshot reports only the rows that differ.", "Document") {
+  std::string text;
+  for (std::size_t row = 0; row < 5000; ++row) {
+    text += "row " + std::to_string(row) + "\n";
+  }
+  
+  Document document(text);
+  std::shared_ptr<const Document> snapshot = document.snapshot();
+  document.insert(Selection(Location(0, 2500)), "x\ny\n");
+  document.erase(Selection(Location(0, 2600), Location(5, 2600)));
+  
+  std::vector<DocumentChange> changes;
+  document.onDocumentModified().connect([&changes] (const DocumentChange& change) {
+    changes.push_back(change);
+  });
+  
+  document.restore(*snapshot);
+  REQUIRE(document.contents() == text);
+  REQUIRE(changes.size() == 1);
+  REQUIRE(changes.back().firstRow == 2500);
+  REQUIRE(changes.back().removedRows == 101);
+  REQUIRE(changes.back().insertedRows == 99);
+  
+  // Restoring the same text again changes nothing.
+  document.restore(*snapshot);
+  REQUIRE(changes.size() == 1);
+}
+
+TEST_CASE("Open a memory-mapped document.", "Document") {
+  std::string path = writeTemporaryFile("ABCD\nEFGH\nIJKL");
+  std::shared_ptr<Document> document = Document::openMapped(path);
+  
+  REQUIRE(document != nullptr);
+  REQUIRE(document->path() == path);
+  REQUIRE(document->rows() == 3);
+  REQUIRE(document->row(0) == "ABCD\n");
+  REQUIRE(document->row(2) == "IJKL");
+  REQUIRE(*document->at(1, 1) == 'F');
+  
+  std::remove(path.c_str());
+}
+
+TEST_CASE("Open an empty memory-mapped document.", "Document") {
+  std::string path = writeTemporaryFile("");
+  std::shared_ptr<Document> document = Document::openMapped(path);
+  
+  REQUIRE(document != nullptr);
+  REQUIRE(document->isEmpty());
+  
+  std::remove(path.c_str());
+}
+
+TEST_CASE("Open a missing memory-mapped document.", "Document") {
+  std::shared_ptr<Document> document = Document::openMapped("/tmp/QuipDocumentTests.missing");
+  
+  REQUIRE(document == nullptr);
+}
+
+TEST_CASE("Edit a memory-mapped document.", "Document") {
+  std::string path = writeTemporaryFile("ABCD\nEFGH\n");
+  std::shared_ptr<Document> document = Document::openMapped(path);
+  document->insert(Selection(Location(2, 1)), "XY");
+  
+  REQUIRE(document->row(0) == "ABCD\n");
+  REQUIRE(document->row(1) == "EFXYGH\n");
+  REQUIRE(document->contents() == "ABCD\nEFXYGH\n");
+  
+  std::remove(path.c_str());
+}
+
+TEST_CASE("Modifications made in a batch are reported together when it ends.", "Document") {
+  Document document("0\n1\n2\n3\n4\n5\n6\n7\n8\n9\n");
+  std::vector<DocumentChange> changes;
+  document.onDocumentModified().connect([&changes] (const DocumentChange& change) {
+    changes.push_back(change);
+  });
+  
+  document.beginBatch();
+  document.insert(Selection(Location(0, 2)), "a\n");
+  
+  document.beginBatch();
+  document.insert(Selection(Location(0, 7)), "b");
+  document.endBatch();
+  
+  REQUIRE(changes.empty());
+  document.endBatch();
+  
+  // Rows 2 to 6 of the original text became rows 2 to 7.
+  REQUIRE(document.contents() == "0\n1\na\n2\n3\n4\n5\nb6\n7\n8\n9\n");
+  REQUIRE(changes.size() == 1);
+  REQUIRE(changes[0].firstRow == 2);
+  REQUIRE(changes[0].removedRows == 5);
+  REQUIRE(changes[0].insertedRows == 6);
+  
+  // Whatever the modifications, the rows outside the reported change are the same before and
+  // after the batch.
+  std::mt19937 generator(11);
+  for (std::size_t trial = 0; trial < 200; ++trial) {
+    std::shared_ptr<const Document> original = document.snapshot();
+    changes.clear();
+    
+    document.beginBatch();
+    for (std::size_t edit = 0; edit < 3; ++edit) {
+      if (generator() % 2 == 0 || document.rows() < 4) {
+        std::size_t row = generator() % document.rows();
+        document.insert(Selection(Location(0, row)), generator() % 2 == 0 ? "x\ny\n" : "z");
+      } else {
+        // Erasures stop short of the last row, which may be empty.
+        std::size_t row = generator() % (document.rows() - 2);
+        std::size_t last = std::min<std::size_t>(row + generator() % 3, document.rows() - 2);
+        document.erase(Selection(Location(0, row), Location(document.rowLength(last) - 1, last)));
+      }
+    }
+    
+    document.endBatch();
+    
+    REQUIRE(changes.size() == 1);
+    const DocumentChange& change = changes[0];
+    REQUIRE(original->rows() - change.removedRows == document.rows() - change.insertedRows);
+    for (std::size_t row = 0; row < change.firstRow; ++row) {
+      REQUIRE(original->row(row) == document.row(row));
+    }
+    
+    for (std::size_t row = change.firstRow + change.insertedRows; row < document.rows(); ++row) {
+      REQUIRE(original->row(row - change.insertedRows + change.removedRows) == document.row(row));
+    }
+  }
+}
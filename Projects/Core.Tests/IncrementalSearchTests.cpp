@@ -0,0 +1,125 @@
+#include "catch.hpp"
+
+#include "Document.hpp"
+#include "IncrementalSearch.hpp"
+#include "SearchExpression.hpp"
+#include "Selection.hpp"
+
+using namespace quip;
+
+namespace {
+  bool matchesAreEqual(const SelectionSet& left, const SelectionSet& right) {
+    if (left.count() != right.count()) {
+      return false;
+    }
+    
+    for (std::size_t index = 0; index < left.count(); ++index) {
+      if (!(left[index] == right[index])) {
+        return false;
+      }
+    }
+    
+    return true;
+  }
+}
+
+TEST_CASE("Incremental searches find literal text.", "[IncrementalSearchTests]") {
+  Document document("foo bar\nfood\n");
+  IncrementalSearch search;
+  
+  REQUIRE(search.update(document, "foo"));
+  REQUIRE(search.matches().count() == 2);
+  REQUIRE(search.matches()[1] == Selection(Location(0, 1), Location(2, 1)));
+}
+
+TEST_CASE("Incremental searches refine results as literal text is typed.", "[IncrementalSearchTests]") {
+  Document document("foo bar\nfood fool\nbarfoo\n");
+  IncrementalSearch search;
+  
+  std::string typed = "food";
+  for (std::size_t length = 1; length <= typed.size(); ++length) {
+    std::string expression = typed.substr(0, length);
+    REQUIRE(search.update(document, expression));
+    REQUIRE(matchesAreEqual(search.matches(), document.matches(SearchExpression(expression))));
+  }
+  
+  REQUIRE(search.matches().count() == 1);
+}
+
+TEST_CASE("Incremental searches refine overlapping literal text.", "[IncrementalSearchTests]") {
+  Document document("aaab\n");
+  IncrementalSearch search;
+  
+  REQUIRE(search.update(document, "aa"));
+  REQUIRE(search.matches().count() == 1);
+  REQUIRE(search.update(document, "aab"));
+  REQUIRE(search.matches().count() == 1);
+  REQUIRE(search.matches()[0] == Selection(Location(1, 0), Location(3, 0)));
+}
+
+TEST_CASE("Incremental searches restore earlier results when characters are deleted.", "[IncrementalSearchTests]") {
+  Document document("foo bar\nfood\n");
+  IncrementalSearch search;
+  
+  search.update(document, "fo");
+  search.update(document, "foo");
+  search.update(document, "food");
+  REQUIRE(search.matches().count() == 1);
+  
+  REQUIRE(search.update(document, "fo"));
+  REQUIRE(search.matches().count() == 2);
+}
+
+TEST_CASE("Incremental searches refine literal text typed after characters are deleted.", "[IncrementalSearchTests]") {
+  Document document("foo bar\nfood fool\nbarfoo\n");
+  IncrementalSearch search;
+  
+  // Only the search for the longest text keeps where it occurs, so going back to a shorter
+  // text and typing something else has to search again.
+  for (const char* expression : {"fo", "foo", "food", "foo", "fool", "fo", "fo+l", "fo", "foo"}) {
+    REQUIRE(search.update(document, expression));
+    REQUIRE(matchesAreEqual(search.matches(), document.matches(SearchExpression(expression))));
+  }
+}
+
+TEST_CASE("Incremental searches handle regular expressions.", "[IncrementalSearchTests]") {
+  Document document("foo bar\nfood\n");
+  IncrementalSearch search;
+  
+  REQUIRE(search.update(document, "fo"));
+  REQUIRE(search.update(document, "fo+d"));
+  REQUIRE(search.matches().count() == 1);
+  REQUIRE_FALSE(search.update(document, "fo+d["));
+  REQUIRE(search.matches().count() == 0);
+  REQUIRE(search.update(document, "fo+d[ ]?"));
+  REQUIRE(search.matches().count() == 1);
+}
+
+TEST_CASE("Incremental searches pass results to a visitor as they're found.", "[IncrementalSearchTests]") {
+  Document document("foo bar\nfood\n");
+  IncrementalSearch search;
+  
+  for (const char* expression : {"fo", "foo", "fo+d"}) {
+    std::vector<Selection> found;
+    REQUIRE(search.update(document, expression, [&found] (const std::vector<Selection>& matches) {
+      found.insert(found.end(), matches.begin(), matches.end());
+      return true;
+    }));
+    
+    REQUIRE(matchesAreEqual(SelectionSet(found), search.matches()));
+  }
+}
+
+TEST_CASE("Incremental searches can be abandoned.", "[IncrementalSearchTests]") {
+  Document document("foo bar\nfood\n");
+  IncrementalSearch search;
+  
+  REQUIRE(search.update(document, "fo"));
+  REQUIRE_FALSE(search.update(document, "foo", [] (const std::vector<Selection>& matches) {
+    return false;
+  }));
+  
+  REQUIRE(search.matches().count() == 2);
+  REQUIRE(search.update(document, "food"));
+  REQUIRE(search.matches().count() == 1);
+}
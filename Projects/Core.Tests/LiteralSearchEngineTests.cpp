@@ -0,0 +1,51 @@
+#include "catch.hpp"
+
+#include "LiteralSearchEngine.hpp"
+
+using namespace quip;
+
+TEST_CASE("Literal search engines find literal text.", "[LiteralSearchEngineTests]") {
+  LiteralSearchEngine engine("foo", false);
+  std::string text = "foo and foo";
+  
+  SearchMatch match;
+  REQUIRE(engine.search(text.data(), text.size(), 1, true, true, match));
+  REQUIRE(match.position == 8);
+  REQUIRE(match.length == 3);
+  REQUIRE_FALSE(engine.search(text.data(), text.size(), 9, true, true, match));
+}
+
+TEST_CASE("Literal search engines can ignore case.", "[LiteralSearchEngineTests]") {
+  LiteralSearchEngine engine("foo", true);
+  std::string text = "a FoO";
+  
+  SearchMatch match;
+  REQUIRE(engine.search(text.data(), text.size(), 0, true, true, match));
+  REQUIRE(match.position == 2);
+}
+
+TEST_CASE("Literal search engines recognize literal expressions.", "[LiteralSearchEngineTests]") {
+  std::string prefix;
+  
+  REQUIRE(LiteralSearchEngine::findLiteralPrefix("foo", prefix));
+  REQUIRE(prefix == "foo");
+  REQUIRE(LiteralSearchEngine::findLiteralPrefix("a\\.h\\n", prefix));
+  REQUIRE(prefix == "a.h\n");
+}
+
+TEST_CASE("Literal search engines find the literal prefix of expressions.", "[LiteralSearchEngineTests]") {
+  std::string prefix;
+  
+  REQUIRE_FALSE(LiteralSearchEngine::findLiteralPrefix("foo.*bar", prefix));
+  REQUIRE(prefix == "foo");
+  REQUIRE_FALSE(LiteralSearchEngine::findLiteralPrefix("fo+", prefix));
+  REQUIRE(prefix == "f");
+  REQUIRE_FALSE(LiteralSearchEngine::findLiteralPrefix("foo|bar", prefix));
+  REQUIRE(prefix == "");
+  REQUIRE_FALSE(LiteralSearchEngine::findLiteralPrefix("foo(a|b)", prefix));
+  REQUIRE(prefix == "foo");
+  REQUIRE_FALSE(LiteralSearchEngine::findLiteralPrefix("foo\\d", prefix));
+  REQUIRE(prefix == "foo");
+  REQUIRE_FALSE(LiteralSearchEngine::findLiteralPrefix("(foo)", prefix));
+  REQUIRE(prefix == "");
+}
@@ -0,0 +1,62 @@
+#include "catch.hpp"
+
+#include "NewlineScanner.hpp"
+
+#include <random>
+#include <string>
+
+using namespace quip;
+
+TEST_CASE("Newline scanners find nothing in an empty buffer.", "[NewlineScannerTests]") {
+  std::vector<std::size_t> offsets;
+  findNewlines("", 0, offsets);
+  
+  REQUIRE(offsets.empty());
+}
+
+TEST_CASE("Newline scanners find newlines in a short buffer.", "[NewlineScannerTests]") {
+  std::string text = "AB\nC\n\nD";
+  std::vector<std::size_t> offsets;
+  findNewlines(text.data(), text.size(), offsets);
+  
+  REQUIRE(offsets == std::vector<std::size_t>({2, 4, 5}));
+}
+
+TEST_CASE("Newline scanners append to existing offsets.", "[NewlineScannerTests]") {
+  std::string text = "A\nB";
+  std::vector<std::size_t> offsets({42});
+  findNewlines(text.data(), text.size(), offsets);
+  
+  REQUIRE(offsets == std::vector<std::size_t>({42, 1}));
+}
+
+TEST_CASE("Newline scanners find newlines on vector block boundaries.", "[NewlineScannerTests]") {
+  std::string text(200, 'x');
+  std::vector<std::size_t> expected({0, 15, 16, 31, 32, 63, 64, 65, 127, 128, 199});
+  for (std::size_t offset : expected) {
+    text[offset] = '\n';
+  }
+  
+  std::vector<std::size_t> offsets;
+  findNewlines(text.data(), text.size(), offsets);
+  
+  REQUIRE(offsets == expected);
+}
+
+TEST_CASE("Newline scanners agree with the scalar scan at every alignment.", "[NewlineScannerTests]") {
+  std::mt19937 generator(1234);
+  std::uniform_int_distribution<int> distribution(0, 7);
+  std::string text(4096, 'x');
+  for (char& character : text) {
+    character = distribution(generator) == 0 ? '\n' : 'x';
+  }
+  
+  for (std::size_t start = 0; start < 64; ++start) {
+    std::vector<std::size_t> expected;
+    findNewlinesScalar(text.data() + start, text.size() - start, expected);
+    
+    std::vector<std::size_t> offsets;
+    findNewlines(text.data() + start, text.size() - start, offsets);
+    REQUIRE(offsets == expected);
+  }
+}
@@ -0,0 +1,215 @@
+#include "catch.hpp"
+
+#include "PieceTable.hpp"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace quip;
+
+namespace {
+  std::string numberedRows(std::size_t count) {
+    std::string result;
+    for (std::size_t index = 0; index < count; ++index) {
+      result += std::to_string(index) + "\n";
+    }
+    
+    return result;
+  }
+}
+
+TEST_CASE("Piece tables can be default-constructed.", "[PieceTableTests]") {
+  PieceTable table;
+  
+  REQUIRE(table.rows() == 0);
+  REQUIRE(table.length() == 0);
+}
+
+TEST_CASE("Piece tables split text into rows that keep their newlines.", "[PieceTableTests]") {
+  PieceTable table("ABCD\nEFGH\nIJ");
+  
+  REQUIRE(table.rows() == 3);
+  REQUIRE(table.length() == 12);
+  REQUIRE(table.row(0) == "ABCD\n");
+  REQUIRE(table.row(1) == "EFGH\n");
+  REQUIRE(table.row(2) == "IJ");
+  REQUIRE(table.rowLength(2) == 2);
+}
+
+TEST_CASE("Piece tables can replace a row.", "[PieceTableTests]") {
+  PieceTable table("ABCD\nEFGH\n");
+  table.replace(0, 1, { "AB\n" });
+  
+  REQUIRE(table.rows() == 2);
+  REQUIRE(table.length() == 8);
+  REQUIRE(table.row(0) == "AB\n");
+  REQUIRE(table.row(1) == "EFGH\n");
+}
+
+TEST_CASE("Piece tables can insert and remove rows.", "[PieceTableTests]") {
+  PieceTable table("ABCD\nEFGH\n");
+  table.replace(1, 0, { "1\n", "2\n" });
+  
+  REQUIRE(table.rows() == 4);
+  REQUIRE(table.row(1) == "1\n");
+  REQUIRE(table.row(2) == "2\n");
+  REQUIRE(table.row(3) == "EFGH\n");
+  
+  table.replace(0, 3, {});
+  REQUIRE(table.rows() == 1);
+  REQUIRE(table.row(0) == "EFGH\n");
+}
+
+TEST_CASE("Piece tables can append rows to an empty table.", "[PieceTableTests]") {
+  PieceTable table;
+  table.replace(0, 0, { "ABCD\n", "" });
+  
+  REQUIRE(table.rows() == 2);
+  REQUIRE(table.row(0) == "ABCD\n");
+  REQUIRE(table.row(1) == "");
+}
+
+TEST_CASE("Piece tables can replace rows spanning several chunks.", "[PieceTableTests]") {
+  PieceTable table(numberedRows(5000));
+  REQUIRE(table.rows() == 5000);
+  
+  table.replace(1000, 2000, { "X\n" });
+  REQUIRE(table.rows() == 3001);
+  REQUIRE(table.row(999) == "999\n");
+  REQUIRE(table.row(1000) == "X\n");
+  REQUIRE(table.row(1001) == "3000\n");
+  REQUIRE(table.row(3000) == "4999\n");
+}
+
+TEST_CASE("Piece tables stay consistent when a chunk grows past its capacity.", "[PieceTableTests]") {
+  PieceTable table(numberedRows(10));
+  
+  std::vector<std::string> inserted;
+  for (std::size_t index = 0; index < 3000; ++index) {
+    inserted.emplace_back("+\n");
+  }
+  
+  table.replace(5, 0, inserted);
+  REQUIRE(table.rows() == 3010);
+  REQUIRE(table.row(4) == "4\n");
+  REQUIRE(table.row(5) == "+\n");
+  REQUIRE(table.row(3004) == "+\n");
+  REQUIRE(table.row(3005) == "5\n");
+  REQUIRE(table.row(3009) == "9\n");
+}
+
+TEST_CASE("Piece tables can store rows larger than an add buffer block.", "[PieceTableTests]") {
+  PieceTable table;
+  std::string large(200000, 'A');
+  table.replace(0, 0, { "small\n", large });
+  
+  REQUIRE(table.row(0) == "small\n");
+  REQUIRE(table.row(1) == large);
+  REQUIRE(table.length() == large.size() + 6);
+}
+
+TEST_CASE("Piece tables can be rebuilt from existing and new rows.", "[PieceTableTests]") {
+  PieceTable table(numberedRows(3000));
+  
+  PieceTable::Builder builder(table);
+  builder.copyRows(0, 1500);
+  builder.appendRow("+\n");
+  builder.copyRows(2000, 1000);
+  REQUIRE(builder.rows() == 2501);
+  REQUIRE(table.rows() == 3000);
+  
+  builder.commit();
+  REQUIRE(table.rows() == 2501);
+  REQUIRE(table.row(1499) == "1499\n");
+  REQUIRE(table.row(1500) == "+\n");
+  REQUIRE(table.row(1501) == "2000\n");
+  REQUIRE(table.row(2500) == "2999\n");
+  
+  std::size_t length = 0;
+  for (std::size_t index = 0; index < table.rows(); ++index) {
+    length += table.rowLength(index);
+  }
+  
+  REQUIRE(table.length() == length);
+}
+
+TEST_CASE("Piece table copies are unaffected by later edits.", "[PieceTableTests]") {
+  PieceTable table(numberedRows(3000));
+  table.replace(10, 1, { "edited\n" });
+  
+  PieceTable copy(table);
+  table.replace(0, 2000, { "replaced\n" });
+  table.replace(1, 0, { "inserted\n" });
+  copy.replace(2999, 1, { "last\n" });
+  
+  REQUIRE(copy.rows() == 3000);
+  REQUIRE(copy.row(0) == "0\n");
+  REQUIRE(copy.row(10) == "edited\n");
+  REQUIRE(copy.row(2998) == "2998\n");
+  REQUIRE(copy.row(2999) == "last\n");
+  
+  REQUIRE(table.rows() == 1002);
+  REQUIRE(table.row(0) == "replaced\n");
+  REQUIRE(table.row(1) == "inserted\n");
+  REQUIRE(table.row(1001) == "2999\n");
+}
+
+TEST_CASE("Rebuilt piece tables share the chunks they didn't change.", "[PieceTableTests]") {
+  PieceTable table(numberedRows(10000));
+  PieceTable original(table);
+  
+  PieceTable::Builder builder(table);
+  builder.copyRows(0, 5000);
+  builder.appendRow("edited\n");
+  builder.copyRows(5001, 4999);
+  builder.commit();
+  
+  REQUIRE(table.commonPrefix(original) == 5000);
+  REQUIRE(table.commonSuffix(original, 5000) == 4999);
+  REQUIRE(table.commonSuffix(original, 100) == 100);
+  
+  original = table;
+  REQUIRE(original.commonPrefix(table) == 10000);
+  REQUIRE(original.row(5000) == "edited\n");
+}
+
+TEST_CASE("Piece tables stay consistent through many rebuilds.", "[PieceTableTests]") {
+  PieceTable table(numberedRows(5000));
+  std::vector<std::string> reference;
+  for (std::size_t index = 0; index < 5000; ++index) {
+    reference.emplace_back(std::to_string(index) + "\n");
+  }
+  
+  std::mt19937 generator(23);
+  for (std::size_t rebuild = 0; rebuild < 200; ++rebuild) {
+    std::size_t first = generator() % reference.size();
+    std::size_t removed = std::min<std::size_t>(generator() % 1500, reference.size() - first);
+    std::size_t inserted = generator() % 1500;
+    
+    PieceTable::Builder builder(table);
+    builder.copyRows(0, first);
+    std::vector<std::string> rows;
+    for (std::size_t index = 0; index < inserted; ++index) {
+      rows.emplace_back("new " + std::to_string(rebuild) + "\n");
+      builder.appendRow(rows.back());
+    }
+    
+    builder.copyRows(first + removed, reference.size() - first - removed);
+    builder.commit();
+    
+    reference.erase(reference.begin() + first, reference.begin() + first + removed);
+    reference.insert(reference.begin() + first, rows.begin(), rows.end());
+  }
+  
+  REQUIRE(table.rows() == reference.size());
+  
+  std::size_t length = 0;
+  for (std::size_t index = 0; index < reference.size(); ++index) {
+    REQUIRE(table.row(index) == reference[index]);
+    length += reference[index].size();
+  }
+  
+  REQUIRE(table.length() == length);
+}
@@ -0,0 +1,65 @@
+#include "catch.hpp"
+
+#include "AttributeRegistry.hpp"
+#include "Document.hpp"
+#include "Script.hpp"
+#include "ScriptHost.hpp"
+#include "TestScriptHost.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace quip;
+
+namespace {
+  // A syntax module that counts how many times it has been run, and names its only token after
+  // that count and the state the row began in.
+  const char* CountingSyntax =
+    "loads = (loads or 0) + 1\n"
+    "local count = loads\n"
+    "return function (line, state)\n"
+    "  return { \"load\" .. count .. state, 1, #line + 1 }, state .. \"+\"\n"
+    "end\n";
+}
+
+TEST_CASE("Syntax modules are run once.", "[ScriptHostTests]") {
+  TestScriptHost host;
+  std::string path = host.writeScript("counting", CountingSyntax);
+  
+  Script syntax = host.getSyntax(path);
+  REQUIRE(host.getSyntax(path).identifier() == syntax.identifier());
+  
+  for (std::size_t pass = 0; pass < 3; ++pass) {
+    std::string endState;
+    std::vector<AttributeRange> attributes = host.parseSyntax(syntax, "foo", "s", endState);
+    REQUIRE(attributes.size() == 1);
+    REQUIRE(AttributeRegistry::shared().name(attributes[0].attribute) == "load1s");
+    REQUIRE(attributes[0].start == 0);
+    REQUIRE(attributes[0].length == 3);
+    REQUIRE(endState == "s+");
+  }
+}
+
+TEST_CASE("Syntax modules parse ranges of rows with the function they return.", "[ScriptHostTests]") {
+  TestScriptHost host;
+  Script syntax = host.getSyntax(host.writeScript("counting", CountingSyntax));
+  Document document("foo\nbar\nbaz\n");
+  
+  std::vector<std::string> endStates;
+  std::vector<RowAttributeRange> attributes = host.parseSyntaxRange(syntax, document, 0, 2, "", endStates);
+  REQUIRE(attributes.size() == 3);
+  REQUIRE(AttributeRegistry::shared().name(attributes[0].attribute) == "load1");
+  REQUIRE(AttributeRegistry::shared().name(attributes[1].attribute) == "load1+");
+  REQUIRE(AttributeRegistry::shared().name(attributes[2].attribute) == "load1++");
+  REQUIRE(attributes[2].row == 2);
+  REQUIRE(endStates == std::vector<std::string>({"+", "++", "+++"}));
+}
+
+TEST_CASE("Syntax modules must return a function.", "[ScriptHostTests]") {
+  TestScriptHost host;
+  Script syntax = host.getSyntax(host.writeScript("table", "return {}\n"));
+  
+  std::string endState;
+  REQUIRE(host.parseSyntax(syntax, "foo", "", endState).empty());
+  REQUIRE(endState.empty());
+}
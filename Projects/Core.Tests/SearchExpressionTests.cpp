@@ -1,5 +1,6 @@
 #include "catch.hpp"
 
+#include "SearchEngine.hpp"
 #include "SearchExpression.hpp"
 
 using namespace quip;
@@ -29,3 +30,19 @@ TEST_CASE("Search expressions can be constructed from an expression with a trail
   
   REQUIRE_FALSE(expression.valid());
 }
+
+TEST_CASE("Search expressions can be constructed from an expression with a backreference.", "[SearchExpressionTests]") {
+  SearchExpression expression("(a)\\1");
+  
+  REQUIRE(expression.valid());
+}
+
+TEST_CASE("Search expressions can ignore case.", "[SearchExpressionTests]") {
+  SearchExpression expression("foo", true);
+  std::string text = "FOO";
+  
+  SearchMatch match;
+  REQUIRE(expression.valid());
+  REQUIRE(expression.ignoresCase());
+  REQUIRE(expression.engine().search(text.data(), text.size(), 0, true, true, match));
+}
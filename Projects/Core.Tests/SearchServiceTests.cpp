@@ -0,0 +1,190 @@
+#include "catch.hpp"
+
+#include "Document.hpp"
+#include "EditContext.hpp"
+#include "Mode.hpp"
+#include "SearchExpression.hpp"
+#include "SearchService.hpp"
+#include "Selection.hpp"
+#include "TestScriptHost.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace quip;
+
+namespace {
+  bool matchesAreEqual(const SelectionSet& left, const SelectionSet& right) {
+    if (left.count() != right.count()) {
+      return false;
+    }
+    
+    for (std::size_t index = 0; index < left.count(); ++index) {
+      if (!(left[index] == right[index])) {
+        return false;
+      }
+    }
+    
+    return true;
+  }
+  
+  // A document large enough to be searched in several windows.
+  std::string makeLargeText() {
+    std::string text;
+    for (std::size_t row = 0; text.size() < 1024 * 1024 + 1024 * 256; ++row) {
+      text += "row " + std::to_string(row) + (row % 7 == 0 ? " needle" : "") + " of the haystack\n";
+    }
+    
+    return text;
+  }
+}
+
+TEST_CASE("Search services find the same matches as the document.", "[SearchServiceTests]") {
+  std::shared_ptr<Document> document = std::make_shared<Document>(makeLargeText());
+  SearchService service;
+  
+  for (const char* expression : {"needle", "ne+dle of", "\\d+7 needle"}) {
+    service.start(document->snapshot(), expression);
+    service.wait();
+    
+    REQUIRE(!service.isSearching());
+    REQUIRE(service.isValid());
+    REQUIRE(service.matches().count() > 0);
+    REQUIRE(matchesAreEqual(service.matches(), document->matches(SearchExpression(expression))));
+  }
+}
+
+TEST_CASE("Search services refine searches of the same snapshot.", "[SearchServiceTests]") {
+  std::shared_ptr<Document> document = std::make_shared<Document>("foo bar\nfood fool\nbarfoo\n");
+  std::shared_ptr<const Document> snapshot = document->snapshot();
+  SearchService service;
+  
+  std::string typed = "food";
+  for (std::size_t length = 1; length <= typed.size(); ++length) {
+    std::string expression = typed.substr(0, length);
+    service.start(snapshot, expression);
+    service.wait();
+    REQUIRE(matchesAreEqual(service.matches(), document->matches(SearchExpression(expression))));
+  }
+  
+  REQUIRE(service.matches().count() == 1);
+}
+
+TEST_CASE("Search services cancel searches that are superseded.", "[SearchServiceTests]") {
+  std::shared_ptr<Document> document = std::make_shared<Document>(makeLargeText());
+  SearchService service;
+  
+  service.start(document->snapshot(), "e");
+  service.start(document->snapshot(), "needle");
+  service.wait();
+  
+  REQUIRE(matchesAreEqual(service.matches(), document->matches(SearchExpression("needle"))));
+  
+  service.start(document->snapshot(), "e");
+  service.cancel();
+  service.wait();
+  
+  REQUIRE(!service.isSearching());
+  REQUIRE(service.matches().count() == 0);
+}
+
+TEST_CASE("Search services report invalid expressions.", "[SearchServiceTests]") {
+  std::shared_ptr<Document> document = std::make_shared<Document>("foo\n");
+  SearchService service;
+  
+  service.start(document->snapshot(), "(foo");
+  service.wait();
+  
+  REQUIRE(!service.isSearching());
+  REQUIRE(!service.isValid());
+  REQUIRE(service.matches().count() == 0);
+}
+
+TEST_CASE("Search services search snapshots while the document is edited.", "[SearchServiceTests]") {
+  std::shared_ptr<Document> document = std::make_shared<Document>(makeLargeText());
+  std::shared_ptr<const Document> snapshot = document->snapshot();
+  SelectionSet expected = document->matches(SearchExpression("needle"));
+  SearchService service;
+  
+  service.start(snapshot, "needle");
+  for (std::size_t index = 0; index < 100; ++index) {
+    document->erase(Selection(Location(0, index * 10)));
+    document->insert(Selection(Location(0, index * 10 + 1)), "needle");
+  }
+  
+  service.wait();
+  REQUIRE(matchesAreEqual(service.matches(), expected));
+}
+
+TEST_CASE("Search services stream matches as they're found.", "[SearchServiceTests]") {
+  std::shared_ptr<Document> document = std::make_shared<Document>(makeLargeText());
+  SearchService service;
+  
+  service.start(document->snapshot(), "needle");
+  std::size_t previous = 0;
+  while (service.isSearching()) {
+    if (service.poll()) {
+      REQUIRE(service.matches().count() >= previous);
+      previous = service.matches().count();
+    }
+  }
+  
+  REQUIRE(matchesAreEqual(service.matches(), document->matches(SearchExpression("needle"))));
+}
+
+TEST_CASE("Search services don't wait on the search in progress when destroyed.", "[SearchServiceTests]") {
+  typedef std::chrono::steady_clock Clock;
+  std::shared_ptr<Document> document = std::make_shared<Document>(makeLargeText());
+  
+  // A backreference can't be searched for by the automaton, so the search falls back to
+  // std::regex, which can't be cancelled partway through a window of text.
+  const std::string expression = "(\\w+)\\1 of";
+  Clock::time_point start = Clock::now();
+  {
+    SearchService service;
+    service.start(document->snapshot(), expression);
+    service.wait();
+  }
+  
+  Clock::duration searching = Clock::now() - start;
+  
+  // Destroy the service once its worker is well into the first window.
+  std::unique_ptr<SearchService> service(new SearchService());
+  service->start(document->snapshot(), expression);
+  std::this_thread::sleep_for(searching / 8);
+  start = Clock::now();
+  service.reset();
+  REQUIRE(Clock::now() - start < searching / 8);
+}
+
+TEST_CASE("Keys pressed while a search is being committed act on its matches.", "[SearchServiceTests]") {
+  TestScriptHost host;
+  std::string text = makeLargeText();
+  std::shared_ptr<Document> document = std::make_shared<Document>(text);
+  EditContext context(nullptr, nullptr, &host, document);
+  
+  // The backreference makes the search slow enough that it's still running when it's committed.
+  context.processKeyEvent(Key::Slash, Modifiers(), "/");
+  for (char character : std::string("(\\w)\\1dle")) {
+    context.processKeyEvent(Key::A, Modifiers(), std::string(1, character));
+  }
+  
+  context.processKeyEvent(Key::Return, Modifiers(), "\n");
+  context.processKeyEvent(Key::X, Modifiers(), "x");
+  while (context.mode().defersKeys()) {
+    context.tick();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  
+  // The key deleted the matches rather than being added to the search.
+  std::string expected;
+  for (std::size_t start = 0, found = 0; start < text.size(); start = found + 5) {
+    found = std::min(text.find("eedle", start), text.size());
+    expected += text.substr(start, found - start);
+  }
+  
+  REQUIRE(document->contents() == expected);
+}
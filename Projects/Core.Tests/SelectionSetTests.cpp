@@ -102,3 +102,39 @@ TEST_CASE("Selection sets collapse pairs of overlapping selections.", "[Selectio
   REQUIRE(cursor->origin() == Location(0, 5));
   REQUIRE(cursor->extent() == Location(0, 10));
 }
+
+TEST_CASE("Selection sets are equal if their selections and primary selections are.", "[SelectionSetTests]") {
+  std::vector<Selection> selections { Selection(Location(1, 0)), Selection(Location(4, 2)) };
+  SelectionSet set(selections);
+  
+  REQUIRE(set == SelectionSet(selections));
+  REQUIRE(SelectionSet() == SelectionSet());
+  REQUIRE(set != SelectionSet(Selection(Location(1, 0))));
+  
+  SelectionSet rotated(selections);
+  rotated.rotateForward();
+  REQUIRE(set != rotated);
+  
+  rotated.rotateForward();
+  REQUIRE(set == rotated);
+}
+
+TEST_CASE("Selection sets append selections that follow their own.", "[SelectionSetTests]") {
+  std::vector<Selection> selections {
+    Selection(Location(0, 0), Location(2, 0)),
+    Selection(Location(2, 0), Location(4, 0)),
+    Selection(Location(0, 1)),
+    Selection(Location(3, 1), Location(1, 2)),
+    Selection(Location(5, 2))
+  };
+  
+  SelectionSet set;
+  set.append(std::vector<Selection>(selections.begin(), selections.begin() + 1));
+  set.append(std::vector<Selection>(selections.begin() + 1, selections.begin() + 3));
+  set.append(std::vector<Selection>());
+  set.append(std::vector<Selection>(selections.begin() + 3, selections.end()));
+  
+  REQUIRE(set == SelectionSet(selections));
+  REQUIRE(set.count() == 4);
+  REQUIRE(set[0] == Selection(Location(0, 0), Location(4, 0)));
+}
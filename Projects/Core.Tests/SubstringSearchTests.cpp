@@ -0,0 +1,63 @@
+#include "catch.hpp"
+
+#include "SubstringSearch.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <random>
+#include <string>
+
+using namespace quip;
+
+namespace {
+  std::string lowercase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [] (char character) {
+      return static_cast<char>(std::tolower(static_cast<unsigned char>(character)));
+    });
+    
+    return text;
+  }
+}
+
+TEST_CASE("Substring searches find nothing in an empty buffer.", "[SubstringSearchTests]") {
+  REQUIRE(findSubstring("", 0, "foo", 3) == 0);
+}
+
+TEST_CASE("Substring searches find an empty needle immediately.", "[SubstringSearchTests]") {
+  REQUIRE(findSubstring("foo", 3, "", 0) == 0);
+}
+
+TEST_CASE("Substring searches find a needle in a short buffer.", "[SubstringSearchTests]") {
+  std::string text = "a foo and a bar";
+  
+  REQUIRE(findSubstring(text.data(), text.size(), "bar", 3) == 12);
+  REQUIRE(findSubstring(text.data(), text.size(), "baz", 3) == text.size());
+}
+
+TEST_CASE("Substring searches find needles ignoring case.", "[SubstringSearchTests]") {
+  std::string text = "a Foo and a BAR";
+  
+  REQUIRE(findSubstringIgnoringCase(text.data(), text.size(), "bar", 3) == 12);
+  REQUIRE(findSubstringIgnoringCase(text.data(), text.size(), "fOO", 3) == 2);
+  REQUIRE(findSubstring(text.data(), text.size(), "bar", 3) == text.size());
+}
+
+TEST_CASE("Substring searches agree with std::string at every alignment.", "[SubstringSearchTests]") {
+  std::mt19937 generator(1234);
+  std::string text(1024, 'a');
+  for (char& character : text) {
+    character = "abAB@`"[generator() % 6];
+  }
+  
+  for (std::size_t length = 1; length < 6; ++length) {
+    for (std::size_t start = 0; start < 64; ++start) {
+      std::string needle = text.substr(700 + start, length);
+      std::size_t expected = text.find(needle, start);
+      REQUIRE(start + findSubstring(text.data() + start, text.size() - start, needle.data(), needle.size()) == expected);
+      
+      std::string folded = lowercase(text);
+      expected = folded.find(lowercase(needle), start);
+      REQUIRE(start + findSubstringIgnoringCase(text.data() + start, text.size() - start, needle.data(), needle.size()) == expected);
+    }
+  }
+}
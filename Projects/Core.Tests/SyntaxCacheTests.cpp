@@ -0,0 +1,273 @@
+#include "catch.hpp"
+
+#include "AttributeRegistry.hpp"
+#include "Document.hpp"
+#include "Selection.hpp"
+#include "SelectionSet.hpp"
+#include "SyntaxCache.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace quip;
+
+namespace {
+  // A stand-in for a syntax script, which names a single attribute after the text it parsed
+  // and the state it started in. Rows are in a comment from a "/*" until the next "*/".
+  struct CountingParser {
+    std::size_t calls;
+    
+    CountingParser()
+    : calls(0) {
+    }
+    
+    SyntaxCache::Parser parser() {
+      return [this] (const std::string& text, const std::string& state, std::string& endState) {
+        ++calls;
+        endState = parse(text, state);
+        return std::vector<AttributeRange>({ AttributeRange(AttributeRegistry::shared().intern(state + text), 0, text.size()) });
+      };
+    }
+    
+    static std::string parse(const std::string& text, const std::string& state) {
+      bool isComment = state == "comment";
+      for (std::size_t index = 0; index + 1 < text.size(); ++index) {
+        if (text.compare(index, 2, isComment ? "*/" : "/*") == 0) {
+          isComment = !isComment;
+          ++index;
+        }
+      }
+      
+      return isComment ? "comment" : "";
+    }
+  };
+  
+  // The attribute names every row of a document should have, parsing it from the top.
+  std::vector<std::string> expectedNames(const Document& document) {
+    std::vector<std::string> names;
+    std::string state;
+    for (std::size_t row = 0; row < document.rows(); ++row) {
+      names.emplace_back(state + document.row(row));
+      state = CountingParser::parse(document.row(row), state);
+    }
+    
+    return names;
+  }
+}
+
+TEST_CASE("Syntax caches parse each row once.", "[SyntaxCacheTests]") {
+  Document document("foo\nbar\nbaz\n");
+  CountingParser counter;
+  SyntaxCache cache(document, counter.parser());
+  
+  for (std::size_t pass = 0; pass < 3; ++pass) {
+    for (std::size_t row = 0; row < document.rows(); ++row) {
+      REQUIRE(AttributeRegistry::shared().name(cache.attributes(row)[0].attribute) == document.row(row));
+    }
+  }
+  
+  REQUIRE(counter.calls == 3);
+}
+
+TEST_CASE("Syntax caches only parse rows that were modified.", "[SyntaxCacheTests]") {
+  Document document("foo\nbar\nbaz\nqux\n");
+  CountingParser counter;
+  SyntaxCache cache(document, counter.parser());
+  for (std::size_t row = 0; row < document.rows(); ++row) {
+    cache.attributes(row);
+  }
+  
+  document.insert(Selection(Location(1, 1)), "x\ny");
+  REQUIRE(document.rows() == 5);
+  for (std::size_t row = 0; row < document.rows(); ++row) {
+    REQUIRE(AttributeRegistry::shared().name(cache.attributes(row)[0].attribute) == document.row(row));
+  }
+  
+  REQUIRE(counter.calls == 6);
+  
+  document.erase(Selection(Location(0, 0), Location(3, 0)));
+  for (std::size_t row = 0; row < document.rows(); ++row) {
+    REQUIRE(AttributeRegistry::shared().name(cache.attributes(row)[0].attribute) == document.row(row));
+  }
+  
+  REQUIRE(counter.calls == 7);
+}
+
+TEST_CASE("Syntax caches follow random modifications.", "[SyntaxCacheTests]") {
+  std::string text;
+  for (std::size_t row = 0; row < 200; ++row) {
+    text += "row " + std::to_string(row) + "\n";
+  }
+  
+  Document document(text);
+  CountingParser counter;
+  SyntaxCache cache(document, counter.parser());
+  
+  std::mt19937 generator(11);
+  for (std::size_t iteration = 0; iteration < 200; ++iteration) {
+    std::size_t row = generator() % document.rows();
+    std::size_t column = generator() % document.rowLength(row);
+    if (generator() % 2 == 0) {
+      const char* texts[] = { "+", "new\nrow", "/*", "*/" };
+      document.insert(Selection(Location(column, row)), texts[generator() % 4]);
+    } else {
+      std::size_t lastRow = std::min<std::size_t>(row + generator() % 3, document.rows() - 1);
+      std::size_t lastColumn = generator() % document.rowLength(lastRow);
+      if (lastRow > row || lastColumn >= column) {
+        document.erase(Selection(Location(column, row), Location(lastColumn, lastRow)));
+      }
+    }
+    
+    REQUIRE(document.rows() > 0);
+    std::vector<std::string> names = expectedNames(document);
+    for (std::size_t index = 0; index < document.rows(); ++index) {
+      REQUIRE(AttributeRegistry::shared().name(cache.attributes(index)[0].attribute) == names[index]);
+    }
+  }
+}
+
+TEST_CASE("Syntax caches follow modifications past the rows they've prepared.", "[SyntaxCacheTests]") {
+  std::string text;
+  for (std::size_t row = 0; row < 200; ++row) {
+    text += "row " + std::to_string(row) + "\n";
+  }
+  
+  Document document(text);
+  CountingParser counter;
+  
+  // Each cache only prepares some of the rows, then follows a modification near, across or
+  // after the last of them.
+  std::mt19937 generator(12);
+  for (std::size_t iteration = 0; iteration < 200; ++iteration) {
+    SyntaxCache cache(document, counter.parser());
+    std::size_t prepared = generator() % document.rows();
+    cache.prepare(prepared);
+    
+    std::size_t row = std::min<std::size_t>(prepared - std::min<std::size_t>(prepared, generator() % 3) + generator() % 3, document.rows() - 1);
+    std::size_t column = generator() % document.rowLength(row);
+    if (generator() % 2 == 0) {
+      const char* texts[] = { "+", "new\nrow", "/*", "*/" };
+      document.insert(Selection(Location(column, row)), texts[generator() % 4]);
+    } else {
+      std::size_t lastRow = std::min<std::size_t>(row + generator() % 3, document.rows() - 1);
+      std::size_t lastColumn = generator() % document.rowLength(lastRow);
+      if (lastRow > row || lastColumn >= column) {
+        document.erase(Selection(Location(column, row), Location(lastColumn, lastRow)));
+      }
+    }
+    
+    REQUIRE(document.rows() > 0);
+    std::vector<std::string> names = expectedNames(document);
+    for (std::size_t index = 0; index < document.rows(); ++index) {
+      REQUIRE(AttributeRegistry::shared().name(cache.attributes(index)[0].attribute) == names[index]);
+    }
+  }
+}
+
+TEST_CASE("Syntax caches can be invalidated.", "[SyntaxCacheTests]") {
+  Document document("foo\nbar\n");
+  CountingParser counter;
+  SyntaxCache cache(document, counter.parser());
+  
+  cache.attributes(0);
+  cache.invalidate();
+  cache.attributes(0);
+  REQUIRE(counter.calls == 2);
+}
+
+TEST_CASE("Syntax caches carry state from row to row.", "[SyntaxCacheTests]") {
+  Document document("a /* b\nc\nd */ e\nf\n");
+  CountingParser counter;
+  SyntaxCache cache(document, counter.parser());
+  
+  REQUIRE(AttributeRegistry::shared().name(cache.attributes(3)[0].attribute) == "f\n");
+  REQUIRE(AttributeRegistry::shared().name(cache.attributes(1)[0].attribute) == "commentc\n");
+  REQUIRE(AttributeRegistry::shared().name(cache.attributes(2)[0].attribute) == "commentd */ e\n");
+  REQUIRE(counter.calls == 4);
+}
+
+TEST_CASE("Syntax caches stop parsing when an edit doesn't change the state.", "[SyntaxCacheTests]") {
+  std::string text;
+  for (std::size_t row = 0; row < 1000; ++row) {
+    text += "row " + std::to_string(row) + "\n";
+  }
+  
+  Document document(text);
+  CountingParser counter;
+  SyntaxCache cache(document, counter.parser());
+  cache.attributes(999);
+  REQUIRE(counter.calls == 1000);
+  
+  // Editing a row without changing its state only parses that row again.
+  document.insert(Selection(Location(0, 500)), "+");
+  REQUIRE(AttributeRegistry::shared().name(cache.attributes(999)[0].attribute) == "row 999\n");
+  REQUIRE(counter.calls == 1001);
+  
+  // Opening a comment parses every row after it in the new state.
+  counter.calls = 0;
+  document.insert(Selection(Location(0, 500)), "/*");
+  REQUIRE(AttributeRegistry::shared().name(cache.attributes(999)[0].attribute) == "commentrow 999\n");
+  REQUIRE(counter.calls == 500);
+  
+  // Closing it again a few rows later parses only the rows in between.
+  counter.calls = 0;
+  document.insert(Selection(Location(0, 510)), "*/");
+  REQUIRE(AttributeRegistry::shared().name(cache.attributes(999)[0].attribute) == "row 999\n");
+  REQUIRE(counter.calls == 490);
+  
+  counter.calls = 0;
+  document.erase(Selection(Location(0, 510), Location(1, 510)));
+  REQUIRE(AttributeRegistry::shared().name(cache.attributes(520)[0].attribute) == "commentrow 520\n");
+  REQUIRE(counter.calls == 11);
+}
+
+TEST_CASE("Syntax caches parse rows in batches.", "[SyntaxCacheTests]") {
+  std::string text;
+  for (std::size_t row = 0; row < 1000; ++row) {
+    text += "row " + std::to_string(row) + "\n";
+  }
+  
+  Document document(text);
+  std::vector<std::pair<std::size_t, std::size_t>> batches;
+  SyntaxCache cache(document, [&] (std::size_t firstRow, std::size_t lastRow, const std::string& state, std::vector<std::string>& endStates) {
+    batches.emplace_back(firstRow, lastRow);
+    std::vector<RowAttributeRange> results;
+    std::string current = state;
+    for (std::size_t row = firstRow; row <= lastRow; ++row) {
+      std::string text = document.row(row);
+      results.emplace_back(AttributeRegistry::shared().intern(current + text), row, 0, text.size());
+      current = CountingParser::parse(text, current);
+      endStates.emplace_back(current);
+    }
+    
+    return results;
+  });
+  
+  cache.prepare(199);
+  REQUIRE(batches.size() == 1);
+  REQUIRE(batches[0].first == 0);
+  REQUIRE(batches[0].second == 199);
+  
+  // Rows beyond the batch size are split across several batches.
+  cache.prepare(799);
+  REQUIRE(batches.size() == 4);
+  REQUIRE(batches[1].first == 200);
+  REQUIRE(batches[3].second == 799);
+  
+  document.insert(Selection(Location(0, 100)), "/*");
+  document.insert(Selection(Location(0, 102)), "*/");
+  batches.clear();
+  
+  cache.prepare(199);
+  std::vector<std::string> names = expectedNames(document);
+  for (std::size_t row = 0; row < 200; ++row) {
+    REQUIRE(AttributeRegistry::shared().name(cache.attributes(row)[0].attribute) == names[row]);
+  }
+  
+  REQUIRE(batches.size() == 2);
+  REQUIRE(batches[0].first == 100);
+  REQUIRE(batches[0].second == 100);
+  REQUIRE(batches[1].first == 101);
+  REQUIRE(batches[1].second == 102);
+}
@@ -0,0 +1,233 @@
+#include "catch.hpp"
+
+#include "AttributeRegistry.hpp"
+#include "CTokenizer.hpp"
+#include "Document.hpp"
+#include "ScriptHost.hpp"
+#include "Selection.hpp"
+#include "SelectionSet.hpp"
+#include "SyntaxHighlighter.hpp"
+#include "TestScriptHost.hpp"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace quip;
+
+namespace {
+  // Syntax scripts are written to a temporary root, so they need nothing but plain Lua. Each
+  // names a single attribute after its prefix, the depth of braces the row started in, and the
+  // row's text.
+  std::string writeSyntaxScript(const std::string& root, const std::string& name, const std::string& prefix) {
+    std::string path = root + "/" + name + ".lua";
+    std::ofstream stream(path);
+    stream << "return function (line, state)\n"
+           << "  local depth = tonumber(state) or 0\n"
+           << "  local text = (line:gsub(\"\\n\", \"\"))\n"
+           << "  local name = \"" << prefix << "\" .. depth .. \":\" .. text\n"
+           << "  if text:find(\"{\", 1, true) then depth = depth + 1 end\n"
+           << "  if text:find(\"}\", 1, true) then depth = depth - 1 end\n"
+           << "  return { name, 1, #line + 1 }, tostring(depth)\n"
+           << "end\n";
+    
+    return path;
+  }
+  
+  std::string expectedName(const Document& document, std::size_t row, const std::string& prefix) {
+    int depth = 0;
+    for (std::size_t index = 0; index < row; ++index) {
+      const std::string& text = document.row(index);
+      depth += text.find('{') != std::string::npos ? 1 : 0;
+      depth -= text.find('}') != std::string::npos ? 1 : 0;
+    }
+    
+    std::string text = document.row(row);
+    if (!text.empty() && text.back() == '\n') {
+      text.pop_back();
+    }
+    
+    return prefix + std::to_string(depth) + ":" + text;
+  }
+  
+  bool isHighlighted(const SyntaxHighlighter& highlighter, const Document& document, std::size_t row, const std::string& prefix) {
+    AttributeSpan attributes = highlighter.attributes(row);
+    return attributes.size() == 1 && AttributeRegistry::shared().name(attributes[0].attribute) == expectedName(document, row, prefix);
+  }
+  
+  std::string makeText(std::size_t rows) {
+    std::string text;
+    for (std::size_t row = 0; row < rows; ++row) {
+      text += row % 10 == 0 ? "if {\n" : row % 10 == 5 ? "}\n" : "row " + std::to_string(row) + "\n";
+    }
+    
+    return text;
+  }
+}
+
+TEST_CASE("Syntax highlighters highlight the rows they're asked for.", "[SyntaxHighlighterTests]") {
+  TestScriptHost host;
+  std::string root = host.scriptRootPath();
+  Document document(makeText(100));
+  SyntaxHighlighter highlighter(document, host);
+  
+  highlighter.setSyntax(host.getSyntax(writeSyntaxScript(root, "braces", "a")));
+  highlighter.prepare(0, 99);
+  highlighter.wait();
+  
+  for (std::size_t row = 0; row < document.rows(); ++row) {
+    REQUIRE(isHighlighted(highlighter, document, row, "a"));
+  }
+}
+
+TEST_CASE("Syntax highlighters look ahead of the rows they're asked for.", "[SyntaxHighlighterTests]") {
+  TestScriptHost host;
+  std::string root = host.scriptRootPath();
+  Document document(makeText(100));
+  SyntaxHighlighter highlighter(document, host);
+  
+  highlighter.setSyntax(host.getSyntax(writeSyntaxScript(root, "braces", "a")));
+  highlighter.prepare(10, 19);
+  highlighter.wait();
+  
+  for (std::size_t row = 0; row < 10; ++row) {
+    REQUIRE(highlighter.attributes(row).empty());
+  }
+  
+  for (std::size_t row = 10; row < 30; ++row) {
+    REQUIRE(isHighlighted(highlighter, document, row, "a"));
+  }
+  
+  REQUIRE(highlighter.attributes(30).empty());
+}
+
+TEST_CASE("Syntax highlighters move attributes with their rows.", "[SyntaxHighlighterTests]") {
+  TestScriptHost host;
+  std::string root = host.scriptRootPath();
+  Document document(makeText(20));
+  SyntaxHighlighter highlighter(document, host);
+  
+  highlighter.setSyntax(host.getSyntax(writeSyntaxScript(root, "braces", "a")));
+  highlighter.prepare(0, 19);
+  highlighter.wait();
+  
+  std::vector<std::string> names;
+  for (std::size_t row = 0; row < document.rows(); ++row) {
+    names.emplace_back(AttributeRegistry::shared().name(highlighter.attributes(row)[0].attribute));
+  }
+  
+  document.insert(Selection(Location(0, 3)), "x\ny\n");
+  document.erase(Selection(Location(0, 15), Location(0, 16)));
+  
+  REQUIRE(document.rows() == 21);
+  REQUIRE(highlighter.attributes(3).empty());
+  REQUIRE(highlighter.attributes(4).empty());
+  REQUIRE(highlighter.attributes(5).empty());
+  REQUIRE(AttributeRegistry::shared().name(highlighter.attributes(6)[0].attribute) == names[4]);
+  REQUIRE(AttributeRegistry::shared().name(highlighter.attributes(20)[0].attribute) == names[19]);
+  
+  highlighter.prepare(0, 20);
+  highlighter.wait();
+  
+  for (std::size_t row = 0; row < document.rows(); ++row) {
+    REQUIRE(isHighlighted(highlighter, document, row, "a"));
+  }
+}
+
+TEST_CASE("Syntax highlighters discard results for earlier versions of the document.", "[SyntaxHighlighterTests]") {
+  TestScriptHost host;
+  std::string root = host.scriptRootPath();
+  Document document(makeText(20));
+  SyntaxHighlighter highlighter(document, host);
+  
+  highlighter.setSyntax(host.getSyntax(writeSyntaxScript(root, "braces", "a")));
+  highlighter.prepare(0, 19);
+  document.insert(Selection(Location(0, 1)), "{\n");
+  highlighter.wait();
+  
+  for (std::size_t row = 0; row < document.rows(); ++row) {
+    REQUIRE(highlighter.attributes(row).empty());
+  }
+  
+  highlighter.prepare(0, 20);
+  highlighter.wait();
+  
+  for (std::size_t row = 0; row < document.rows(); ++row) {
+    REQUIRE(isHighlighted(highlighter, document, row, "a"));
+  }
+}
+
+TEST_CASE("Syntax highlighters highlight again when the syntax changes.", "[SyntaxHighlighterTests]") {
+  TestScriptHost host;
+  std::string root = host.scriptRootPath();
+  Document document(makeText(20));
+  SyntaxHighlighter highlighter(document, host);
+  Script first = host.getSyntax(writeSyntaxScript(root, "first", "a"));
+  Script second = host.getSyntax(writeSyntaxScript(root, "second", "b"));
+  
+  highlighter.setSyntax(first);
+  highlighter.prepare(0, 19);
+  highlighter.wait();
+  REQUIRE(isHighlighted(highlighter, document, 0, "a"));
+  
+  highlighter.setSyntax(second);
+  REQUIRE(highlighter.attributes(0).empty());
+  
+  highlighter.prepare(0, 19);
+  highlighter.wait();
+  
+  for (std::size_t row = 0; row < document.rows(); ++row) {
+    REQUIRE(isHighlighted(highlighter, document, row, "b"));
+  }
+}
+
+TEST_CASE("Syntax highlighters keep up with a document being edited.", "[SyntaxHighlighterTests]") {
+  TestScriptHost host;
+  std::string root = host.scriptRootPath();
+  Document document(makeText(2000));
+  SyntaxHighlighter highlighter(document, host);
+  
+  highlighter.setSyntax(host.getSyntax(writeSyntaxScript(root, "braces", "a")));
+  for (std::size_t edit = 0; edit < 200; ++edit) {
+    std::size_t row = (edit * 7) % (document.rows() - 1);
+    if (edit % 3 == 0) {
+      document.insert(Selection(Location(0, row)), edit % 2 == 0 ? "{\n" : "}\n");
+    } else {
+      document.erase(Selection(Location(0, row), Location(0, row + 1)));
+    }
+    
+    highlighter.prepare(row, row + 50);
+    highlighter.poll();
+  }
+  
+  highlighter.prepare(0, document.rows() - 1);
+  highlighter.wait();
+  
+  for (std::size_t row = 0; row < document.rows(); ++row) {
+    REQUIRE(isHighlighted(highlighter, document, row, "a"));
+  }
+}
+
+TEST_CASE("Syntax highlighters highlight with native tokenizers when they're given one.", "[SyntaxHighlighterTests]") {
+  TestScriptHost host;
+  std::string root = host.scriptRootPath();
+  Document document("#if A\n/* one\ntwo */ x\n");
+  SyntaxHighlighter highlighter(document, host);
+  
+  highlighter.setSyntax(host.getSyntax(writeSyntaxScript(root, "braces", "a")), std::make_shared<CTokenizer>());
+  highlighter.prepare(0, 2);
+  highlighter.wait();
+  
+  REQUIRE(highlighter.attributes(0).size() == 1);
+  REQUIRE(AttributeRegistry::shared().name(highlighter.attributes(0)[0].attribute) == "Preprocessor");
+  REQUIRE(AttributeRegistry::shared().name(highlighter.attributes(1)[0].attribute) == "Comment");
+  REQUIRE(AttributeRegistry::shared().name(highlighter.attributes(2)[0].attribute) == "Comment");
+  REQUIRE(highlighter.attributes(2)[0].length == 6);
+  
+  // Dropping the tokenizer falls back to the script.
+  highlighter.setSyntax(host.getSyntax(root + "/braces.lua"));
+  highlighter.prepare(0, 2);
+  highlighter.wait();
+  
+  REQUIRE(isHighlighted(highlighter, document, 1, "a"));
+}
@@ -0,0 +1,47 @@
+#include "TestScriptHost.hpp"
+
+#include "catch.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <ftw.h>
+#include <sys/stat.h>
+
+namespace {
+  int removeEntry(const char* path, const struct stat*, int, struct FTW*) {
+    return std::remove(path);
+  }
+}
+
+namespace quip {
+  const char* TestScriptHost::PlainSyntax = "return function (line, state)\n  return {}, state\nend\n";
+  
+  TestScriptRoot::TestScriptRoot() {
+    char directory[] = "/tmp/QuipTests.XXXXXX";
+    REQUIRE(mkdtemp(directory) != nullptr);
+    path = directory;
+    REQUIRE(mkdir((path + "/syntax").c_str(), 0700) == 0);
+  }
+  
+  TestScriptRoot::~TestScriptRoot() {
+    // Entries are visited after everything they contain, so directories are empty by the time
+    // they're removed.
+    nftw(path.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+  }
+  
+  TestScriptHost::TestScriptHost()
+  : TestScriptRoot()
+  , ScriptHost(path) {
+    for (const char* name : {"text", "markdown", "cpp", "glsl"}) {
+      writeScript(std::string("syntax/") + name, PlainSyntax);
+    }
+  }
+  
+  std::string TestScriptHost::writeScript(const std::string& name, const std::string& source) {
+    std::string file = scriptRootPath() + "/" + name + ".lua";
+    std::ofstream stream(file);
+    stream << source;
+    return file;
+  }
+}
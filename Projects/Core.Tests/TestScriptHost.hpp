@@ -0,0 +1,28 @@
+#pragma once
+
+#include "ScriptHost.hpp"
+
+#include <string>
+
+namespace quip {
+  // A temporary directory for scripts, which is removed along with everything written to it.
+  struct TestScriptRoot {
+    TestScriptRoot();
+    ~TestScriptRoot();
+    
+    std::string path;
+  };
+  
+  // A script host for tests. Its root is a temporary directory holding a syntax script for each
+  // of the built-in file types, which marks nothing, so that edit contexts and file type
+  // databases find every script they look for.
+  struct TestScriptHost : private TestScriptRoot, ScriptHost {
+    TestScriptHost();
+    
+    // Write a script to a path relative to the root, returning the full path.
+    std::string writeScript(const std::string& name, const std::string& source);
+    
+    // The source of a syntax script that marks nothing.
+    static const char* PlainSyntax;
+  };
+}
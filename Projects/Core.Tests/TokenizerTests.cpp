@@ -0,0 +1,205 @@
+#include "catch.hpp"
+
+#include "AttributeRegistry.hpp"
+#include "CTokenizer.hpp"
+#include "Document.hpp"
+#include "FileTypeDatabase.hpp"
+#include "PlainTokenizer.hpp"
+#include "Script.hpp"
+#include "ScriptHost.hpp"
+#include "TestScriptHost.hpp"
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace quip;
+
+namespace {
+  // Describe each attribute as "name:start:length".
+  std::vector<std::string> describe(const std::vector<AttributeRange>& attributes) {
+    std::vector<std::string> result;
+    for (const AttributeRange& attribute : attributes) {
+      result.emplace_back(AttributeRegistry::shared().name(attribute.attribute) + ":" + std::to_string(attribute.start) + ":" + std::to_string(attribute.length));
+    }
+    
+    return result;
+  }
+  
+  // Tokenize a row, describing its attributes.
+  std::vector<std::string> describe(const Tokenizer& tokenizer, const std::string& text, const std::string& state, std::string& endState) {
+    std::vector<AttributeRange> attributes;
+    endState = tokenizer.tokenize(text.data(), text.size(), state, attributes);
+    return describe(attributes);
+  }
+}
+
+TEST_CASE("C tokenizers find preprocessor directives.", "[TokenizerTests]") {
+  CTokenizer tokenizer;
+  std::string endState;
+  
+  REQUIRE(describe(tokenizer, "#include <vector>\n", "", endState) == std::vector<std::string>({"Preprocessor:0:8"}));
+  REQUIRE(endState.empty());
+  
+  // The longest directive is taken, whether or not a word follows it.
+  REQUIRE(describe(tokenizer, "#ifndef X\n", "", endState) == std::vector<std::string>({"Preprocessor:0:7"}));
+  REQUIRE(describe(tokenizer, "#ifdefined\n", "", endState) == std::vector<std::string>({"Preprocessor:0:6"}));
+  REQUIRE(describe(tokenizer, "#if x #endif\n", "", endState) == std::vector<std::string>({"Preprocessor:0:3", "Preprocessor:6:6"}));
+  REQUIRE(describe(tokenizer, "a#else\n", "", endState) == std::vector<std::string>({"Preprocessor:1:5"}));
+  
+  REQUIRE(describe(tokenizer, "#pragma once\n", "", endState).empty());
+  REQUIRE(describe(tokenizer, "# define\n", "", endState).empty());
+  REQUIRE(describe(tokenizer, "#", "", endState).empty());
+}
+
+TEST_CASE("C tokenizers find block comments.", "[TokenizerTests]") {
+  CTokenizer tokenizer;
+  std::string endState;
+  
+  REQUIRE(describe(tokenizer, "int x; /* y */ int z;\n", "", endState) == std::vector<std::string>({"Comment:7:7"}));
+  REQUIRE(endState.empty());
+  
+  REQUIRE(describe(tokenizer, "#include <x> /* a\n", "", endState) == std::vector<std::string>({"Preprocessor:0:8", "Comment:13:5"}));
+  REQUIRE(endState == "comment");
+  
+  // The "*/" must follow the "/*" rather than overlap it.
+  REQUIRE(describe(tokenizer, "/*/\n", "", endState) == std::vector<std::string>({"Comment:0:4"}));
+  REQUIRE(endState == "comment");
+  
+  REQUIRE(describe(tokenizer, "x / y * z // #if\n", "", endState) == std::vector<std::string>({"Preprocessor:13:3"}));
+  REQUIRE(endState.empty());
+}
+
+TEST_CASE("C tokenizers continue block comments from the previous row.", "[TokenizerTests]") {
+  CTokenizer tokenizer;
+  std::string endState;
+  
+  REQUIRE(describe(tokenizer, "still a comment\n", "comment", endState) == std::vector<std::string>({"Comment:0:16"}));
+  REQUIRE(endState == "comment");
+  
+  REQUIRE(describe(tokenizer, "b */ int x; /* c */\n", "comment", endState) == std::vector<std::string>({"Comment:0:4", "Comment:12:7"}));
+  REQUIRE(endState.empty());
+  
+  REQUIRE(describe(tokenizer, "*/#endif\n", "comment", endState) == std::vector<std::string>({"Comment:0:2", "Preprocessor:2:6"}));
+  REQUIRE(endState.empty());
+  
+  REQUIRE(describe(tokenizer, "", "comment", endState) == std::vector<std::string>({"Comment:0:0"}));
+  REQUIRE(endState == "comment");
+}
+
+TEST_CASE("Tokenizers thread states through ranges of rows.", "[TokenizerTests]") {
+  CTokenizer tokenizer;
+  Document document("#if A\n/* one\ntwo\nthree */ #else\n#endif\n");
+  
+  std::vector<std::string> endStates;
+  std::vector<RowAttributeRange> attributes = tokenizer.tokenizeRange(document, 1, 4, "", endStates);
+  REQUIRE(endStates == std::vector<std::string>({"comment", "comment", "", ""}));
+  REQUIRE(attributes.size() == 5);
+  REQUIRE(attributes[0].row == 1);
+  REQUIRE(attributes[1].row == 2);
+  REQUIRE(attributes[2].row == 3);
+  REQUIRE(attributes[2].length == 8);
+  REQUIRE(attributes[3].row == 3);
+  REQUIRE(AttributeRegistry::shared().name(attributes[3].attribute) == "Preprocessor");
+  REQUIRE(attributes[3].start == 9);
+  REQUIRE(attributes[4].row == 4);
+  
+  REQUIRE(tokenizer.tokenizeRange(document, 2, 2, "comment", endStates).size() == 1);
+  REQUIRE(endStates == std::vector<std::string>({"comment"}));
+  
+  REQUIRE(tokenizer.tokenizeRange(document, 4, 5, "", endStates).empty());
+  REQUIRE(endStates.empty());
+}
+
+#if defined(QUIP_TESTS_NATIVE_PATH)
+TEST_CASE("C tokenizers mark rows exactly as the C++ syntax script does.", "[TokenizerTests]") {
+  ScriptHost host(QUIP_TESTS_RUNTIME_PATH);
+  host.addNativePackagePath(QUIP_TESTS_NATIVE_PATH);
+  Script script = host.getSyntax(host.scriptRootPath() + "/syntax/cpp.lua");
+  CTokenizer tokenizer;
+  
+  // Rows are built from fragments of comments and directives, and fragments that nearly are.
+  const char* fragments[] = {
+    "#", "include", "if", "ifdef", "ifndef", "else", "endif", "define", "undef", "elif",
+    "/*", "*/", "/", "*", " ", "\t", "x", "<vector>", "\"", "//", "##"
+  };
+  
+  std::mt19937 generator(16);
+  std::uniform_int_distribution<std::size_t> fragmentCount(0, 12);
+  std::uniform_int_distribution<std::size_t> fragment(0, sizeof(fragments) / sizeof(fragments[0]) - 1);
+  
+  std::string scriptState;
+  std::string tokenizerState;
+  for (std::size_t row = 0; row < 5000; ++row) {
+    std::string text;
+    for (std::size_t count = fragmentCount(generator); count > 0; --count) {
+      text += fragments[fragment(generator)];
+    }
+    
+    text += "\n";
+    
+    std::string scriptEndState;
+    std::string tokenizerEndState;
+    std::vector<std::string> expected = describe(host.parseSyntax(script, text, scriptState, scriptEndState));
+    std::vector<std::string> actual = describe(tokenizer, text, tokenizerState, tokenizerEndState);
+    
+    INFO("Row: " << text);
+    REQUIRE(actual == expected);
+    REQUIRE(tokenizerEndState == scriptEndState);
+    scriptState = scriptEndState;
+    tokenizerState = tokenizerEndState;
+  }
+}
+#endif
+
+TEST_CASE("Plain tokenizers find nothing.", "[TokenizerTests]") {
+  PlainTokenizer tokenizer;
+  std::string endState;
+  
+  REQUIRE(describe(tokenizer, "#include /* x */\n", "comment", endState).empty());
+  REQUIRE(endState.empty());
+}
+
+TEST_CASE("File types use native tokenizers when there are any.", "[TokenizerTests]") {
+  TestScriptHost host;
+  host.writeScript("syntax/lisp", TestScriptHost::PlainSyntax);
+  FileTypeDatabase database(host);
+  std::shared_ptr<const Tokenizer> c = std::make_shared<CTokenizer>();
+  std::shared_ptr<const Tokenizer> plain = std::make_shared<PlainTokenizer>();
+  database.registerTokenizer("cpp", c);
+  database.registerTokenizer("markdown", plain);
+  database.registerFileType("C++ Source", "cpp", {"cpp"});
+  database.registerFileType("C++ Header", "cpp", {"hpp"});
+  database.registerFileType("Markdown", "markdown", {"md"});
+  database.registerFileType("Lisp", "lisp", {"lisp"});
+  
+  REQUIRE(database.lookupByExtension("cpp")->tokenizer == c);
+  REQUIRE(database.lookupByExtension("hpp")->tokenizer == c);
+  REQUIRE(database.lookupByExtension("md")->tokenizer == plain);
+  
+  // Other syntaxes fall back to their scripts.
+  REQUIRE(database.lookupByExtension("lisp")->tokenizer == nullptr);
+  REQUIRE(database.lookupByExtension("lisp")->syntax.identifier() == host.scriptRootPath() + "/syntax/lisp.lua");
+  REQUIRE(database.lookupByExtension("unknown")->tokenizer == nullptr);
+}
+
+TEST_CASE("File types pick up tokenizers registered after them.", "[TokenizerTests]") {
+  TestScriptHost host;
+  FileTypeDatabase database(host);
+  database.registerFileType("C++ Source", "cpp", {"cpp"});
+  database.registerFileType("Text", "text", {"txt"});
+  
+  std::shared_ptr<const Tokenizer> c = std::make_shared<CTokenizer>();
+  std::shared_ptr<const Tokenizer> plain = std::make_shared<PlainTokenizer>();
+  database.registerTokenizer("cpp", c);
+  database.registerTokenizer("text", plain);
+  REQUIRE(database.lookupByExtension("cpp")->tokenizer == c);
+  REQUIRE(database.lookupByExtension("txt")->tokenizer == plain);
+  REQUIRE(database.lookupByExtension("unknown")->tokenizer == plain);
+  
+  // Registering a null tokenizer goes back to the script.
+  database.registerTokenizer("cpp", nullptr);
+  REQUIRE(database.lookupByExtension("cpp")->tokenizer == nullptr);
+  REQUIRE(database.lookupByExtension("cpp")->syntax.identifier() == host.scriptRootPath() + "/syntax/cpp.lua");
+}
@@ -0,0 +1,484 @@
+#include "catch.hpp"
+
+#include "AppendTransaction.hpp"
+#include "Document.hpp"
+#include "EditContext.hpp"
+#include "EraseTransaction.hpp"
+#include "InsertTransaction.hpp"
+#include "Selection.hpp"
+#include "SelectionSet.hpp"
+#include "TestScriptHost.hpp"
+#include "UndoLog.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace quip;
+
+namespace {
+  std::string makeText(std::size_t rows) {
+    std::string text;
+    for (std::size_t row = 0; row < rows; ++row) {
+      text += "row " + std::to_string(row) + "\n";
+    }
+    
+    return text;
+  }
+  
+  // Insert text at the given selections, recording it as a step of its own.
+  void insert(UndoLog& log, Document& document, SelectionSet& selections, const SelectionSet& at, const std::vector<std::string>& text) {
+    log.beginStep(selections);
+    log.recordInsertion(document, at, text);
+    selections = document.insert(at, text);
+    log.endStep(document, selections);
+  }
+  
+  void erase(UndoLog& log, Document& document, SelectionSet& selections, const SelectionSet& at) {
+    log.beginStep(selections);
+    log.recordErasure(document, at);
+    selections = document.erase(at);
+    log.endStep(document, selections);
+  }
+  
+  // The location of a random character in the document, or (0, 0) if it's empty. Only the
+  // last row can be empty, and it has no characters to choose from.
+  Location randomLocation(std::mt19937& generator, const Document& document) {
+    std::size_t rows = document.rows();
+    if (rows > 0 && document.rowLength(rows - 1) == 0) {
+      --rows;
+    }
+    
+    if (rows == 0) {
+      return Location(0, 0);
+    }
+    
+    std::size_t row = generator() % rows;
+    return Location(generator() % document.rowLength(row), row);
+  }
+}
+
+TEST_CASE("Undo logs undo and redo insertions.", "[UndoLogTests]") {
+  Document document("abc\ndef\n");
+  SelectionSet selections(Selection(Location(1, 0)));
+  UndoLog log;
+  
+  REQUIRE_FALSE(log.canUndo());
+  insert(log, document, selections, selections, {"xy\nz"});
+  REQUIRE(document.contents() == "axy\nzbc\ndef\n");
+  REQUIRE(log.canUndo());
+  REQUIRE_FALSE(log.canRedo());
+  
+  REQUIRE(log.undo(document, selections));
+  REQUIRE(document.contents() == "abc\ndef\n");
+  REQUIRE(selections.count() == 1);
+  REQUIRE(selections[0] == Selection(Location(1, 0)));
+  REQUIRE_FALSE(log.canUndo());
+  REQUIRE_FALSE(log.undo(document, selections));
+  
+  REQUIRE(log.redo(document, selections));
+  REQUIRE(document.contents() == "axy\nzbc\ndef\n");
+  REQUIRE(selections[0] == Selection(Location(1, 1)));
+  REQUIRE_FALSE(log.redo(document, selections));
+}
+
+TEST_CASE("Undo logs undo and redo erasures with several selections.", "[UndoLogTests]") {
+  Document document("one\ntwo\nthree\n");
+  std::vector<Selection> erased = {
+    Selection(Location(1, 0), Location(3, 0)),
+    Selection(Location(2, 1), Location(1, 2)),
+  };
+  
+  SelectionSet selections(erased);
+  selections.rotateForward();
+  UndoLog log;
+  
+  erase(log, document, selections, selections);
+  REQUIRE(document.contents() == "otwree\n");
+  
+  REQUIRE(log.undo(document, selections));
+  REQUIRE(document.contents() == "one\ntwo\nthree\n");
+  REQUIRE(selections.count() == 2);
+  REQUIRE(selections[0] == erased[0]);
+  REQUIRE(selections[1] == erased[1]);
+  REQUIRE(selections.primary() == erased[1]);
+  
+  REQUIRE(log.redo(document, selections));
+  REQUIRE(document.contents() == "otwree\n");
+}
+
+TEST_CASE("Undo logs replay random edits in both directions.", "[UndoLogTests]") {
+  Document document(makeText(300));
+  SelectionSet selections(Selection(Location(0, 0)));
+  UndoLog log;
+  
+  std::mt19937 generator(21);
+  std::vector<std::string> history(1, document.contents());
+  for (std::size_t edit = 0; edit < 400; ++edit) {
+    std::vector<Selection> at;
+    for (std::size_t count = generator() % 3 + 1; count > 0; --count) {
+      Location origin = randomLocation(generator, document);
+      if (edit % 2 == 0) {
+        at.emplace_back(origin);
+      } else {
+        Location extent = randomLocation(generator, document);
+        at.emplace_back(std::min(origin, extent), std::max(origin, extent));
+      }
+    }
+    
+    if (edit % 2 == 0) {
+      std::vector<std::string> text = {"a", "bc\n", "\nd\ne"};
+      std::shuffle(text.begin(), text.end(), generator);
+      insert(log, document, selections, SelectionSet(at), text);
+    } else {
+      erase(log, document, selections, SelectionSet(at));
+    }
+    
+    history.emplace_back(document.contents());
+  }
+  
+  REQUIRE(log.steps() == 400);
+  for (std::size_t step = history.size() - 1; step > 0; --step) {
+    REQUIRE(log.undo(document, selections));
+    REQUIRE(document.contents() == history[step - 1]);
+  }
+  
+  REQUIRE_FALSE(log.canUndo());
+  for (std::size_t step = 1; step < history.size(); ++step) {
+    REQUIRE(log.redo(document, selections));
+    REQUIRE(document.contents() == history[step]);
+  }
+}
+
+TEST_CASE("Undo logs keep steps that were undone on a branch of their own.", "[UndoLogTests]") {
+  Document document("abc\n");
+  SelectionSet selections(Selection(Location(0, 0)));
+  UndoLog log;
+  
+  insert(log, document, selections, selections, {"x"});
+  insert(log, document, selections, selections, {"y"});
+  std::size_t y = log.currentStep();
+  REQUIRE(log.undo(document, selections));
+  REQUIRE(log.canRedo());
+  
+  insert(log, document, selections, selections, {"z"});
+  std::size_t z = log.currentStep();
+  REQUIRE(document.contents() == "xzabc\n");
+  REQUIRE(log.steps() == 3);
+  REQUIRE_FALSE(log.canRedo());
+  
+  // Redoing follows the branch that was visited last.
+  REQUIRE(log.undo(document, selections));
+  REQUIRE(log.redo(document, selections));
+  REQUIRE(document.contents() == "xzabc\n");
+  
+  REQUIRE(log.travel(document, selections, y));
+  REQUIRE(document.contents() == "xyabc\n");
+  REQUIRE(selections[0] == Selection(Location(2, 0)));
+  REQUIRE(log.undo(document, selections));
+  REQUIRE(log.redo(document, selections));
+  REQUIRE(document.contents() == "xyabc\n");
+  
+  REQUIRE(log.travel(document, selections, z));
+  REQUIRE(document.contents() == "xzabc\n");
+  REQUIRE_FALSE(log.travel(document, selections, UndoLog::NoStep));
+  
+  // Steps that change nothing aren't kept at all.
+  insert(log, document, selections, selections, {""});
+  REQUIRE(log.steps() == 3);
+}
+
+TEST_CASE("Undo logs travel to any step on any branch.", "[UndoLogTests]") {
+  Document document(makeText(300));
+  SelectionSet selections(Selection(Location(0, 0)));
+  UndoLog log;
+  
+  // Enough edits are made down each branch for some of them to be checkpoints.
+  std::mt19937 generator(31);
+  std::map<std::size_t, std::string> states;
+  for (std::size_t edit = 0; edit < 1000; ++edit) {
+    if (generator() % 8 == 0) {
+      for (std::size_t count = generator() % 8; count > 0 && log.canUndo(); --count) {
+        log.undo(document, selections);
+      }
+    }
+    
+    Location origin = randomLocation(generator, document);
+    if (edit % 3 == 2) {
+      // Erasures are kept short, so that the document doesn't run out of text.
+      Location extent = randomLocation(generator, document);
+      Location first = std::min(origin, extent);
+      Location last = std::max(origin, extent);
+      erase(log, document, selections, SelectionSet(Selection(first, last.row() > first.row() + 2 ? first : last)));
+    } else {
+      insert(log, document, selections, SelectionSet(Selection(origin)), {edit % 3 == 0 ? "a" : "bc\nd"});
+    }
+    
+    states[log.currentStep()] = document.contents();
+  }
+  
+  for (std::size_t jump = 0; jump < 300; ++jump) {
+    std::size_t step = std::next(states.begin(), generator() % states.size())->first;
+    REQUIRE(log.travel(document, selections, step));
+    REQUIRE(log.currentStep() == step);
+    REQUIRE(document.contents() == states[step]);
+  }
+  
+  // Undoing and redoing carry on from wherever travelling left off.
+  std::string contents = document.contents();
+  std::size_t undone = 0;
+  while (log.canUndo()) {
+    REQUIRE(log.undo(document, selections));
+    ++undone;
+  }
+  
+  REQUIRE(document.contents() == makeText(300));
+  for (; undone > 0; --undone) {
+    REQUIRE(log.redo(document, selections));
+  }
+  
+  REQUIRE(document.contents() == contents);
+}
+
+TEST_CASE("Undo logs find the step made at a given time.", "[UndoLogTests]") {
+  Document document("abc\n");
+  SelectionSet selections(Selection(Location(0, 0)));
+  UndoLog log;
+  
+  REQUIRE(log.findStep(UndoLog::Clock::now()) == UndoLog::NoStep);
+  insert(log, document, selections, selections, {"a"});
+  std::size_t first = log.currentStep();
+  
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  UndoLog::Clock::time_point time = UndoLog::Clock::now();
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  
+  insert(log, document, selections, selections, {"b"});
+  insert(log, document, selections, selections, {"c"});
+  REQUIRE(log.findStep(time) == first);
+  REQUIRE(log.findStep(UndoLog::Clock::now()) == log.currentStep());
+  
+  REQUIRE(log.travel(document, selections, log.findStep(time)));
+  REQUIRE(document.contents() == "aabc\n");
+}
+
+TEST_CASE("Undo logs evict their oldest steps to stay within their capacity.", "[UndoLogTests]") {
+  Document document(makeText(100));
+  SelectionSet selections(Selection(Location(0, 50)));
+  UndoLog log(4096);
+  
+  std::vector<std::string> history(1, document.contents());
+  for (std::size_t edit = 0; edit < 2000; ++edit) {
+    insert(log, document, selections, selections, {"typed "});
+    history.emplace_back(document.contents());
+    REQUIRE(log.footprint() <= log.capacity());
+  }
+  
+  REQUIRE(log.steps() > 1);
+  REQUIRE(log.steps() < 2000);
+  
+  // The steps that remain still undo to the states they were made from.
+  std::size_t steps = log.steps();
+  for (std::size_t step = 0; step < steps; ++step) {
+    REQUIRE(log.undo(document, selections));
+  }
+  
+  REQUIRE_FALSE(log.canUndo());
+  REQUIRE(document.contents() == history[history.size() - 1 - steps]);
+  
+  // Shrinking the capacity evicts all but the newest step, even though it could only be
+  // redone, and the steps before it are gone.
+  log.setCapacity(0);
+  REQUIRE(log.steps() == 1);
+  REQUIRE_FALSE(log.canRedo());
+  REQUIRE(document.contents() == history[history.size() - 1 - steps]);
+}
+
+TEST_CASE("Undo logs count their checkpoints against their capacity.", "[UndoLogTests]") {
+  // Edits spread across a large document leave each checkpoint holding rows that the document
+  // no longer shares with it, so far fewer steps fit in the same capacity than for edits to a
+  // small document.
+  std::mt19937 generator(7);
+  std::size_t steps[2];
+  std::size_t rows[2] = {100, 100000};
+  for (std::size_t trial = 0; trial < 2; ++trial) {
+    Document document(makeText(rows[trial]));
+    SelectionSet selections(Selection(Location(0, 0)));
+    UndoLog log(1024 * 1024);
+    for (std::size_t edit = 0; edit < 1000; ++edit) {
+      SelectionSet at(Selection(Location(0, generator() % rows[trial])));
+      insert(log, document, selections, at, {"typed "});
+      REQUIRE(log.footprint() <= log.capacity());
+    }
+    
+    steps[trial] = log.steps();
+  }
+  
+  REQUIRE(steps[0] == 1000);
+  REQUIRE(steps[1] < steps[0] / 2);
+}
+
+TEST_CASE("Undo logs merge operations that continue each other.", "[UndoLogTests]") {
+  Document document("abc\n");
+  SelectionSet selections(Selection(Location(1, 0)));
+  UndoLog log;
+  
+  // Typing, then erasing some of what was typed.
+  log.beginStep(selections);
+  for (std::size_t index = 0; index < 1000; ++index) {
+    log.recordInsertion(document, selections, {"x"});
+    selections = document.insert(selections, "x");
+  }
+  
+  for (std::size_t index = 0; index < 10; ++index) {
+    SelectionSet previous(Selection(selections[0].origin().adjustBy(-1, 0)));
+    log.recordErasure(document, previous);
+    selections = document.erase(previous);
+  }
+  
+  // Erasing backwards past the start of the typing, then forwards.
+  SelectionSet before(Selection(Location(0, 0)));
+  log.recordErasure(document, before);
+  selections = document.erase(before);
+  log.recordErasure(document, selections);
+  selections = document.erase(selections);
+  log.endStep(document, selections);
+  
+  REQUIRE(document.contents() == std::string(989, 'x') + "bc\n");
+  // The step holds little more than the text that was typed.
+  REQUIRE(log.footprint() < 1100);
+  
+  REQUIRE(log.undo(document, selections));
+  REQUIRE(document.contents() == "abc\n");
+  REQUIRE(log.redo(document, selections));
+  REQUIRE(document.contents() == std::string(989, 'x') + "bc\n");
+}
+
+TEST_CASE("Undo logs resume the step that was finished last.", "[UndoLogTests]") {
+  Document document("abc\n");
+  SelectionSet selections(Selection(Location(1, 0)));
+  UndoLog log;
+  
+  REQUIRE_FALSE(log.resumeStep());
+  
+  insert(log, document, selections, selections, {"x"});
+  REQUIRE(log.resumeStep());
+  REQUIRE(log.isRecording());
+  log.recordInsertion(document, selections, {"y"});
+  selections = document.insert(selections, "y");
+  log.endStep(document, selections);
+  
+  REQUIRE(log.steps() == 1);
+  REQUIRE(log.undo(document, selections));
+  REQUIRE(document.contents() == "abc\n");
+  REQUIRE(selections[0] == Selection(Location(1, 0)));
+  
+  // Steps that were undone can't be resumed, even once they've been redone.
+  REQUIRE_FALSE(log.resumeStep());
+  REQUIRE(log.redo(document, selections));
+  REQUIRE_FALSE(log.resumeStep());
+  
+  // A resumed step that ends up changing nothing is dropped.
+  insert(log, document, selections, selections, {"z"});
+  REQUIRE(log.resumeStep());
+  SelectionSet previous(Selection(selections[0].origin().adjustBy(-1, 0)));
+  log.recordErasure(document, previous);
+  selections = document.erase(previous);
+  log.endStep(document, selections);
+  
+  REQUIRE(log.steps() == 1);
+  REQUIRE_FALSE(log.resumeStep());
+  REQUIRE(document.contents() == "axybc\n");
+}
+
+TEST_CASE("Edit contexts undo and redo transactions through their undo logs.", "[UndoLogTests]") {
+  TestScriptHost host;
+  std::shared_ptr<Document> document = std::make_shared<Document>("abc\ndef\n");
+  EditContext context(nullptr, nullptr, &host, document);
+  
+  context.selections().replace(Selection(Location(1, 0)));
+  context.performTransaction(InsertTransaction::create(context.selections(), "x"));
+  context.performTransaction(AppendTransaction::create(context.selections(), "y"));
+  context.performTransaction(EraseTransaction::create(SelectionSet(Selection(Location(5, 0)))));
+  REQUIRE(document->contents() == "axbycdef\n");
+  
+  context.undo();
+  REQUIRE(document->contents() == "axbyc\ndef\n");
+  context.undo();
+  REQUIRE(document->contents() == "axbc\ndef\n");
+  context.undo();
+  REQUIRE(document->contents() == "abc\ndef\n");
+  REQUIRE(context.selections()[0] == Selection(Location(1, 0)));
+  REQUIRE_FALSE(context.canUndo());
+  
+  context.redo();
+  context.redo();
+  context.redo();
+  REQUIRE(document->contents() == "axbycdef\n");
+  REQUIRE_FALSE(context.canRedo());
+}
+
+TEST_CASE("Edit contexts coalesce runs of typing into one step.", "[UndoLogTests]") {
+  TestScriptHost host;
+  std::shared_ptr<Document> document = std::make_shared<Document>("abc\ndef\n");
+  EditContext context(nullptr, nullptr, &host, document);
+  
+  context.enterMode("EditMode");
+  context.selections().replace(Selection(Location(1, 0)));
+  for (char character : std::string("hello")) {
+    context.processKeyEvent(Key::A, Modifiers(), std::string(1, character));
+  }
+  
+  context.processKeyEvent(Key::Delete, Modifiers(), "");
+  REQUIRE(document->contents() == "ahellbc\ndef\n");
+  REQUIRE(context.undoLog().steps() == 1);
+  
+  // Moving the cursor starts a new step.
+  context.selections().replace(Selection(Location(0, 1)));
+  context.processKeyEvent(Key::A, Modifiers(), "x");
+  context.processKeyEvent(Key::A, Modifiers(), "y");
+  REQUIRE(context.undoLog().steps() == 2);
+  
+  // So does leaving the mode.
+  context.leaveMode();
+  context.enterMode("EditMode");
+  context.processKeyEvent(Key::A, Modifiers(), "z");
+  REQUIRE(document->contents() == "ahellbc\nxyzdef\n");
+  REQUIRE(context.undoLog().steps() == 3);
+  
+  context.undo();
+  REQUIRE(document->contents() == "ahellbc\nxydef\n");
+  context.undo();
+  REQUIRE(document->contents() == "ahellbc\ndef\n");
+  context.undo();
+  REQUIRE(document->contents() == "abc\ndef\n");
+  REQUIRE(context.selections()[0] == Selection(Location(1, 0)));
+  REQUIRE_FALSE(context.canUndo());
+}
+
+TEST_CASE("Edit contexts travel back to how the document was at a given time.", "[UndoLogTests]") {
+  TestScriptHost host;
+  std::shared_ptr<Document> document = std::make_shared<Document>("abc\n");
+  EditContext context(nullptr, nullptr, &host, document);
+  
+  context.performTransaction(InsertTransaction::create(context.selections(), "x"));
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  UndoLog::Clock::time_point time = UndoLog::Clock::now();
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  
+  context.performTransaction(InsertTransaction::create(context.selections(), "y"));
+  context.undo();
+  context.performTransaction(InsertTransaction::create(context.selections(), "z"));
+  REQUIRE(document->contents() == "xzabc\n");
+  
+  context.travelTo(time);
+  REQUIRE(document->contents() == "xabc\n");
+  REQUIRE(context.selections()[0] == Selection(Location(1, 0)));
+  context.redo();
+  REQUIRE(document->contents() == "xzabc\n");
+}
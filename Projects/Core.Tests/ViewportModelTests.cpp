@@ -0,0 +1,211 @@
+#include "catch.hpp"
+
+#include "Document.hpp"
+#include "RecordingDrawingService.hpp"
+#include "SelectionDrawInfo.hpp"
+#include "SyntaxHighlighter.hpp"
+#include "TestScriptHost.hpp"
+#include "ViewportModel.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace quip;
+
+namespace {
+  std::string makeText(std::size_t rows) {
+    std::string text;
+    for (std::size_t row = 0; row < rows; ++row) {
+      text += "row " + std::to_string(row) + "\n";
+    }
+    
+    return text;
+  }
+  
+  ViewportModel makeViewport(std::size_t rows, float scrollOffset, float height) {
+    ViewportModel viewport;
+    viewport.setCellSize(Extent(8.0f, 10.0f));
+    viewport.setRows(rows);
+    viewport.setViewport(scrollOffset, height);
+    return viewport;
+  }
+}
+
+TEST_CASE("Viewports map their scroll offset to the rows in view.", "[ViewportModelTests]") {
+  ViewportModel viewport = makeViewport(1000, 0.0f, 100.0f);
+  REQUIRE(viewport.hasVisibleRows());
+  REQUIRE(viewport.firstVisibleRow() == 0);
+  REQUIRE(viewport.lastVisibleRow() == 9);
+  
+  // Rows partly in view are visible.
+  viewport.setViewport(55.0f, 100.0f);
+  REQUIRE(viewport.firstVisibleRow() == 5);
+  REQUIRE(viewport.lastVisibleRow() == 15);
+  
+  viewport.setViewport(9990.0f, 100.0f);
+  REQUIRE(viewport.firstVisibleRow() == 999);
+  REQUIRE(viewport.lastVisibleRow() == 999);
+  
+  viewport.setViewport(10000.0f, 100.0f);
+  REQUIRE_FALSE(viewport.hasVisibleRows());
+}
+
+TEST_CASE("Viewports without rows or height show nothing.", "[ViewportModelTests]") {
+  REQUIRE_FALSE(makeViewport(0, 0.0f, 100.0f).hasVisibleRows());
+  REQUIRE_FALSE(makeViewport(10, 0.0f, 0.0f).hasVisibleRows());
+  
+  ViewportModel viewport;
+  viewport.setRows(10);
+  viewport.setViewport(0.0f, 100.0f);
+  REQUIRE_FALSE(viewport.hasVisibleRows());
+}
+
+TEST_CASE("Viewports find the rows within a band of the document.", "[ViewportModelTests]") {
+  ViewportModel viewport = makeViewport(1000, 200.0f, 100.0f);
+  std::size_t firstRow = 0;
+  std::size_t lastRow = 0;
+  
+  REQUIRE(viewport.findRows(225.0f, 240.0f, firstRow, lastRow));
+  REQUIRE(firstRow == 22);
+  REQUIRE(lastRow == 23);
+  
+  // Bands are clipped to the viewport.
+  REQUIRE(viewport.findRows(0.0f, 215.0f, firstRow, lastRow));
+  REQUIRE(firstRow == 20);
+  REQUIRE(lastRow == 21);
+  
+  REQUIRE(viewport.findRows(250.0f, 10000.0f, firstRow, lastRow));
+  REQUIRE(firstRow == 25);
+  REQUIRE(lastRow == 29);
+  
+  REQUIRE_FALSE(viewport.findRows(0.0f, 200.0f, firstRow, lastRow));
+  REQUIRE_FALSE(viewport.findRows(300.0f, 400.0f, firstRow, lastRow));
+  REQUIRE_FALSE(viewport.findRows(240.0f, 240.0f, firstRow, lastRow));
+}
+
+TEST_CASE("Viewports draw only the rows in view.", "[ViewportModelTests]") {
+  TestScriptHost host;
+  Document document(makeText(100000));
+  SyntaxHighlighter highlighter(document, host);
+  RecordingDrawingService service(Extent(8.0f, 10.0f));
+  
+  ViewportModel viewport;
+  viewport.setCellSize(service.cellSize());
+  viewport.setRows(document.rows());
+  viewport.setViewport(50000.0f, 100.0f);
+  
+  // The view's frame is as tall as the document, with the first row at the top.
+  Rectangle frame(1.0f, 0.0f, 800.0f, 10.0f * (document.rows() + 1));
+  viewport.drawText(service, document, highlighter, frame, 0.0f, frame.height());
+  
+  const std::vector<RecordingDrawingService::Command>& commands = service.commands();
+  REQUIRE(commands.size() == 10);
+  for (std::size_t index = 0; index < commands.size(); ++index) {
+    REQUIRE(commands[index].type == RecordingDrawingService::CommandType::DrawText);
+    REQUIRE(service.text(commands[index]) == document.row(5000 + index));
+    REQUIRE(commands[index].coordinate.x == 1.0f);
+    REQUIRE(commands[index].coordinate.y == frame.height() - 10.0f * (5000 + index + 1));
+  }
+  
+  // Only the part of the viewport that needs drawing is drawn.
+  service.clear();
+  viewport.drawText(service, document, highlighter, frame, 50020.0f, 50030.0f);
+  REQUIRE(service.commands().size() == 1);
+  REQUIRE(service.text(service.commands()[0]) == document.row(5002));
+}
+
+TEST_CASE("Viewports never draw past the end of the document.", "[ViewportModelTests]") {
+  TestScriptHost host;
+  Document document(makeText(3));
+  SyntaxHighlighter highlighter(document, host);
+  RecordingDrawingService service(Extent(8.0f, 10.0f));
+  
+  // The viewport may be stale, with more rows than the document now has.
+  ViewportModel viewport = makeViewport(10, 0.0f, 100.0f);
+  Rectangle frame(0.0f, 0.0f, 800.0f, 100.0f);
+  viewport.drawText(service, document, highlighter, frame, 0.0f, 100.0f);
+  REQUIRE(service.commands().size() == 3);
+}
+
+TEST_CASE("Viewports draw only the rows of selections in view.", "[ViewportModelTests]") {
+  Document document(makeText(1000));
+  RecordingDrawingService service(Extent(8.0f, 10.0f));
+  ViewportModel viewport = makeViewport(document.rows(), 1000.0f, 100.0f);
+  Rectangle frame(0.0f, 0.0f, 800.0f, 10.0f * (document.rows() + 1));
+  
+  SelectionDrawInfo drawInfo;
+  drawInfo.primaryColor = Color::red();
+  drawInfo.secondaryColor = Color::blue();
+  drawInfo.style = CursorStyle::VerticalBlock;
+  drawInfo.flags = CursorFlags::None;
+  drawInfo.selections = SelectionSet(std::vector<Selection>({
+    Selection(Location(2, 0), Location(3, 104)),
+    Selection(Location(1, 105)),
+    Selection(Location(0, 500))
+  }));
+  
+  viewport.drawSelections(service, document, drawInfo, frame, true);
+  
+  // The selection from the top of the document is drawn across the five rows of it in view,
+  // and the cursor in view after them; the cursor out of view isn't drawn.
+  const std::vector<RecordingDrawingService::Command>& commands = service.commands();
+  REQUIRE(commands.size() == 6);
+  REQUIRE(commands[0].type == RecordingDrawingService::CommandType::FillRectangle);
+  REQUIRE(commands[0].rectangle.x() == 0.0f);
+  REQUIRE(commands[0].rectangle.y() == frame.height() - 10.0f * 101 - 2.0f);
+  REQUIRE(commands[0].rectangle.width() == 8.0f * document.rowLength(100));
+  REQUIRE(commands[5].rectangle.x() == 8.0f);
+  REQUIRE(commands[5].rectangle.width() == 8.0f);
+  
+  std::size_t primaries = 0;
+  for (const RecordingDrawingService::Command& command : commands) {
+    primaries += command.color.r() == 1.0f ? 1 : 0;
+  }
+  
+  REQUIRE(primaries == 5);
+}
+
+TEST_CASE("Viewports draw only the selections in view of a set with one on every row.", "[ViewportModelTests]") {
+  Document document(makeText(1000));
+  RecordingDrawingService service(Extent(8.0f, 10.0f));
+  ViewportModel viewport = makeViewport(document.rows(), 1000.0f, 100.0f);
+  Rectangle frame(0.0f, 0.0f, 800.0f, 10.0f * (document.rows() + 1));
+  
+  std::vector<Selection> selections;
+  for (std::size_t row = 0; row < document.rows(); ++row) {
+    selections.emplace_back(Location(0, row), Location(1, row));
+  }
+  
+  SelectionDrawInfo drawInfo;
+  drawInfo.style = CursorStyle::VerticalBarAtOrigin;
+  drawInfo.flags = CursorFlags::None;
+  drawInfo.selections = SelectionSet(selections);
+  
+  viewport.drawSelections(service, document, drawInfo, frame, true);
+  
+  const std::vector<RecordingDrawingService::Command>& commands = service.commands();
+  REQUIRE(commands.size() == 10);
+  for (std::size_t index = 0; index < commands.size(); ++index) {
+    REQUIRE(commands[index].location == Location(0, 100 + index));
+  }
+}
+
+TEST_CASE("Viewports draw blinking cursors only while they're shown.", "[ViewportModelTests]") {
+  Document document(makeText(10));
+  RecordingDrawingService service(Extent(8.0f, 10.0f));
+  ViewportModel viewport = makeViewport(document.rows(), 0.0f, 100.0f);
+  Rectangle frame(0.0f, 0.0f, 800.0f, 110.0f);
+  
+  SelectionDrawInfo drawInfo;
+  drawInfo.style = CursorStyle::VerticalBarAtOrigin;
+  drawInfo.flags = CursorFlags::Blink;
+  drawInfo.selections = SelectionSet(Selection(Location(4, 2)));
+  
+  viewport.drawSelections(service, document, drawInfo, frame, false);
+  REQUIRE(service.commands().empty());
+  
+  viewport.drawSelections(service, document, drawInfo, frame, true);
+  REQUIRE(service.commands().size() == 1);
+  REQUIRE(service.commands()[0].type == RecordingDrawingService::CommandType::DrawBarBefore);
+  REQUIRE(service.commands()[0].location == Location(4, 2));
+}
@@ -1,7 +1,10 @@
 #include "AppendTransaction.hpp"
 
 #include "Document.hpp"
+#include "DocumentIterator.hpp"
 #include "EditContext.hpp"
+#include "Selection.hpp"
+#include "UndoLog.hpp"
 
 namespace quip {
   AppendTransaction::AppendTransaction(const SelectionSet& selections, const std::vector<std::string>& text)
@@ -13,12 +16,24 @@ namespace quip {
   }
   
   void AppendTransaction::perform(EditContext& context) {
-    m_rollbackSelections = context.document().append(m_selections, m_text);
-    context.selections().replace(m_rollbackSelections);
-  }
-  
-  void AppendTransaction::rollback(EditContext& context) {
-    context.selections().replace(context.document().erase(m_rollbackSelections));
+    // Text is appended by inserting it after the extent of each selection. The insertion
+    // points are found up front so that the insertion can be recorded before it's made.
+    Document& document = context.document();
+    std::vector<Selection> adjusted;
+    adjusted.reserve(m_selections.count());
+    for (const Selection& selection : m_selections) {
+      DocumentIterator iterator = document.at(selection.extent());
+      if (iterator != document.end()) {
+        ++iterator;
+      }
+      
+      adjusted.emplace_back(iterator.location());
+    }
+    
+    SelectionSet locations(adjusted);
+    context.undoLog().recordInsertion(document, locations, m_text);
+    document.insert(locations, m_text);
+    context.selections().replace(locations);
   }
   
   std::shared_ptr<Transaction> AppendTransaction::create(const SelectionSet& selections, const std::string& text) {
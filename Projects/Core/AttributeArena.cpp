@@ -0,0 +1,134 @@
+#include "AttributeArena.hpp"
+
+#include "DocumentChange.hpp"
+
+#include <algorithm>
+
+namespace {
+  // Abandoned ranges are only reclaimed once there are at least this many of them, and more of
+  // them than there are ranges in use.
+  const std::size_t MinimumAbandonedRuns = 4096;
+}
+
+namespace quip {
+  AttributeSpan::AttributeSpan()
+  : m_first(nullptr)
+  , m_last(nullptr) {
+  }
+  
+  AttributeSpan::AttributeSpan(const AttributeRange* first, const AttributeRange* last)
+  : m_first(first)
+  , m_last(last) {
+  }
+  
+  const AttributeRange* AttributeSpan::begin() const {
+    return m_first;
+  }
+  
+  const AttributeRange* AttributeSpan::end() const {
+    return m_last;
+  }
+  
+  std::size_t AttributeSpan::size() const {
+    return m_last - m_first;
+  }
+  
+  bool AttributeSpan::empty() const {
+    return m_first == m_last;
+  }
+  
+  const AttributeRange& AttributeSpan::operator[](std::size_t index) const {
+    return m_first[index];
+  }
+  
+  AttributeArena::AttributeArena()
+  : m_abandonedRuns(0) {
+  }
+  
+  AttributeArena::AttributeArena(std::size_t rows)
+  : m_rows(rows, RowRuns{0, 0})
+  , m_abandonedRuns(0) {
+  }
+  
+  std::size_t AttributeArena::rows() const {
+    return m_rows.size();
+  }
+  
+  void AttributeArena::resize(std::size_t rows) {
+    for (std::size_t row = rows; row < m_rows.size(); ++row) {
+      abandon(m_rows[row]);
+    }
+    
+    m_rows.resize(rows, RowRuns{0, 0});
+    compactIfNeeded();
+  }
+  
+  AttributeSpan AttributeArena::attributes(std::size_t row) const {
+    const RowRuns& runs = m_rows[row];
+    if (runs.count == 0) {
+      return AttributeSpan();
+    }
+    
+    const AttributeRange* first = m_runs.data() + runs.offset;
+    return AttributeSpan(first, first + runs.count);
+  }
+  
+  void AttributeArena::clear(std::size_t row) {
+    abandon(m_rows[row]);
+  }
+  
+  void AttributeArena::clear() {
+    m_runs.clear();
+    std::fill(m_rows.begin(), m_rows.end(), RowRuns{0, 0});
+    m_abandonedRuns = 0;
+  }
+  
+  void AttributeArena::apply(const DocumentChange& change) {
+    // As with the syntax cache, rows replaced one for one are cleared in place.
+    std::size_t replaced = std::min(change.removedRows, change.insertedRows);
+    std::vector<RowRuns>::iterator first = m_rows.begin() + change.firstRow;
+    std::for_each(first, first + replaced, [this] (RowRuns& runs) {
+      abandon(runs);
+    });
+    
+    first += replaced;
+    if (change.removedRows > replaced) {
+      std::vector<RowRuns>::iterator last = first + (change.removedRows - replaced);
+      std::for_each(first, last, [this] (RowRuns& runs) {
+        abandon(runs);
+      });
+      
+      m_rows.erase(first, last);
+    } else {
+      m_rows.insert(first, change.insertedRows - replaced, RowRuns{0, 0});
+    }
+    
+    compactIfNeeded();
+  }
+  
+  std::size_t AttributeArena::footprint() const {
+    return m_runs.capacity() * sizeof(AttributeRange) + m_rows.capacity() * sizeof(RowRuns);
+  }
+  
+  void AttributeArena::abandon(RowRuns& runs) {
+    m_abandonedRuns += runs.count;
+    runs.count = 0;
+  }
+  
+  void AttributeArena::compactIfNeeded() {
+    if (m_abandonedRuns < MinimumAbandonedRuns || m_abandonedRuns * 2 <= m_runs.size()) {
+      return;
+    }
+    
+    std::vector<AttributeRange> compacted;
+    compacted.reserve(m_runs.size() - m_abandonedRuns);
+    for (RowRuns& runs : m_rows) {
+      std::uint32_t offset = static_cast<std::uint32_t>(compacted.size());
+      compacted.insert(compacted.end(), m_runs.begin() + runs.offset, m_runs.begin() + runs.offset + runs.count);
+      runs.offset = offset;
+    }
+    
+    m_runs.swap(compacted);
+    m_abandonedRuns = 0;
+  }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "AttributeRange.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace quip {
+  struct DocumentChange;
+  
+  // The attribute ranges of one row, as stored in an attribute arena.
+  struct AttributeSpan {
+    AttributeSpan();
+    AttributeSpan(const AttributeRange* first, const AttributeRange* last);
+    
+    const AttributeRange* begin() const;
+    const AttributeRange* end() const;
+    
+    std::size_t size() const;
+    bool empty() const;
+    
+    const AttributeRange& operator[](std::size_t index) const;
+    
+  private:
+    const AttributeRange* m_first;
+    const AttributeRange* m_last;
+  };
+  
+  // Stores the attribute ranges of a sequence of rows together in one contiguous block, rather
+  // than in a separate allocation for each row.
+  //
+  // Replacing a row's ranges with as many or fewer reuses its place in the block; otherwise the
+  // new ranges are appended and the old ones are abandoned. The block is compacted once most
+  // of it has been abandoned.
+  struct AttributeArena {
+    AttributeArena();
+    AttributeArena(std::size_t rows);
+    
+    std::size_t rows() const;
+    
+    // Add empty rows to the end of the arena, or discard rows from its end.
+    void resize(std::size_t rows);
+    
+    // The attribute ranges of a row. The span is invalidated by any modification of the arena.
+    AttributeSpan attributes(std::size_t row) const;
+    
+    // Replace the attribute ranges of a row with those in the given sequence, which may be of
+    // AttributeRange or RowAttributeRange, and mustn't be part of this arena.
+    template<typename IteratorType>
+    void assign(std::size_t row, IteratorType first, IteratorType last);
+    
+    void clear(std::size_t row);
+    void clear();
+    
+    // Follow a modification of a document, discarding the ranges of the rows it affected and
+    // shifting the rest along with their rows.
+    void apply(const DocumentChange& change);
+    
+    // The number of bytes the arena has allocated.
+    std::size_t footprint() const;
+    
+  private:
+    struct RowRuns {
+      std::uint32_t offset;
+      std::uint32_t count;
+    };
+    
+    std::vector<AttributeRange> m_runs;
+    std::vector<RowRuns> m_rows;
+    std::size_t m_abandonedRuns;
+    
+    void abandon(RowRuns& row);
+    void compactIfNeeded();
+  };
+}
+
+#include "AttributeArena.inl"
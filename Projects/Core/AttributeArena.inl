@@ -0,0 +1,27 @@
+#include <iterator>
+
+namespace quip {
+  template<typename IteratorType>
+  void AttributeArena::assign(std::size_t row, IteratorType first, IteratorType last) {
+    std::size_t count = std::distance(first, last);
+    RowRuns& runs = m_rows[row];
+    if (count <= runs.count) {
+      m_abandonedRuns += runs.count - count;
+      runs.count = static_cast<std::uint32_t>(count);
+      for (std::size_t index = runs.offset; first != last; ++first, ++index) {
+        m_runs[index] = AttributeRange(first->attribute, first->start, first->length);
+      }
+      
+      return;
+    }
+    
+    abandon(runs);
+    compactIfNeeded();
+    
+    runs.offset = static_cast<std::uint32_t>(m_runs.size());
+    runs.count = static_cast<std::uint32_t>(count);
+    for (; first != last; ++first) {
+      m_runs.emplace_back(first->attribute, first->start, first->length);
+    }
+  }
+}
@@ -1,9 +1,9 @@
 #include "AttributeRange.hpp"
 
 namespace quip {
-  AttributeRange::AttributeRange(const std::string& name, std::size_t start, std::size_t length)
-  : name(name)
-  , start(start)
-  , length(length) {
+  AttributeRange::AttributeRange(AttributeId attribute, std::size_t start, std::size_t length)
+  : attribute(attribute)
+  , start(static_cast<std::uint32_t>(start))
+  , length(static_cast<std::uint32_t>(length)) {
   }
 }
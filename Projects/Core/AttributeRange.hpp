@@ -1,14 +1,18 @@
 #pragma once
 
+#include "AttributeRegistry.hpp"
+
 #include <cstddef>
-#include <string>
+#include <cstdint>
 
 namespace quip {
+  // A run of characters within a row that belong to an attribute group. Every token of a
+  // highlighted document is stored as one of these, so they're kept small.
   struct AttributeRange {
-    std::string name;
-    std::size_t start;
-    std::size_t length;
+    AttributeId attribute;
+    std::uint32_t start;
+    std::uint32_t length;
     
-    AttributeRange(const std::string& name, std::size_t start, std::size_t length);
+    AttributeRange(AttributeId attribute, std::size_t start, std::size_t length);
   };
 }
@@ -0,0 +1,38 @@
+#include "AttributeRegistry.hpp"
+
+namespace quip {
+  AttributeRegistry& AttributeRegistry::shared() {
+    static AttributeRegistry registry;
+    return registry;
+  }
+  
+  AttributeRegistry::AttributeRegistry() {
+  }
+  
+  AttributeId AttributeRegistry::intern(const std::string& name) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unordered_map<std::string, AttributeId>::const_iterator cursor = m_ids.find(name);
+    if (cursor != std::end(m_ids)) {
+      return cursor->second;
+    }
+    
+    AttributeId attribute = static_cast<AttributeId>(m_names.size());
+    m_names.emplace_back(name);
+    m_ids.emplace(name, attribute);
+    return attribute;
+  }
+  
+  AttributeId AttributeRegistry::intern(const char* name, std::size_t length) {
+    return intern(std::string(name, length));
+  }
+  
+  const std::string& AttributeRegistry::name(AttributeId attribute) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return attribute < m_names.size() ? m_names[attribute] : m_empty;
+  }
+  
+  std::size_t AttributeRegistry::count() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_names.size();
+  }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace quip {
+  // Identifies an attribute group, such as "Comment".
+  typedef std::uint32_t AttributeId;
+  
+  // Interns the names of attribute groups, so that syntax attributes refer to a group by a small
+  // integer rather than carrying a copy of its name.
+  //
+  // There is one registry for the whole process, shared by every Lua state, tokenizer and
+  // drawing service, so an ID means the same group wherever it came from. It may be used from
+  // any thread.
+  struct AttributeRegistry {
+    static AttributeRegistry& shared();
+    
+    AttributeId intern(const std::string& name);
+    AttributeId intern(const char* name, std::size_t length);
+    
+    // The name of an attribute group, which is empty for an ID that was never interned. The
+    // reference remains valid for the life of the registry.
+    const std::string& name(AttributeId attribute) const;
+    
+    // The number of groups interned so far. Every ID is less than this.
+    std::size_t count() const;
+    
+    AttributeRegistry(const AttributeRegistry& other) = delete;
+    AttributeRegistry& operator=(const AttributeRegistry& other) = delete;
+    
+  private:
+    AttributeRegistry();
+    
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, AttributeId> m_ids;
+    std::deque<std::string> m_names;
+    std::string m_empty;
+  };
+}
@@ -0,0 +1,872 @@
+#include "AutomatonSearchEngine.hpp"
+
+#include "LiteralSearchEngine.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <utility>
+
+namespace {
+  // Larger expressions, typically produced by large counted repetitions, can't be compiled.
+  const std::size_t MaximumProgramSize = 10000;
+  const std::size_t MaximumRepetitionCount = 1000;
+  const std::size_t MaximumNestingDepth = 256;
+  
+  const std::size_t Unbounded = std::numeric_limits<std::size_t>::max();
+  
+  bool isWordByte(unsigned char byte) {
+    return std::isalnum(byte) || byte == '_';
+  }
+  
+  // Add the other case of every ASCII letter in a set of bytes.
+  void foldCase(std::bitset<256>& bytes) {
+    for (std::size_t byte = 'a'; byte <= 'z'; ++byte) {
+      if (bytes[byte] || bytes[byte - 'a' + 'A']) {
+        bytes.set(byte);
+        bytes.set(byte - 'a' + 'A');
+      }
+    }
+  }
+  
+  int hexadecimalValue(char character) {
+    if (character >= '0' && character <= '9') {
+      return character - '0';
+    } else if (character >= 'a' && character <= 'f') {
+      return character - 'a' + 10;
+    } else if (character >= 'A' && character <= 'F') {
+      return character - 'A' + 10;
+    }
+    
+    return -1;
+  }
+}
+
+namespace quip {
+  struct AutomatonSearchEngine::ThreadList {
+    explicit ThreadList(std::size_t capacity)
+    : marks(capacity, 0)
+    , generation(1) {
+      threads.reserve(capacity);
+    }
+    
+    void clear() {
+      threads.clear();
+      ++generation;
+    }
+    
+    std::vector<Thread> threads;
+    
+    // An instruction is already on the list if its mark matches the list's generation, which
+    // allows the list to be cleared without touching every mark.
+    std::vector<std::size_t> marks;
+    std::size_t generation;
+    
+    // Instructions waiting to be followed by addThread.
+    std::vector<std::uint32_t> pending;
+  };
+  
+  // The threads at the current position and the next, which are both as large as the program.
+  struct AutomatonSearchEngine::ThreadState : State {
+    explicit ThreadState(std::size_t capacity)
+    : current(capacity)
+    , next(capacity) {
+    }
+    
+    ThreadList current;
+    ThreadList next;
+  };
+  
+  // Parses an expression into a syntax tree, then generates the program for the tree.
+  struct AutomatonSearchEngine::Compiler {
+    Compiler(const std::string& expression, AutomatonSearchEngine& engine)
+    : m_expression(expression)
+    , m_position(0)
+    , m_depth(0)
+    , m_engine(engine) {
+    }
+    
+    bool compile() {
+      std::unique_ptr<Node> root = parseAlternation();
+      if (root == nullptr || m_position != m_expression.size()) {
+        return false;
+      }
+      
+      if (!generate(*root)) {
+        return false;
+      }
+      
+      m_engine.m_program.push_back(Instruction { Opcode::Match, 0, 0 });
+      m_engine.m_maximumNewlines = countNewlines(*root);
+      return true;
+    }
+    
+  private:
+    enum struct Kind {
+      Byte,
+      Class,
+      Assertion,
+      Concatenation,
+      Alternation,
+      Repetition
+    };
+    
+    struct Node {
+      explicit Node(Kind kind)
+      : kind(kind)
+      , value(0)
+      , minimum(0)
+      , maximum(0)
+      , isGreedy(true) {
+      }
+      
+      Kind kind;
+      
+      // The byte, class index or assertion opcode, depending on the kind of node.
+      std::uint32_t value;
+      
+      std::size_t minimum;
+      std::size_t maximum;
+      bool isGreedy;
+      
+      std::vector<std::unique_ptr<Node>> children;
+    };
+    
+    // A single character of a character class, or an escape standing for a whole class.
+    struct ClassAtom {
+      bool isClass;
+      unsigned char byte;
+      std::bitset<256> bytes;
+    };
+    
+    const std::string& m_expression;
+    std::size_t m_position;
+    std::size_t m_depth;
+    AutomatonSearchEngine& m_engine;
+    
+    bool isAtEnd() const {
+      return m_position >= m_expression.size();
+    }
+    
+    char peek() const {
+      return m_expression[m_position];
+    }
+    
+    bool isQuantifierNext() const {
+      if (isAtEnd()) {
+        return false;
+      }
+      
+      char character = peek();
+      return character == '*' || character == '+' || character == '?' || character == '{';
+    }
+    
+    std::unique_ptr<Node> parseAlternation() {
+      std::unique_ptr<Node> first = parseConcatenation();
+      if (first == nullptr || isAtEnd() || peek() != '|') {
+        return first;
+      }
+      
+      std::unique_ptr<Node> result(new Node(Kind::Alternation));
+      result->children.emplace_back(std::move(first));
+      while (!isAtEnd() && peek() == '|') {
+        ++m_position;
+        std::unique_ptr<Node> alternative = parseConcatenation();
+        if (alternative == nullptr) {
+          return nullptr;
+        }
+        
+        result->children.emplace_back(std::move(alternative));
+      }
+      
+      return result;
+    }
+    
+    std::unique_ptr<Node> parseConcatenation() {
+      std::unique_ptr<Node> result(new Node(Kind::Concatenation));
+      while (!isAtEnd() && peek() != '|' && peek() != ')') {
+        std::unique_ptr<Node> term = parseTerm();
+        if (term == nullptr) {
+          return nullptr;
+        }
+        
+        result->children.emplace_back(std::move(term));
+      }
+      
+      return result;
+    }
+    
+    std::unique_ptr<Node> parseTerm() {
+      Opcode assertion = Opcode::Match;
+      if (peek() == '^') {
+        assertion = Opcode::AssertBegin;
+        m_position += 1;
+      } else if (peek() == '$') {
+        assertion = Opcode::AssertEnd;
+        m_position += 1;
+      } else if (peek() == '\\' && m_position + 1 < m_expression.size() && m_expression[m_position + 1] == 'b') {
+        assertion = Opcode::AssertWordBoundary;
+        m_position += 2;
+      } else if (peek() == '\\' && m_position + 1 < m_expression.size() && m_expression[m_position + 1] == 'B') {
+        assertion = Opcode::AssertNotWordBoundary;
+        m_position += 2;
+      }
+      
+      if (assertion != Opcode::Match) {
+        if (isQuantifierNext()) {
+          // Assertions can't be repeated.
+          return nullptr;
+        }
+        
+        std::unique_ptr<Node> result(new Node(Kind::Assertion));
+        result->value = static_cast<std::uint32_t>(assertion);
+        return result;
+      }
+      
+      std::unique_ptr<Node> atom = parseAtom();
+      if (atom == nullptr || !isQuantifierNext()) {
+        return atom;
+      }
+      
+      std::unique_ptr<Node> result(new Node(Kind::Repetition));
+      char quantifier = peek();
+      ++m_position;
+      if (quantifier == '*') {
+        result->minimum = 0;
+        result->maximum = Unbounded;
+      } else if (quantifier == '+') {
+        result->minimum = 1;
+        result->maximum = Unbounded;
+      } else if (quantifier == '?') {
+        result->minimum = 0;
+        result->maximum = 1;
+      } else {
+        if (!parseCount(result->minimum)) {
+          return nullptr;
+        }
+        
+        result->maximum = result->minimum;
+        if (!isAtEnd() && peek() == ',') {
+          ++m_position;
+          result->maximum = Unbounded;
+          if (!isAtEnd() && peek() != '}' && !parseCount(result->maximum)) {
+            return nullptr;
+          }
+        }
+        
+        if (isAtEnd() || peek() != '}' || result->maximum < result->minimum) {
+          return nullptr;
+        }
+        
+        ++m_position;
+      }
+      
+      if (!isAtEnd() && peek() == '?') {
+        result->isGreedy = false;
+        ++m_position;
+      }
+      
+      if (isQuantifierNext()) {
+        // Quantifiers can't be repeated either.
+        return nullptr;
+      }
+      
+      result->children.emplace_back(std::move(atom));
+      return result;
+    }
+    
+    bool parseCount(std::size_t& count) {
+      std::size_t start = m_position;
+      count = 0;
+      while (!isAtEnd() && std::isdigit(static_cast<unsigned char>(peek()))) {
+        count = count * 10 + (peek() - '0');
+        if (count > MaximumRepetitionCount) {
+          return false;
+        }
+        
+        ++m_position;
+      }
+      
+      return m_position > start;
+    }
+    
+    std::unique_ptr<Node> parseAtom() {
+      char character = peek();
+      ++m_position;
+      
+      switch (character) {
+        case '.': {
+          std::bitset<256> bytes;
+          bytes.set();
+          bytes.reset('\n');
+          bytes.reset('\r');
+          return makeClass(bytes);
+        }
+        case '(': {
+          if (!isAtEnd() && peek() == '?') {
+            if (m_position + 1 >= m_expression.size() || m_expression[m_position + 1] != ':') {
+              // Lookahead isn't supported.
+              return nullptr;
+            }
+            
+            m_position += 2;
+          }
+          
+          if (++m_depth > MaximumNestingDepth) {
+            return nullptr;
+          }
+          
+          std::unique_ptr<Node> result = parseAlternation();
+          if (result == nullptr || isAtEnd() || peek() != ')') {
+            return nullptr;
+          }
+          
+          --m_depth;
+          ++m_position;
+          return result;
+        }
+        case '[':
+          return parseClass();
+        case '\\': {
+          ClassAtom atom;
+          if (!parseEscape(atom, false)) {
+            return nullptr;
+          }
+          
+          return atom.isClass ? makeClass(atom.bytes) : makeByte(atom.byte);
+        }
+        case '*':
+        case '+':
+        case '?':
+        case '{':
+        case '}':
+        case ']':
+          // Either there's nothing to repeat, or the character is only accepted as a literal
+          // by some implementations.
+          return nullptr;
+        default:
+          return makeByte(static_cast<unsigned char>(character));
+      }
+    }
+    
+    std::unique_ptr<Node> parseClass() {
+      bool isNegated = false;
+      if (!isAtEnd() && peek() == '^') {
+        isNegated = true;
+        ++m_position;
+      }
+      
+      std::bitset<256> bytes;
+      while (true) {
+        if (isAtEnd()) {
+          return nullptr;
+        }
+        
+        if (peek() == ']') {
+          ++m_position;
+          break;
+        }
+        
+        ClassAtom lower;
+        if (!parseClassAtom(lower)) {
+          return nullptr;
+        }
+        
+        bool isRange = m_position + 1 < m_expression.size() && peek() == '-' && m_expression[m_position + 1] != ']';
+        if (!isRange) {
+          if (lower.isClass) {
+            bytes |= lower.bytes;
+          } else {
+            bytes.set(lower.byte);
+          }
+          
+          continue;
+        }
+        
+        ++m_position;
+        ClassAtom upper;
+        if (!parseClassAtom(upper) || lower.isClass || upper.isClass || lower.byte > upper.byte) {
+          return nullptr;
+        }
+        
+        for (std::size_t byte = lower.byte; byte <= upper.byte; ++byte) {
+          bytes.set(byte);
+        }
+      }
+      
+      if (m_engine.m_ignoresCase) {
+        foldCase(bytes);
+      }
+      
+      if (isNegated) {
+        bytes.flip();
+      }
+      
+      return makeClass(bytes);
+    }
+    
+    bool parseClassAtom(ClassAtom& atom) {
+      char character = peek();
+      ++m_position;
+      if (character == '\\') {
+        return parseEscape(atom, true);
+      }
+      
+      atom.isClass = false;
+      atom.byte = static_cast<unsigned char>(character);
+      return true;
+    }
+    
+    // Parse the escape following a backslash, either in or out of a character class.
+    bool parseEscape(ClassAtom& atom, bool isInClass) {
+      if (isAtEnd()) {
+        return false;
+      }
+      
+      char character = peek();
+      ++m_position;
+      
+      atom.isClass = false;
+      switch (character) {
+        case 'd':
+        case 'D':
+        case 'w':
+        case 'W':
+        case 's':
+        case 'S': {
+          atom.isClass = true;
+          atom.bytes.reset();
+          for (std::size_t byte = 0; byte < 256; ++byte) {
+            char lower = std::tolower(character);
+            if ((lower == 'd' && std::isdigit(static_cast<int>(byte))) || (lower == 'w' && isWordByte(byte)) || (lower == 's' && std::isspace(static_cast<int>(byte)))) {
+              atom.bytes.set(byte);
+            }
+          }
+          
+          if (std::isupper(character)) {
+            atom.bytes.flip();
+          }
+          
+          return true;
+        }
+        case 'b':
+          // Outside of a class this is a word boundary, which parseTerm handles.
+          atom.byte = '\b';
+          return isInClass;
+        case 'n':
+          atom.byte = '\n';
+          return true;
+        case 'r':
+          atom.byte = '\r';
+          return true;
+        case 't':
+          atom.byte = '\t';
+          return true;
+        case 'f':
+          atom.byte = '\f';
+          return true;
+        case 'v':
+          atom.byte = '\v';
+          return true;
+        case '0':
+          atom.byte = '\0';
+          return isAtEnd() || !std::isdigit(static_cast<unsigned char>(peek()));
+        case 'x':
+          return parseHexadecimal(2, atom);
+        case 'u':
+          return parseHexadecimal(4, atom);
+        case 'c':
+          if (isAtEnd() || !std::isalpha(static_cast<unsigned char>(peek()))) {
+            return false;
+          }
+          
+          atom.byte = static_cast<unsigned char>(peek()) % 32;
+          ++m_position;
+          return true;
+        default:
+          // Escaped letters and digits either mean something unsupported (such as
+          // backreferences) or are errors, but any other character stands for itself.
+          if (std::isalnum(static_cast<unsigned char>(character))) {
+            return false;
+          }
+          
+          atom.byte = static_cast<unsigned char>(character);
+          return true;
+      }
+    }
+    
+    bool parseHexadecimal(std::size_t digits, ClassAtom& atom) {
+      if (m_position + digits > m_expression.size()) {
+        return false;
+      }
+      
+      unsigned int value = 0;
+      for (std::size_t index = 0; index < digits; ++index) {
+        int digit = hexadecimalValue(m_expression[m_position + index]);
+        if (digit < 0) {
+          return false;
+        }
+        
+        value = value * 16 + digit;
+      }
+      
+      if (value > 0xff) {
+        // Text is searched a byte at a time, so characters beyond a byte can't be matched.
+        return false;
+      }
+      
+      m_position += digits;
+      atom.byte = static_cast<unsigned char>(value);
+      return true;
+    }
+    
+    std::unique_ptr<Node> makeByte(unsigned char byte) {
+      if (m_engine.m_ignoresCase && std::isalpha(byte)) {
+        std::bitset<256> bytes;
+        bytes.set(byte);
+        foldCase(bytes);
+        return makeClass(bytes);
+      }
+      
+      std::unique_ptr<Node> result(new Node(Kind::Byte));
+      result->value = byte;
+      return result;
+    }
+    
+    std::unique_ptr<Node> makeClass(const std::bitset<256>& bytes) {
+      std::unique_ptr<Node> result(new Node(Kind::Class));
+      result->value = static_cast<std::uint32_t>(m_engine.m_classes.size());
+      m_engine.m_classes.push_back(bytes);
+      return result;
+    }
+    
+    std::uint32_t emit(Opcode opcode, std::uint32_t first = 0, std::uint32_t second = 0) {
+      m_engine.m_program.push_back(Instruction { opcode, first, second });
+      return static_cast<std::uint32_t>(m_engine.m_program.size() - 1);
+    }
+    
+    std::uint32_t next() const {
+      return static_cast<std::uint32_t>(m_engine.m_program.size());
+    }
+    
+    bool generate(const Node& node) {
+      std::vector<Instruction>& program = m_engine.m_program;
+      switch (node.kind) {
+        case Kind::Byte:
+          emit(Opcode::Byte, node.value);
+          break;
+        case Kind::Class:
+          emit(Opcode::Class, node.value);
+          break;
+        case Kind::Assertion:
+          emit(static_cast<Opcode>(node.value));
+          break;
+        case Kind::Concatenation:
+          for (const std::unique_ptr<Node>& child : node.children) {
+            if (!generate(*child)) {
+              return false;
+            }
+          }
+          
+          break;
+        case Kind::Alternation: {
+          // Each alternative but the last is preceded by a split preferring it over the rest,
+          // and followed by a jump past the remaining alternatives.
+          std::vector<std::uint32_t> jumps;
+          for (std::size_t index = 0; index + 1 < node.children.size(); ++index) {
+            std::uint32_t split = emit(Opcode::Split, next() + 1);
+            if (!generate(*node.children[index])) {
+              return false;
+            }
+            
+            jumps.push_back(emit(Opcode::Jump));
+            program[split].second = next();
+          }
+          
+          if (!generate(*node.children.back())) {
+            return false;
+          }
+          
+          for (std::uint32_t jump : jumps) {
+            program[jump].first = next();
+          }
+          
+          break;
+        }
+        case Kind::Repetition: {
+          const Node& child = *node.children.front();
+          for (std::size_t index = 0; index < node.minimum; ++index) {
+            if (!generate(child)) {
+              return false;
+            }
+          }
+          
+          if (node.maximum == Unbounded) {
+            std::uint32_t split = emit(Opcode::Split);
+            if (!generate(child)) {
+              return false;
+            }
+            
+            emit(Opcode::Jump, split);
+            setSplit(split, split + 1, next(), node.isGreedy);
+          } else {
+            // Each optional repetition is skipped to the end, so that a{0,2} is (a(a)?)?.
+            std::vector<std::uint32_t> splits;
+            for (std::size_t index = node.minimum; index < node.maximum; ++index) {
+              splits.push_back(emit(Opcode::Split));
+              if (!generate(child)) {
+                return false;
+              }
+            }
+            
+            for (std::uint32_t split : splits) {
+              setSplit(split, split + 1, next(), node.isGreedy);
+            }
+          }
+          
+          break;
+        }
+      }
+      
+      return program.size() <= MaximumProgramSize;
+    }
+    
+    // The most newlines a match of a node can contain. Assertions only examine the bytes either
+    // side of the position they're at, so they don't extend a match.
+    std::size_t countNewlines(const Node& node) const {
+      switch (node.kind) {
+        case Kind::Byte:
+          return node.value == '\n' ? 1 : 0;
+        case Kind::Class:
+          return m_engine.m_classes[node.value]['\n'] ? 1 : 0;
+        case Kind::Assertion:
+          return 0;
+        case Kind::Concatenation: {
+          std::size_t total = 0;
+          for (const std::unique_ptr<Node>& child : node.children) {
+            std::size_t count = countNewlines(*child);
+            if (count == UnboundedNewlines) {
+              return UnboundedNewlines;
+            }
+            
+            total += count;
+          }
+          
+          return total;
+        }
+        case Kind::Alternation: {
+          std::size_t most = 0;
+          for (const std::unique_ptr<Node>& child : node.children) {
+            most = std::max(most, countNewlines(*child));
+          }
+          
+          return most;
+        }
+        case Kind::Repetition: {
+          std::size_t count = countNewlines(*node.children.front());
+          if (count == 0) {
+            return 0;
+          }
+          
+          if (count == UnboundedNewlines || node.maximum == Unbounded) {
+            return UnboundedNewlines;
+          }
+          
+          return count * node.maximum;
+        }
+      }
+      
+      return UnboundedNewlines;
+    }
+    
+    void setSplit(std::uint32_t split, std::uint32_t body, std::uint32_t exit, bool isGreedy) {
+      Instruction& instruction = m_engine.m_program[split];
+      instruction.first = isGreedy ? body : exit;
+      instruction.second = isGreedy ? exit : body;
+    }
+  };
+  
+  AutomatonSearchEngine::AutomatonSearchEngine(bool ignoresCase)
+  : m_ignoresCase(ignoresCase)
+  , m_maximumNewlines(UnboundedNewlines) {
+  }
+  
+  bool AutomatonSearchEngine::search(const char* text, std::size_t size, std::size_t start, bool isDocumentStart, bool isDocumentEnd, State& state, SearchMatch& match) const {
+    // The lists are left holding the threads that were running when the last search ended.
+    ThreadList& current = static_cast<ThreadState&>(state).current;
+    ThreadList& next = static_cast<ThreadState&>(state).next;
+    current.clear();
+    next.clear();
+    
+    bool isMatched = false;
+    std::size_t position = start;
+    while (true) {
+      // Until a match is found, a new thread is started at every position, at a lower priority
+      // than every thread started before it.
+      if (!isMatched) {
+        if (current.threads.empty()) {
+          current.clear();
+          if (!m_prefix.empty()) {
+            position += findLiteral(text + position, size - position, m_prefix, m_ignoresCase);
+          } else {
+            while (position < size && !m_firstBytes[static_cast<unsigned char>(text[position])]) {
+              ++position;
+            }
+          }
+          
+          if (position == size) {
+            break;
+          }
+        }
+        
+        addThread(current, 0, position, text, size, position, isDocumentStart, isDocumentEnd);
+      }
+      
+      if (current.threads.empty() && (isMatched || position == size)) {
+        break;
+      }
+      
+      for (const Thread& thread : current.threads) {
+        const Instruction& instruction = m_program[thread.instruction];
+        if (instruction.opcode == Opcode::Match) {
+          if (thread.start < position) {
+            // Every thread after this one has a lower priority, so they can be abandoned.
+            match.position = thread.start;
+            match.length = position - thread.start;
+            isMatched = true;
+            break;
+          }
+          
+          continue;
+        }
+        
+        if (position == size) {
+          continue;
+        }
+        
+        unsigned char byte = static_cast<unsigned char>(text[position]);
+        bool isAccepted = instruction.opcode == Opcode::Byte ? byte == instruction.first : m_classes[instruction.first][byte];
+        if (isAccepted) {
+          addThread(next, thread.instruction + 1, thread.start, text, size, position + 1, isDocumentStart, isDocumentEnd);
+        }
+      }
+      
+      if (position == size) {
+        break;
+      }
+      
+      std::swap(current, next);
+      next.clear();
+      ++position;
+    }
+    
+    return isMatched;
+  }
+  
+  std::unique_ptr<SearchEngine::State> AutomatonSearchEngine::createState() const {
+    return std::make_unique<ThreadState>(m_program.size());
+  }
+  
+  std::size_t AutomatonSearchEngine::maximumNewlines() const {
+    return m_maximumNewlines;
+  }
+  
+  std::shared_ptr<AutomatonSearchEngine> AutomatonSearchEngine::create(const std::string& expression, bool ignoresCase) {
+    std::shared_ptr<AutomatonSearchEngine> result(new AutomatonSearchEngine(ignoresCase));
+    Compiler compiler(expression, *result);
+    if (!compiler.compile()) {
+      return nullptr;
+    }
+    
+    result->findFirstBytes();
+    LiteralSearchEngine::findLiteralPrefix(expression, result->m_prefix);
+    return result;
+  }
+  
+  void AutomatonSearchEngine::addThread(ThreadList& list, std::uint32_t instruction, std::size_t start, const char* text, std::size_t size, std::size_t position, bool isDocumentStart, bool isDocumentEnd) const {
+    // Instructions that don't consume input are followed immediately, depth first and in
+    // priority order, so the threads on the list stay in priority order.
+    list.pending.push_back(instruction);
+    while (!list.pending.empty()) {
+      std::uint32_t current = list.pending.back();
+      list.pending.pop_back();
+      if (list.marks[current] == list.generation) {
+        continue;
+      }
+      
+      list.marks[current] = list.generation;
+      const Instruction& operation = m_program[current];
+      switch (operation.opcode) {
+        case Opcode::Split:
+          list.pending.push_back(operation.second);
+          list.pending.push_back(operation.first);
+          break;
+        case Opcode::Jump:
+          list.pending.push_back(operation.first);
+          break;
+        case Opcode::AssertBegin:
+          if (position == 0 && isDocumentStart) {
+            list.pending.push_back(current + 1);
+          }
+          
+          break;
+        case Opcode::AssertEnd:
+          if (position == size && isDocumentEnd) {
+            list.pending.push_back(current + 1);
+          }
+          
+          break;
+        case Opcode::AssertWordBoundary:
+        case Opcode::AssertNotWordBoundary: {
+          bool isWordBefore = position > 0 && isWordByte(static_cast<unsigned char>(text[position - 1]));
+          bool isWordAfter = position < size && isWordByte(static_cast<unsigned char>(text[position]));
+          if ((isWordBefore != isWordAfter) == (operation.opcode == Opcode::AssertWordBoundary)) {
+            list.pending.push_back(current + 1);
+          }
+          
+          break;
+        }
+        default:
+          list.threads.push_back(Thread { current, start });
+          break;
+      }
+    }
+  }
+  
+  void AutomatonSearchEngine::findFirstBytes() {
+    // Assertions are assumed to pass, which may include more bytes than necessary, but never
+    // fewer. Matches are never empty, so they always begin with a byte consumed by the program.
+    std::vector<bool> visited(m_program.size(), false);
+    std::vector<std::uint32_t> pending(1, 0);
+    while (!pending.empty()) {
+      std::uint32_t current = pending.back();
+      pending.pop_back();
+      if (visited[current]) {
+        continue;
+      }
+      
+      visited[current] = true;
+      const Instruction& instruction = m_program[current];
+      switch (instruction.opcode) {
+        case Opcode::Byte:
+          m_firstBytes.set(instruction.first);
+          break;
+        case Opcode::Class:
+          m_firstBytes |= m_classes[instruction.first];
+          break;
+        case Opcode::Split:
+          pending.push_back(instruction.first);
+          pending.push_back(instruction.second);
+          break;
+        case Opcode::Jump:
+          pending.push_back(instruction.first);
+          break;
+        case Opcode::Match:
+          break;
+        default:
+          pending.push_back(current + 1);
+          break;
+      }
+    }
+  }
+}
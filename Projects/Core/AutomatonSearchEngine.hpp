@@ -0,0 +1,88 @@
+#pragma once
+
+#include "SearchEngine.hpp"
+
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace quip {
+  // A search engine that compiles an expression to a Thompson NFA and simulates it over the
+  // text in the manner of a Pike VM: every possible thread of the match advances through the
+  // text in lockstep, so finding a match takes time proportional to the length of the text
+  // times the size of the expression, no matter what the expression is. Threads are kept in
+  // priority order, so the match found is the same one std::regex would find.
+  //
+  // The supported syntax is the subset of ECMAScript that doesn't require backtracking:
+  //
+  //   literal characters, and the escapes \n \r \t \f \v \0 \xHH \uHHHH \cX
+  //   any escaped punctuation character
+  //   . [...] [^...] \d \D \w \W \s \S
+  //   ^ $ \b \B
+  //   (...) (?:...) |
+  //   * + ? {n} {n,} {n,m}, each optionally followed by ? to be lazy
+  //
+  // Expressions that use anything else, such as backreferences or lookahead, can't be
+  // compiled.
+  struct AutomatonSearchEngine : SearchEngine {
+    using SearchEngine::search;
+    bool search(const char* text, std::size_t size, std::size_t start, bool isDocumentStart, bool isDocumentEnd, State& state, SearchMatch& match) const override;
+    std::unique_ptr<State> createState() const override;
+    std::size_t maximumNewlines() const override;
+    
+    // Returns null if the expression is not valid or uses unsupported syntax.
+    static std::shared_ptr<AutomatonSearchEngine> create(const std::string& expression, bool ignoresCase);
+    
+  private:
+    enum struct Opcode {
+      Byte,
+      Class,
+      Split,
+      Jump,
+      AssertBegin,
+      AssertEnd,
+      AssertWordBoundary,
+      AssertNotWordBoundary,
+      Match
+    };
+    
+    // The meaning of the operands depends on the opcode. Byte instructions match the byte in
+    // the first operand, and class instructions match any byte in the class it indexes. Split
+    // instructions continue at both operands, preferring the first, and jump instructions
+    // continue at the first.
+    struct Instruction {
+      Opcode opcode;
+      std::uint32_t first;
+      std::uint32_t second;
+    };
+    
+    struct Thread {
+      std::uint32_t instruction;
+      std::size_t start;
+    };
+    
+    struct ThreadList;
+    struct ThreadState;
+    struct Compiler;
+    
+    std::vector<Instruction> m_program;
+    std::vector<std::bitset<256>> m_classes;
+    
+    bool m_ignoresCase;
+    
+    // Every match begins with one of these bytes, so positions starting with any other byte
+    // can be skipped while no threads are running. If every match begins with the same
+    // literal text, the next occurrence of it is searched for instead.
+    std::bitset<256> m_firstBytes;
+    std::string m_prefix;
+    
+    std::size_t m_maximumNewlines;
+    
+    explicit AutomatonSearchEngine(bool ignoresCase);
+    
+    void addThread(ThreadList& list, std::uint32_t instruction, std::size_t start, const char* text, std::size_t size, std::size_t position, bool isDocumentStart, bool isDocumentEnd) const;
+    void findFirstBytes();
+  };
+}
@@ -0,0 +1,142 @@
+#include "CTokenizer.hpp"
+
+#include <cstring>
+#include <string>
+
+namespace {
+  // The state of a row that ends inside a block comment, as named by cpp.lua.
+  const std::string CommentState = "comment";
+  
+  // The characters that may begin a token; every other character is skipped.
+  struct TokenStarts {
+    bool isTokenStart[256];
+    
+    TokenStarts()
+    : isTokenStart() {
+      isTokenStart[static_cast<unsigned char>('/')] = true;
+      isTokenStart[static_cast<unsigned char>('#')] = true;
+    }
+  };
+  
+  const TokenStarts TokenStartTable;
+  
+  const char* Directives[] = {
+    "ifdef", "ifndef", "if", "else", "endif", "include", "define", "undef",
+  };
+  
+  // Find the position after the first "*/" at or after the start, if the comment ends in the
+  // text at all.
+  std::size_t findCommentEnd(const char* text, std::size_t length, std::size_t start) {
+    const char* cursor = text + start;
+    const char* end = text + length;
+    while (cursor + 1 < end) {
+      const char* star = static_cast<const char*>(std::memchr(cursor, '*', end - cursor - 1));
+      if (star == nullptr) {
+        break;
+      }
+      
+      if (star[1] == '/') {
+        return star + 2 - text;
+      }
+      
+      cursor = star + 1;
+    }
+    
+    return std::string::npos;
+  }
+}
+
+namespace quip {
+  CTokenizer::CTokenizer()
+  : m_commentAttribute(AttributeRegistry::shared().intern("Comment"))
+  , m_preprocessorAttribute(AttributeRegistry::shared().intern("Preprocessor"))
+  , m_directives(1, TrieNode()) {
+    for (const char* directive : Directives) {
+      addDirective(directive);
+    }
+  }
+  
+  std::string CTokenizer::tokenize(const char* text, std::size_t length, const std::string& state, std::vector<AttributeRange>& attributes) const {
+    std::size_t position = 0;
+    
+    // A row that begins inside a comment is part of it until the comment ends.
+    if (state == CommentState) {
+      position = findCommentEnd(text, length, 0);
+      if (position == std::string::npos) {
+        attributes.emplace_back(m_commentAttribute, 0, length);
+        return CommentState;
+      }
+      
+      attributes.emplace_back(m_commentAttribute, 0, position);
+    }
+    
+    while (position < length) {
+      // Skip straight to the next character that could begin a token.
+      while (position < length && !TokenStartTable.isTokenStart[static_cast<unsigned char>(text[position])]) {
+        ++position;
+      }
+      
+      if (position == length) {
+        break;
+      }
+      
+      if (text[position] == '/') {
+        if (position + 1 < length && text[position + 1] == '*') {
+          std::size_t end = findCommentEnd(text, length, position + 2);
+          if (end == std::string::npos) {
+            attributes.emplace_back(m_commentAttribute, position, length - position);
+            return CommentState;
+          }
+          
+          attributes.emplace_back(m_commentAttribute, position, end - position);
+          position = end;
+        } else {
+          ++position;
+        }
+      } else {
+        std::size_t directive = matchDirective(text + position + 1, length - position - 1);
+        if (directive > 0) {
+          attributes.emplace_back(m_preprocessorAttribute, position, directive + 1);
+          position += directive + 1;
+        } else {
+          ++position;
+        }
+      }
+    }
+    
+    return std::string();
+  }
+  
+  void CTokenizer::addDirective(const std::string& directive) {
+    std::size_t node = 0;
+    for (char character : directive) {
+      std::size_t letter = character - 'a';
+      if (m_directives[node].next[letter] == 0) {
+        m_directives[node].next[letter] = static_cast<std::uint8_t>(m_directives.size());
+        m_directives.emplace_back(TrieNode());
+      }
+      
+      node = m_directives[node].next[letter];
+    }
+    
+    m_directives[node].isTerminal = true;
+  }
+  
+  std::size_t CTokenizer::matchDirective(const char* text, std::size_t length) const {
+    std::size_t longest = 0;
+    std::size_t node = 0;
+    for (std::size_t index = 0; index < length; ++index) {
+      std::size_t letter = static_cast<unsigned char>(text[index]) - 'a';
+      if (letter >= 26 || m_directives[node].next[letter] == 0) {
+        break;
+      }
+      
+      node = m_directives[node].next[letter];
+      if (m_directives[node].isTerminal) {
+        longest = index + 1;
+      }
+    }
+    
+    return longest;
+  }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Tokenizer.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace quip {
+  // A tokenizer for the C family of languages, matching the grammar in syntax/cpp.lua: block
+  // comments, which may span rows, and preprocessor directives.
+  //
+  // The directives are found with a trie, stored as a table of transitions on lowercase letters,
+  // which takes the longest directive following a '#'.
+  struct CTokenizer : Tokenizer {
+    CTokenizer();
+    
+    std::string tokenize(const char* text, std::size_t length, const std::string& state, std::vector<AttributeRange>& attributes) const override;
+    
+  private:
+    AttributeId m_commentAttribute;
+    AttributeId m_preprocessorAttribute;
+    
+    // A transition to node zero, the root, means there is none.
+    struct TrieNode {
+      std::array<std::uint8_t, 26> next;
+      bool isTerminal;
+    };
+    
+    std::vector<TrieNode> m_directives;
+    
+    void addDirective(const std::string& directive);
+    std::size_t matchDirective(const char* text, std::size_t length) const;
+  };
+}
@@ -0,0 +1,27 @@
+#include "CompoundTransaction.hpp"
+
+#include "Document.hpp"
+#include "EditContext.hpp"
+
+namespace quip {
+  CompoundTransaction::CompoundTransaction(const std::vector<std::shared_ptr<Transaction>>& transactions)
+  : m_transactions(transactions) {
+  }
+  
+  CompoundTransaction::~CompoundTransaction() {
+  }
+  
+  void CompoundTransaction::perform(EditContext& context) {
+    Document& document = context.document();
+    document.beginBatch();
+    for (const std::shared_ptr<Transaction>& transaction : m_transactions) {
+      transaction->perform(context);
+    }
+    
+    document.endBatch();
+  }
+  
+  std::shared_ptr<Transaction> CompoundTransaction::create(const std::vector<std::shared_ptr<Transaction>>& transactions) {
+    return std::make_shared<CompoundTransaction>(transactions);
+  }
+}
\ No newline at end of file
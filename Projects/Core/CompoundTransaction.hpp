@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Transaction.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace quip {
+  // A sequence of transactions performed as one. The document reports their modifications as
+  // a single change once all of them are done, and when performed through an edit context they
+  // make up a single step of history.
+  struct CompoundTransaction : Transaction {
+    CompoundTransaction (const std::vector<std::shared_ptr<Transaction>> & transactions);
+    ~CompoundTransaction ();
+    
+    void perform (EditContext & context) override;
+    
+    static std::shared_ptr<Transaction> create (const std::vector<std::shared_ptr<Transaction>> & transactions);
+    
+  private:
+    std::vector<std::shared_ptr<Transaction>> m_transactions;
+  };
+}
\ No newline at end of file
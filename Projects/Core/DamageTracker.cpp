@@ -0,0 +1,96 @@
+#include "DamageTracker.hpp"
+
+#include "Document.hpp"
+#include "DocumentChange.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace quip {
+  const std::size_t DamageTracker::EndOfView = std::numeric_limits<std::size_t>::max();
+  
+  DamageTracker::DamageTracker(Document& document)
+  : m_document(document)
+  , m_hasShiftedRows(false) {
+    m_documentModifiedToken = m_document.onDocumentModified().connect([this] (const DocumentChange& change) {
+      onDocumentModified(change);
+    });
+  }
+  
+  DamageTracker::~DamageTracker() {
+    m_document.onDocumentModified().disconnect(m_documentModifiedToken);
+  }
+  
+  void DamageTracker::damageAll() {
+    m_ranges.assign(1, Range{0, EndOfView});
+  }
+  
+  void DamageTracker::damageRows(std::size_t firstRow, std::size_t lastRow) {
+    if (lastRow < firstRow) {
+      return;
+    }
+    
+    // Find the ranges the new one overlaps or touches and merge them into it.
+    std::vector<Range>::iterator first = std::lower_bound(m_ranges.begin(), m_ranges.end(), firstRow, [] (const Range& range, std::size_t row) {
+      return range.lastRow != EndOfView && range.lastRow + 1 < row;
+    });
+    
+    std::vector<Range>::iterator last = first;
+    while (last != m_ranges.end() && (lastRow == EndOfView || last->firstRow <= lastRow + 1)) {
+      firstRow = std::min(firstRow, last->firstRow);
+      lastRow = std::max(lastRow, last->lastRow);
+      ++last;
+    }
+    
+    first = m_ranges.erase(first, last);
+    m_ranges.insert(first, Range{firstRow, lastRow});
+  }
+  
+  void DamageTracker::damageSelections(const SelectionSet& selections) {
+    for (const Selection& selection : selections) {
+      damageRows(selection.origin().row(), selection.extent().row());
+    }
+  }
+  
+  void DamageTracker::trackSelections(const SelectionSet& selections) {
+    if (selections == m_selections) {
+      return;
+    }
+    
+    damageSelections(m_selections);
+    damageSelections(selections);
+    m_selections = selections;
+  }
+  
+  bool DamageTracker::isDamaged() const {
+    return !m_ranges.empty();
+  }
+  
+  bool DamageTracker::hasShiftedRows() const {
+    return m_hasShiftedRows;
+  }
+  
+  const std::vector<DamageTracker::Range>& DamageTracker::ranges() const {
+    return m_ranges;
+  }
+  
+  void DamageTracker::clear() {
+    m_ranges.clear();
+    m_hasShiftedRows = false;
+  }
+  
+  void DamageTracker::onDocumentModified(const DocumentChange& change) {
+    // Rows replaced one for one are damaged in place. Otherwise every row after them moved, so
+    // everything from the change on is damaged, and ranges already there are subsumed.
+    if (change.removedRows == change.insertedRows) {
+      if (change.insertedRows > 0) {
+        damageRows(change.firstRow, change.firstRow + change.insertedRows - 1);
+      }
+      
+      return;
+    }
+    
+    m_hasShiftedRows = true;
+    damageRows(change.firstRow, EndOfView);
+  }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "SelectionSet.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace quip {
+  struct Document;
+  struct DocumentChange;
+  
+  // Accumulates the rows of a document's view that need to be drawn again, so that a view can
+  // invalidate only those rows rather than everything it shows.
+  //
+  // Rows are damaged by modifications of the document, which the tracker follows by itself,
+  // and by changes to how selections and overlays are drawn, which it must be told about. Rows
+  // damaged before a modification move with it.
+  struct DamageTracker {
+    // A range of damaged rows, inclusive. A range whose last row is EndOfView extends through
+    // the end of the view, including any rows the document no longer has.
+    struct Range {
+      std::size_t firstRow;
+      std::size_t lastRow;
+    };
+    
+    static const std::size_t EndOfView;
+    
+    explicit DamageTracker(Document& document);
+    ~DamageTracker();
+    
+    DamageTracker(const DamageTracker& other) = delete;
+    DamageTracker& operator=(const DamageTracker& other) = delete;
+    
+    void damageAll();
+    void damageRows(std::size_t firstRow, std::size_t lastRow);
+    
+    // Damage every row the given selections touch.
+    void damageSelections(const SelectionSet& selections);
+    
+    // Damage the rows of both the given selections and those given last time, if they differ.
+    void trackSelections(const SelectionSet& selections);
+    
+    bool isDamaged() const;
+    
+    // Whether rows moved up or down because rows were inserted or removed above them. Every row
+    // from the first that moved on is damaged.
+    bool hasShiftedRows() const;
+    
+    // The damaged rows, in order, without overlaps.
+    const std::vector<Range>& ranges() const;
+    
+    void clear();
+    
+  private:
+    Document& m_document;
+    std::uint32_t m_documentModifiedToken;
+    
+    std::vector<Range> m_ranges;
+    bool m_hasShiftedRows;
+    SelectionSet m_selections;
+    
+    void onDocumentModified(const DocumentChange& change);
+  };
+}
@@ -1,6 +1,9 @@
 #include "Document.hpp"
 
 #include "DocumentIterator.hpp"
+#include "MappedFile.hpp"
+#include "NewlineScanner.hpp"
+#include "SearchEngine.hpp"
 #include "SearchExpression.hpp"
 #include "Selection.hpp"
 #include "SelectionSet.hpp"
@@ -8,43 +11,65 @@
 #include <algorithm>
 #include <iostream>
 #include <memory>
-#include <regex>
-#include <sstream>
 #include <string>
 
+namespace {
+  // The number of bytes of text searched at a time by Document::matches.
+  const std::size_t SearchWindowSize = 1024 * 1024;
+}
+
 namespace quip {
-  Document::Document() {
+  Document::Document()
+  : m_batchDepth(0) {
   }
   
   Document::Document(const std::string& content)
-  : m_rows(decompose(content)) {
+  : m_rows(content)
+  , m_batchDepth(0) {
+  }
+  
+  Document::Document(std::string&& content)
+  : m_rows(std::move(content))
+  , m_batchDepth(0) {
+  }
+  
+  Document::Document(std::shared_ptr<const MappedFile> file)
+  : m_rows(file)
+  , m_batchDepth(0) {
+  }
+  
+  Document::Document(const PieceTable& rows)
+  : m_rows(rows)
+  , m_batchDepth(0) {
   }
   
   std::string Document::contents() const {
-    std::ostringstream stream;
-    for (const std::string& text : m_rows) {
-      stream << text;
+    std::string result;
+    result.reserve(m_rows.length());
+    for (std::size_t index = 0; index < m_rows.rows(); ++index) {
+      result.append(m_rows.rowData(index), m_rows.rowLength(index));
     }
     
-    return stream.str();
+    return result;
   }
   
   bool Document::isEmpty() const noexcept {
-    return m_rows.size() == 0;
+    return m_rows.rows() == 0;
   }
   
   bool Document::isMissingTrailingNewline() const noexcept {
-    if (m_rows.empty()) {
+    if (m_rows.rows() == 0) {
       // By definition.
       return true;
     }
     
-    const std::string& text = m_rows.back();
-    return !text.empty() && text.back() != '\n';
+    std::size_t last = m_rows.rows() - 1;
+    std::size_t length = m_rows.rowLength(last);
+    return length > 0 && m_rows.rowData(last)[length - 1] != '\n';
   }
   
   std::string Document::contents(const Selection& selection) const {
-    if (m_rows.size() == 0) {
+    if (m_rows.rows() == 0) {
       // Selections always cover at least one character, so it's not
       // ambiguous to return an empty string for an empty document.
       // Although strictly speaking the only selection for which this
@@ -56,21 +81,21 @@ namespace quip {
     Location extent = selection.extent();
     
     if (selection.height() == 1) {
-      return m_rows[origin.row()].substr(origin.column(), extent.column() - origin.column() + 1);
+      return std::string(m_rows.rowData(origin.row()) + origin.column(), extent.column() - origin.column() + 1);
     } else {
-      std::string result = m_rows[origin.row()].substr(origin.column());
+      std::string result(m_rows.rowData(origin.row()) + origin.column(), m_rows.rowLength(origin.row()) - origin.column());
       for (std::size_t index = 1; index < selection.height() - 1; ++index) {
-        result += m_rows[origin.row() + index];
+        result.append(m_rows.rowData(origin.row() + index), m_rows.rowLength(origin.row() + index));
       }
       
-      result += m_rows[extent.row()].substr(0, extent.column() + 1);
+      result.append(m_rows.rowData(extent.row()), extent.column() + 1);
       return result;
     }
   }
   
   std::vector<std::string> Document::contents(const SelectionSet& selections) const {
     std::vector<std::string> results;
-    if (m_rows.size() == 0) {
+    if (m_rows.rows() == 0) {
       return results;
     }
     
@@ -91,7 +116,8 @@ namespace quip {
       return begin();
     }
     
-    return DocumentIterator(*this, Location(m_rows.back().size(), m_rows.size() - 1));
+    std::size_t last = m_rows.rows() - 1;
+    return DocumentIterator(*this, Location(m_rows.rowLength(last), last));
   }
   
   DocumentIterator Document::at(const Location& location) const {
@@ -109,9 +135,9 @@ namespace quip {
     
     Location lower = std::min(from, to);
     Location upper = std::max(from, to);
-    std::int64_t result = m_rows[lower.row()].size() - lower.column();
+    std::int64_t result = m_rows.rowLength(lower.row()) - lower.column();
     for (std::uint64_t index = lower.row() + 1; index < upper.row(); ++index) {
-      result += m_rows[index].size();
+      result += m_rows.rowLength(index);
     }
     
     result += upper.column();
@@ -126,13 +152,30 @@ namespace quip {
     m_path = path;
   }
   
-  const std::string& Document::row(std::size_t index) const {
-    return m_rows[index];
+  std::string Document::row(std::size_t index) const {
+    return m_rows.row(index);
+  }
+  
+  std::size_t Document::rowLength(std::size_t index) const {
+    return m_rows.rowLength(index);
+  }
+  
+  const char* Document::rowData(std::size_t index) const {
+    return m_rows.rowData(index);
+  }
+  
+  char Document::characterAt(const Location& location) const {
+    // Like std::string, reading one past the end of a row yields a null character.
+    if (location.row() >= m_rows.rows() || location.column() >= m_rows.rowLength(location.row())) {
+      return '\0';
+    }
+    
+    return m_rows.rowData(location.row())[location.column()];
   }
   
   std::string Document::indentOfRow(std::size_t index) const {
-    const std::string& text = row(index);
-    if (text.size() == 0) {
+    std::size_t length = m_rows.rowLength(index);
+    if (length == 0) {
       if (index == 0) {
         return "";
       } else {
@@ -140,16 +183,17 @@ namespace quip {
       }
     }
     
-    std::string::const_iterator cursor = text.begin();
-    while (std::isspace(*cursor)) {
+    const char* text = m_rows.rowData(index);
+    const char* cursor = text;
+    while (cursor != text + length && std::isspace(*cursor)) {
       ++cursor;
     }
     
-    return std::string(text.begin(), cursor);
+    return std::string(text, cursor);
   }
   
   std::size_t Document::rows() const {
-    return m_rows.size();
+    return m_rows.rows();
   }
 
   SelectionSet Document::insert(const Selection& selection, const std::string& text) {
@@ -171,64 +215,102 @@ namespace quip {
     std::vector<Selection> updated;
     updated.reserve(selections.count());
     
-    std::int64_t columnShift = 0;
-    std::int64_t rowShift = 0;
-    for (std::uint64_t index = 0; index < selections.count(); ++index) {
-      std::vector<std::string> lines = decompose(text[index]);
-      if (lines.size() == 0) {
-        continue;
-      }
-      
-      if (m_rows.size() == 0) {
-        // If the document is empty, just copy the entire lines array in and break the loop.
-        // The selection set is basically irrelevant; the only legal set for an empty document
-        // consists entirely of the single-character selection at (0, 0).
-        m_rows = lines;
-        updated.emplace_back(Location(m_rows.back().size(), m_rows.size() - 1));
-        break;
+    if (m_rows.rows() == 0) {
+      // If the document is empty, just copy the first non-empty text in. The selection set is
+      // basically irrelevant; the only legal set for an empty document consists entirely of the
+      // single-character selection at (0, 0).
+      for (std::uint64_t index = 0; index < selections.count() && index < text.size(); ++index) {
+        std::vector<std::string> lines = decompose(text[index]);
+        if (lines.size() > 0) {
+          m_rows.replace(0, 0, lines);
+          updated.emplace_back(Location(lines.back().size(), lines.size() - 1));
+          break;
+        }
       }
       
-      const Selection& selection = selections[index];
-      Location origin = selection.origin().adjustBy(columnShift, rowShift);
-      std::string prefix = m_rows[origin.row()].substr(0, origin.column());
-      std::string suffix = m_rows[origin.row()].substr(origin.column());
-      std::uint64_t rowsToInsert = lines.size() - 1;
-      if (lines.back().back() == '\n') {
-        ++rowsToInsert;
+      reportChange(DocumentChange(0, 0, m_rows.rows()));
+      return SelectionSet(updated);
+    }
+    
+    // Text inserted just past the last row, as at the end of a document that ends in a newline,
+    // starts a row of its own. The empty row is added up front so that it's rebuilt like any
+    // other, but it isn't reported as removed.
+    std::size_t last = std::min<std::size_t>(selections.count(), text.size()) - 1;
+    bool isPastLastRow = selections[last].origin().row() == m_rows.rows() && !text[last].empty();
+    if (isPastLastRow) {
+      m_rows.replace(m_rows.rows(), 0, std::vector<std::string>(1, std::string()));
+    }
+    
+    // The new rows are built in a single sweep over the selections, which are sorted. Rows
+    // between selections are carried over as they are; only the text of rows with insertion
+    // points on them is rebuilt. The row currently being composed is held in a buffer until
+    // the rest of the original row it was started from has been appended to it.
+    PieceTable::Builder builder(m_rows);
+    std::string composed;
+    bool isComposing = false;
+    std::size_t firstRow = 0;
+    std::size_t sourceRow = 0;
+    std::size_t sourceColumn = 0;
+    
+    std::vector<std::size_t> newlines;
+    for (std::uint64_t index = 0; index < selections.count() && index < text.size(); ++index) {
+      const std::string& insertion = text[index];
+      if (insertion.empty()) {
+        continue;
       }
       
-      // Compose resulting text, inserting rows as needed.
-      m_rows[origin.row()] = prefix + lines.front();
-      m_rows.insert(m_rows.begin() + origin.row() + 1, rowsToInsert, "");
-      for (std::uint64_t line = 1; line <= lines.size() - 1; ++line) {
-        m_rows[origin.row() + line] = lines[line];
+      Location origin = selections[index].origin();
+      if (isComposing && origin.row() == sourceRow) {
+        composed.append(m_rows.rowData(sourceRow) + sourceColumn, origin.column() - sourceColumn);
+      } else {
+        if (isComposing) {
+          composed.append(m_rows.rowData(sourceRow) + sourceColumn, m_rows.rowLength(sourceRow) - sourceColumn);
+          builder.appendRow(composed);
+          ++sourceRow;
+        }
+        
+        if (!isComposing) {
+          firstRow = origin.row();
+        }
+        
+        builder.copyRows(sourceRow, origin.row() - sourceRow);
+        sourceRow = origin.row();
+        composed.assign(m_rows.rowData(sourceRow), origin.column());
+        isComposing = true;
       }
       
-      m_rows[origin.row() + rowsToInsert] += suffix;
+      sourceColumn = origin.column();
       
-      // Update shifts to track how this selection impacts any subsequent selections.
-      columnShift += lines.front().size();
-      rowShift += rowsToInsert;
-      if (index + 1 < selections.count()) {
-        const Selection& next = selections[index + 1];
-        if (selection.extent().row() != next.origin().row()) {
-          // Whether or not adjacent selections have the same line in common impacts how
-          // to shift the next selection.
-          columnShift = 0;
-        }
+      // Every newline in the inserted text completes the row being composed.
+      newlines.clear();
+      findNewlines(insertion.data(), insertion.size(), newlines);
+      std::size_t start = 0;
+      for (std::size_t newline : newlines) {
+        composed.append(insertion, start, newline + 1 - start);
+        builder.appendRow(composed);
+        composed.clear();
+        start = newline + 1;
       }
       
+      composed.append(insertion, start, std::string::npos);
+      
       // Insert operations displace selections such that the origin remains after the
       // text that was inserted.
-      if (rowsToInsert == 0) {
-        updated.emplace_back(Location(origin.column() + lines.front().size(), origin.row()));
-      } else {
-        std::uint64_t row = origin.row() + rowsToInsert;
-        updated.emplace_back(Location(m_rows[row].size() - suffix.size(), row));
-      }
+      updated.emplace_back(Location(composed.size(), builder.rows()));
     }
     
-    m_documentModifiedSignal.transmit();
+    if (isComposing) {
+      composed.append(m_rows.rowData(sourceRow) + sourceColumn, m_rows.rowLength(sourceRow) - sourceColumn);
+      builder.appendRow(composed);
+      ++sourceRow;
+    }
+    
+    // Only the rows from the first insertion point to the last one were rebuilt.
+    DocumentChange change(firstRow, sourceRow - firstRow - (isPastLastRow ? 1 : 0), builder.rows() - firstRow);
+    builder.copyRows(sourceRow, m_rows.rows() - sourceRow);
+    builder.commit();
+    
+    reportChange(change);
     return SelectionSet(updated);
   }
   
@@ -263,7 +345,7 @@ namespace quip {
   }
   
   SelectionSet Document::erase(const SelectionSet& selections) {
-    if (m_rows.size() == 0 || selections.count() == 0) {
+    if (m_rows.rows() == 0 || selections.count() == 0) {
       return selections;
     }
     
@@ -271,177 +353,271 @@ namespace quip {
     // can be reserved up front.
     std::vector<Selection> updated;
     updated.reserve(selections.count());
-
-    std::int64_t columnShift = 0;
-    std::int64_t rowShift = 0;
-    for (std::uint64_t index = 0; index < selections.count(); ++index) {
-      const Selection& selection = selections[index];
-      Location origin = selection.origin().adjustBy(columnShift, rowShift);
-      Location extent = selection.extent().adjustBy(selection.height() == 1 ? columnShift : 0, rowShift);
-      std::int64_t rowsToRemove = extent.row() - origin.row();
-      
-      // Whether or not the selection covers the trailing newline of a row or
-      // includes the last row in the document impacts how the erasure is handled.
-      bool hasLastCharacterInRow = extent.column() == row(extent.row()).size() - 1;
-      bool hasLastRowInDocument = extent.row() == m_rows.size() - 1;
-      
-      // Determine how many rows to remove and how to compose the resulting text.
-      std::string prefix = m_rows[origin.row()].substr(0, origin.column());
-      std::string suffix;
-      if (hasLastCharacterInRow && !hasLastRowInDocument) {
-        suffix = m_rows[extent.row() + 1];
-        ++rowsToRemove;
+    
+    // The surviving text is written into new rows in a single sweep over the selections, which
+    // are sorted and don't overlap. Rows between selections are carried over as they are. The
+    // row currently being composed is held in a buffer, since erasing a newline joins the text
+    // before the selection with the row that follows it.
+    PieceTable::Builder builder(m_rows);
+    std::string composed;
+    bool isComposing = false;
+    std::size_t sourceRow = 0;
+    std::size_t sourceColumn = 0;
+    
+    for (const Selection& selection : selections) {
+      Location origin = selection.origin();
+      Location extent = selection.extent();
+      if (isComposing && origin.row() == sourceRow) {
+        composed.append(m_rows.rowData(sourceRow) + sourceColumn, origin.column() - sourceColumn);
       } else {
-        suffix = m_rows[extent.row()].substr(extent.column() + 1);
-      }
-
-      // Update shifts to track how this selection impacts any subsequent selections.
-      rowShift -= rowsToRemove;
-      if (rowsToRemove > 0) {
-        columnShift = 0;
-      }
-      
-      if (index + 1 < selections.count()) {
-        const Selection& next = selections[index + 1];
-        
-        // Whether or not adjacent selections have the same line in common or are only
-        // separated by a newline that will be removed impacts how to shift the
-        // next selection.
-        bool hasSameLine = selection.extent().row() == next.origin().row();
-        bool hasNextLine = selection.extent().row() == next.origin().row() - 1;
-        if (hasSameLine) {
-          columnShift -= extent.column() - origin.column() + 1;
-        } else if (hasNextLine && hasLastCharacterInRow) {
-          columnShift = extent.column();
-        } else {
-          columnShift = 0;
+        if (isComposing) {
+          composed.append(m_rows.rowData(sourceRow) + sourceColumn, m_rows.rowLength(sourceRow) - sourceColumn);
+          builder.appendRow(composed);
+          ++sourceRow;
         }
+        
+        builder.copyRows(sourceRow, origin.row() - sourceRow);
+        sourceRow = origin.row();
+        composed.assign(m_rows.rowData(sourceRow), origin.column());
+        isComposing = true;
       }
       
-      // Remove rows and write composed text.
-      std::vector<std::string>::iterator firstRemovedRow = m_rows.begin() + origin.row();
-      std::vector<std::string>::iterator lastRemovedRow = firstRemovedRow + rowsToRemove;
-      m_rows.erase(firstRemovedRow, lastRemovedRow);
-      m_rows[origin.row()] = prefix + suffix;
+      // Skip past the selected text. Whether or not the selection covers the trailing newline
+      // of a row that isn't the last row determines where the surviving text resumes.
+      bool hasLastCharacterInRow = extent.column() == m_rows.rowLength(extent.row()) - 1;
+      bool hasLastRowInDocument = extent.row() == m_rows.rows() - 1;
+      if (hasLastCharacterInRow && !hasLastRowInDocument) {
+        sourceRow = extent.row() + 1;
+        sourceColumn = 0;
+      } else {
+        sourceRow = extent.row();
+        sourceColumn = extent.column() + 1;
+      }
       
-      // Erase operations collapse selections to the origin, generally. However, it's
-      // possible that the origin no longer exists.
-      if (origin <= Location(m_rows.back().size() - 1, m_rows.size() - 1)) {
-        updated.emplace_back(origin);
-      } else if (origin.column() > 0) {
-        updated.emplace_back(origin.adjustBy(-1, 0));
-      } else if (origin.row() > 0) {
-        std::uint64_t row = origin.row() - 1;
-        updated.emplace_back(Location(m_rows[row].size() - 1, row));
+      // Erase operations collapse selections to the origin, generally. However, if no text
+      // follows the selection, the origin no longer exists and the selection collapses to the
+      // character before it instead.
+      bool hasRemainingText = sourceRow + 1 < m_rows.rows() || sourceColumn < m_rows.rowLength(sourceRow);
+      if (hasRemainingText || composed.empty()) {
+        updated.emplace_back(Location(composed.size(), builder.rows()));
       } else {
-        updated.emplace_back(Location(0, 0));
+        updated.emplace_back(Location(composed.size() - 1, builder.rows()));
       }
     }
     
+    composed.append(m_rows.rowData(sourceRow) + sourceColumn, m_rows.rowLength(sourceRow) - sourceColumn);
+    builder.appendRow(composed);
+    
+    // Only the rows from the first selection to the last one were rebuilt.
+    std::size_t firstRow = selections[0].origin().row();
+    DocumentChange change(firstRow, sourceRow + 1 - firstRow, builder.rows() - firstRow);
+    builder.copyRows(sourceRow + 1, m_rows.rows() - sourceRow - 1);
+    builder.commit();
+    
     // If the very last character of the document was removed, also remove the
     // very last row so that the document's internal text state is consistent with
     // a default-constructed, empty document.
-    if (m_rows.size() == 1 && m_rows.back().size() == 0) {
+    if (m_rows.rows() == 1 && m_rows.rowLength(0) == 0) {
       m_rows.clear();
+      change.insertedRows = 0;
     }
     
-    m_documentModifiedSignal.transmit();
+    reportChange(change);
     return SelectionSet(updated);
   }
   
   SelectionSet Document::matches(const SearchExpression& expression) const {
     std::vector<Selection> results;
-    if (expression.valid()) {
-      std::string content;
-      std::vector<std::size_t> table = buildSpanTable(&content);
-      std::sregex_iterator cursor(content.begin(), content.end(), expression.pattern(), std::regex_constants::match_not_null);
-      std::sregex_iterator end;
+    matches(expression, [&results] (const std::vector<Selection>& found) {
+      results.insert(results.end(), found.begin(), found.end());
+      return true;
+    });
+    
+    return SelectionSet(results);
+  }
+  
+  bool Document::matches(const SearchExpression& expression, const std::function<bool (const std::vector<Selection>&)>& visitor) const {
+    if (!expression.valid() || m_rows.rows() == 0) {
+      return true;
+    }
+    
+    // Rather than copying the whole document into one string, rows are copied into a window
+    // of bounded size and searched a window at a time. Matches are visited in order, so each
+    // one is mapped to a location by walking forward from the previous one.
+    //
+    // A match can't contain more newlines than the engine allows, so one that begins at least
+    // that many rows before the end of a window lies within it, along with any text that could
+    // have made it longer or pre-empted it. Later matches are deferred: the next window begins
+    // that many rows before the end of this one, searching from where the last accepted match
+    // ended. Windows hold at least twice as many rows as they overlap, so that each one moves on
+    // by at least as many rows as it searches again. Expressions whose matches could span as
+    // many rows as the document has are searched for in the whole document at once.
+    const SearchEngine& engine = expression.engine();
+    std::unique_ptr<SearchEngine::State> state = engine.createState();
+    const std::size_t overlap = engine.maximumNewlines();
+    const bool isWindowed = overlap < m_rows.rows();
+    std::string window;
+    std::vector<Selection> windowResults;
+    std::size_t firstRow = 0;
+    std::size_t firstColumn = 0;
+    while (firstRow < m_rows.rows()) {
+      // Windows after the first are preceded by the newline ending the row before them, so
+      // that word boundaries at the start of the window behave as they would within the
+      // whole document.
+      window.clear();
+      std::size_t base = 0;
+      if (firstRow > 0) {
+        window.push_back('\n');
+        base = 1;
+      }
+      
+      std::size_t lastRow = firstRow;
+      do {
+        window.append(m_rows.rowData(lastRow), m_rows.rowLength(lastRow));
+        ++lastRow;
+      } while (lastRow < m_rows.rows() && (!isWindowed || window.size() < SearchWindowSize || lastRow - firstRow <= 2 * overlap));
+      
+      bool isFinal = lastRow == m_rows.rows();
+      std::size_t row = firstRow;
+      std::size_t rowStart = base;
+      windowResults.clear();
       
-      while (cursor != end) {
-        auto match = *cursor;
-        if (match.length() == 0) {
-          // https://llvm.org/bugs/show_bug.cgi?id=21597 notes that libc++ doesn't currently
-          // respect the "ignore empty matches" flag passed above. This can cause partially-entered
-          // expressions containing \b assertions to generate an infinite loop, since incrementing
-          // the iterator will never actually advance it. As a workaround, matches for a row are
-          // aborted if any are empty, since that should only occur in the context of the libc++ bug.
+      SearchMatch match;
+      std::size_t offset = base + firstColumn;
+      while (offset < window.size() && engine.search(window.data(), window.size(), offset, firstRow == 0, isFinal, *state, match)) {
+        std::size_t position = match.position;
+        std::size_t last = position + match.length - 1;
+        while (position >= rowStart + m_rows.rowLength(row)) {
+          rowStart += m_rows.rowLength(row++);
+        }
+        
+        if (!isFinal && row + overlap >= lastRow) {
           break;
         }
         
-        for (std::size_t matchIndex = 0; matchIndex < match.size(); ++matchIndex) {
-          Location origin = linearPositionToLocation(table, cursor->position());
-          Location extent = linearPositionToLocation(table, cursor->position() + cursor->length() - 1);
-          results.emplace_back(origin, extent);
+        Location origin(position - rowStart, row);
+        while (last >= rowStart + m_rows.rowLength(row)) {
+          rowStart += m_rows.rowLength(row++);
         }
         
-        ++cursor;
+        windowResults.emplace_back(origin, Location(last - rowStart, row));
+        offset = position + match.length;
+      }
+      
+      if (!visitor(windowResults)) {
+        return false;
       }
+      
+      std::size_t resumeRow = isFinal ? lastRow : lastRow - overlap;
+      std::size_t resumeColumn = 0;
+      if (!windowResults.empty() && windowResults.back().extent().row() >= resumeRow) {
+        resumeRow = windowResults.back().extent().row();
+        resumeColumn = windowResults.back().extent().column() + 1;
+      }
+      
+      firstRow = resumeRow;
+      firstColumn = resumeColumn;
     }
     
-    return SelectionSet(results);
+    return true;
+  }
+  
+  std::shared_ptr<const Document> Document::snapshot() const {
+    std::shared_ptr<Document> result(new Document(m_rows));
+    result->setPath(m_path);
+    return result;
   }
   
-  Signal<void()>& Document::onDocumentModified() {
+  void Document::restore(const Document& version) {
+    std::size_t prefix = m_rows.commonPrefix(version.m_rows);
+    std::size_t suffix = m_rows.commonSuffix(version.m_rows, std::min(m_rows.rows(), version.m_rows.rows()) - prefix);
+    DocumentChange change(prefix, m_rows.rows() - prefix - suffix, version.m_rows.rows() - prefix - suffix);
+    
+    m_rows = version.m_rows;
+    if (change.removedRows > 0 || change.insertedRows > 0) {
+      reportChange(change);
+    }
+  }
+  
+  std::size_t Document::unsharedFootprint(const Document& other) const {
+    return m_rows.unsharedFootprint(other.m_rows);
+  }
+  
+  Signal<void (const DocumentChange&)>& Document::onDocumentModified() {
     return m_documentModifiedSignal;
   }
   
+  void Document::beginBatch() {
+    ++m_batchDepth;
+  }
+  
+  void Document::endBatch() {
+    if (m_batchDepth == 0) {
+      std::cerr << "Ended a batch of modifications that was never begun." << std::endl;
+      return;
+    }
+    
+    if (--m_batchDepth == 0 && m_batchedChange.has_value()) {
+      DocumentChange change = m_batchedChange.value();
+      m_batchedChange = Optional<DocumentChange>();
+      m_documentModifiedSignal.transmit(change);
+    }
+  }
+  
+  std::shared_ptr<Document> Document::openMapped(const std::string& path) {
+    std::shared_ptr<MappedFile> file = MappedFile::open(path);
+    if (file == nullptr) {
+      return nullptr;
+    }
+    
+    std::shared_ptr<Document> result(new Document(file));
+    result->setPath(path);
+    return result;
+  }
+  
   std::vector<std::string> Document::decompose(const std::string& text) const {
     std::vector<std::string> results;
     if (text.size() == 0) {
       return results;
     }
     
+    std::vector<std::size_t> newlines;
+    findNewlines(text.data(), text.size(), newlines);
+    results.reserve(newlines.size() + 1);
+    
     std::string::size_type start = 0;
-    std::string::size_type end = 0;
-    while (start < text.size()) {
-      end = text.find_first_of('\n', start);
-      if (end != std::string::npos) {
-        results.emplace_back(text.substr(start, end - start + 1));
-        start = end + 1;
-      } else {
-        results.emplace_back(text.substr(start));
-        break;
-      }
+    for (std::size_t newline : newlines) {
+      results.emplace_back(text, start, newline - start + 1);
+      start = newline + 1;
+    }
+    
+    if (start < text.size()) {
+      results.emplace_back(text, start);
     }
     
     return results;
   }
   
-  std::vector<std::size_t> Document::buildSpanTable(std::string * contents) const {
-    // A "span table" accelerates the process of finding a column/row location
-    // from a linear index into the document.
-    std::vector<std::size_t> table;
-    table.reserve(m_rows.size());
-    
-    std::ostringstream stream;
-    std::size_t length = 0;
-    for (const std::string& text : m_rows) {
-      if (contents != nullptr) {
-        stream << text;
-      }
-      
-      length += text.size();
-      table.emplace_back(length);
-    }
-    
-    if (contents != nullptr) {
-      *contents = stream.str();
+  void Document::reportChange(const DocumentChange& change) {
+    if (m_batchDepth == 0) {
+      m_documentModifiedSignal.transmit(change);
+      return;
     }
     
-    return table;
-  }
-  
-  Location Document::linearPositionToLocation(const std::vector<std::size_t>& spanTable, std::size_t position) const {
-    std::vector<std::size_t>::const_iterator span = std::lower_bound(spanTable.begin(), spanTable.end(), position);
-    auto row = span - spanTable.begin();
-    if (position == *span) {
-      // If the position precisely matches a span entry, it's actually the next
-      // row that's interesting.
-      ++row;
-      ++span;
+    if (!m_batchedChange.has_value()) {
+      m_batchedChange = change;
+      return;
     }
     
-    std::size_t column = m_rows[row].size() - (*span - position);
-    return Location(column, row);
+    // The batched change covers rows of the original text, and rows of the text as it is now,
+    // while the new change covers rows of the text as it is now. Whichever of the two reaches
+    // further on either side bounds the combined change, and the rows past its end have simply
+    // moved.
+    const DocumentChange& batched = m_batchedChange.value();
+    std::size_t first = std::min(batched.firstRow, change.firstRow);
+    std::size_t end = std::max(batched.firstRow + batched.insertedRows, change.firstRow + change.removedRows);
+    std::size_t originalEnd = end - batched.insertedRows + batched.removedRows;
+    std::size_t currentEnd = end - change.removedRows + change.insertedRows;
+    m_batchedChange = DocumentChange(first, originalEnd - first, currentEnd - first);
   }
 }
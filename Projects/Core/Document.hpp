@@ -1,13 +1,19 @@
 #pragma once
 
+#include "DocumentChange.hpp"
 #include "Location.hpp"
+#include "Optional.hpp"
+#include "PieceTable.hpp"
 #include "Signal.hpp"
 
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace quip {
   struct DocumentIterator;
+  struct MappedFile;
   struct SearchExpression;
   struct Selection;
   struct SelectionSet;
@@ -15,6 +21,7 @@ namespace quip {
   struct Document {
     Document();
     explicit Document(const std::string& contents);
+    explicit Document(std::string&& contents);
     
     bool isEmpty() const noexcept;
     bool isMissingTrailingNewline() const noexcept;
@@ -34,7 +41,12 @@ namespace quip {
     void setPath(const std::string& path);
 
     std::size_t rows() const;
-    const std::string& row(std::size_t index) const;
+    std::string row(std::size_t index) const;
+    std::size_t rowLength(std::size_t index) const;
+    
+    // The text of a row, without copying it. Only valid until the document is next modified.
+    const char* rowData(std::size_t index) const;
+    char characterAt(const Location& location) const;
     
     std::string indentOfRow(std::size_t index) const;
 
@@ -50,18 +62,54 @@ namespace quip {
     SelectionSet erase(const SelectionSet& selections);
     
     SelectionSet matches(const SearchExpression& expression) const;
-        
-    Signal<void()>& onDocumentModified();
+    
+    // Search the document a window of rows at a time, passing the matches found in each window
+    // to a visitor, in order. Returning false from the visitor stops the search, in which case
+    // this returns false as well.
+    bool matches(const SearchExpression& expression, const std::function<bool (const std::vector<Selection>&)>& visitor) const;
+    
+    // A copy of the document as it is now, unaffected by later modifications. Taking a snapshot
+    // takes constant time and doesn't copy any text. A snapshot may be read on another thread,
+    // through its iterators or any of its other const members, while the document continues to
+    // be edited.
+    std::shared_ptr<const Document> snapshot() const;
+    
+    // Replace the text of the document with that of another, typically a snapshot of an earlier
+    // version of it. Only the rows that differ are reported as modified, and finding them only
+    // looks inside the chunks of rows the two versions don't share.
+    void restore(const Document& version);
+    
+    // Roughly how many bytes of memory the document's rows use that another version of it
+    // doesn't share, not counting their text, which every version shares.
+    std::size_t unsharedFootprint(const Document& other) const;
+    
+    // Transmitted after every modification, describing the rows that were affected.
+    Signal<void (const DocumentChange&)>& onDocumentModified();
+    
+    // Defer notification of modifications until the batch ends, at which point they're reported
+    // as a single change spanning every row any of them affected. Batches may be nested, in which
+    // case the change is reported when the outermost one ends.
+    void beginBatch();
+    void endBatch();
+    
+    // Open a document by memory-mapping the file at the specified path. Only the row index
+    // is built up front; the text of each row is read from the mapping until it is edited, so
+    // the file must not be truncated while the document is open. Returns null if the file
+    // cannot be opened.
+    static std::shared_ptr<Document> openMapped(const std::string& path);
     
   private:
     std::string m_path;    
-    std::vector<std::string> m_rows;
+    PieceTable m_rows;
     
-    Signal<void()> m_documentModifiedSignal;
+    Signal<void (const DocumentChange&)> m_documentModifiedSignal;
+    std::size_t m_batchDepth;
+    Optional<DocumentChange> m_batchedChange;
     
-    std::vector<std::string> decompose(const std::string& text) const;
+    explicit Document(std::shared_ptr<const MappedFile> file);
+    explicit Document(const PieceTable& rows);
     
-    std::vector<std::size_t> buildSpanTable(std::string* contents) const;
-    Location linearPositionToLocation(const std::vector<std::size_t>& spanTable, std::size_t position) const;
+    std::vector<std::string> decompose(const std::string& text) const;
+    void reportChange(const DocumentChange& change);
   };
 }
@@ -0,0 +1,9 @@
+#include "DocumentChange.hpp"
+
+namespace quip {
+  DocumentChange::DocumentChange(std::size_t firstRow, std::size_t removedRows, std::size_t insertedRows)
+  : firstRow(firstRow)
+  , removedRows(removedRows)
+  , insertedRows(insertedRows) {
+  }
+}
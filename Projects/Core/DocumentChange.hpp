@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+
+namespace quip {
+  // Describes the rows affected by a modification of a document: the given number of rows,
+  // starting at the first row, were replaced by the given number of new rows. Rows outside
+  // that range are unchanged, although rows after it may have moved.
+  struct DocumentChange {
+    std::size_t firstRow;
+    std::size_t removedRows;
+    std::size_t insertedRows;
+    
+    DocumentChange(std::size_t firstRow, std::size_t removedRows, std::size_t insertedRows);
+  };
+}
@@ -13,11 +13,11 @@ namespace quip {
   }
   
   char DocumentIterator::operator*() const {
-    return m_document->row(m_location.row())[m_location.column()];
+    return m_document->characterAt(m_location);
   }
   
   DocumentIterator& DocumentIterator::operator++() {
-    bool isOnLastColumn = m_location.column() == m_document->row(m_location.row()).length() - 1;
+    bool isOnLastColumn = m_location.column() == m_document->rowLength(m_location.row()) - 1;
     bool isOnLastRow = m_location.row() == m_document->rows() - 1;
     if (isOnLastColumn && !isOnLastRow) {
       m_location = Location(0, m_location.row() + 1);
@@ -37,7 +37,7 @@ namespace quip {
   DocumentIterator& DocumentIterator::operator--() {
     if (m_location.column() == 0) {
       std::size_t row = m_location.row() - 1;
-      m_location = Location(m_document->row(row).size() - 1, row);
+      m_location = Location(m_document->rowLength(row) - 1, row);
     } else {
       m_location = m_location.adjustBy(-1, 0);
     }
@@ -27,7 +27,6 @@ namespace quip {
   }
   
   void DrawingService::drawText(const std::string& text, const Coordinate& coordinate) {
-    std::vector<AttributeRange> attributes;
-    drawText(text, coordinate, attributes);
+    drawText(text, coordinate, AttributeSpan());
   }
 }
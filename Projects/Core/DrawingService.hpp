@@ -1,6 +1,6 @@
 #pragma once
 
-#include "AttributeRange.hpp"
+#include "AttributeArena.hpp"
 #include "Coordinate.hpp"
 #include "Extent.hpp"
 #include "Location.hpp"
@@ -29,7 +29,7 @@ namespace quip {
     
     void drawText (const std::string & text, const Coordinate& coordinate);
     
-    virtual void drawText (const std::string & text, const Coordinate& coordinate, const std::vector<AttributeRange>& attributes) = 0;
+    virtual void drawText (const std::string & text, const Coordinate& coordinate, AttributeSpan attributes) = 0;
     virtual Rectangle measureText (const std::string & text) = 0;
     
   protected:
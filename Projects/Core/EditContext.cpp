@@ -1,15 +1,18 @@
 #include "EditContext.hpp"
 
+#include "CTokenizer.hpp"
 #include "Document.hpp"
 #include "EditMode.hpp"
 #include "JumpMode.hpp"
 #include "Location.hpp"
 #include "Mode.hpp"
 #include "NormalMode.hpp"
+#include "PlainTokenizer.hpp"
 #include "SearchMode.hpp"
 #include "Selection.hpp"
 #include "Transaction.hpp"
 
+#include <iostream>
 #include <memory>
 
 namespace quip {
@@ -19,12 +22,23 @@ namespace quip {
   
   EditContext::EditContext(PopupService* popupService, StatusService* statusService, ScriptHost* scriptHost, std::shared_ptr<Document> document)
   : m_document(document)
+  , m_damageTracker(*document)
   , m_fileTypeDatabase(*scriptHost) 
   , m_selections(Selection(Location(0, 0)))
+  , m_isCoalescing(false)
+  , m_batchDepth(0)
+  , m_isBatchApplied(false)
   , m_popupService(popupService)
   , m_statusService(statusService) {
     
-    // Populate with standard file types.
+    // Populate with standard file types. The built-in syntaxes are parsed natively; their
+    // tokenizers mark rows exactly as their scripts do.
+    std::shared_ptr<const Tokenizer> plainTokenizer = std::make_shared<PlainTokenizer>();
+    m_fileTypeDatabase.registerTokenizer("text", plainTokenizer);
+    m_fileTypeDatabase.registerTokenizer("markdown", plainTokenizer);
+    m_fileTypeDatabase.registerTokenizer("cpp", std::make_shared<CTokenizer>());
+    m_fileTypeDatabase.registerTokenizer("glsl", plainTokenizer);
+    
     m_fileTypeDatabase.registerFileType("Text", "text", {"txt", "text"});
     m_fileTypeDatabase.registerFileType("Markdown", "markdown", {"md", "markdown"});
     m_fileTypeDatabase.registerFileType("C++ Source", "cpp", {"cpp", "cxx"});
@@ -59,12 +73,15 @@ namespace quip {
   }
   
   void EditContext::setOverlay(const std::string& name, const SelectionDrawInfo& overlay) {
+    clearOverlay(name);
     m_overlays[name] = overlay;
+    m_damageTracker.damageSelections(overlay.selections);
   }
   
   void EditContext::clearOverlay(const std::string& name) {
     auto cursor = m_overlays.find(name);
     if (cursor != std::end(m_overlays)) {
+      m_damageTracker.damageSelections(cursor->second.selections);
       m_overlays.erase(cursor);
     }
   }
@@ -78,6 +95,10 @@ namespace quip {
     if (cursor != m_modes.end()) {
       m_modeHistory.push(cursor->second);
       mode().enter(*this, how);
+      m_isCoalescing = false;
+      
+      // The selections are drawn in the new mode's cursor style.
+      m_damageTracker.damageSelections(m_selections);
     }
   }
   
@@ -85,48 +106,139 @@ namespace quip {
     if (m_modeHistory.size() > 1) {
       mode().exit(*this);
       m_modeHistory.pop();
+      m_isCoalescing = false;
+      
+      m_damageTracker.damageSelections(m_selections);
     }
   }
   
+  bool EditContext::tick() {
+    bool isChanged = mode().tick(*this);
+    while (!m_deferredKeys.empty() && !mode().defersKeys()) {
+      KeyEvent event = m_deferredKeys.front();
+      m_deferredKeys.pop_front();
+      mode().processKeyEvent(event.key, event.modifiers, event.text, *this);
+      isChanged = true;
+    }
+    
+    return isChanged;
+  }
+  
   void EditContext::performTransaction(std::shared_ptr<Transaction> transaction) {
+    m_isCoalescing = false;
+    if (m_batchDepth > 0) {
+      transaction->perform(*this);
+      m_isBatchApplied = true;
+      return;
+    }
+    
+    m_undoLog.beginStep(m_selections);
     transaction->perform(*this);
+    m_undoLog.endStep(*m_document, m_selections);
+    
+    m_damageTracker.trackSelections(m_selections);
     m_onTransactionApplied.transmit(ChangeType::Do);
-    m_undoStack.push(transaction);
+  }
+  
+  void EditContext::coalesceTransaction(std::shared_ptr<Transaction> transaction) {
+    if (m_batchDepth > 0) {
+      performTransaction(transaction);
+      return;
+    }
+    
+    // The selections are compared with those the last coalesced transaction left behind, so
+    // that moving them in between starts a new step.
+    bool isResumed = m_isCoalescing && m_selections == m_coalescedSelections && m_undoLog.resumeStep();
+    if (!isResumed) {
+      m_undoLog.beginStep(m_selections);
+    }
+    
+    transaction->perform(*this);
+    m_undoLog.endStep(*m_document, m_selections);
+    m_isCoalescing = true;
+    m_coalescedSelections = m_selections;
+    
+    m_damageTracker.trackSelections(m_selections);
+    m_onTransactionApplied.transmit(ChangeType::Do);
+  }
+  
+  void EditContext::beginBatch() {
+    if (m_batchDepth++ > 0) {
+      return;
+    }
+    
+    m_isCoalescing = false;
+    m_isBatchApplied = false;
+    m_undoLog.beginStep(m_selections);
+    m_document->beginBatch();
+  }
+  
+  void EditContext::endBatch() {
+    if (m_batchDepth == 0) {
+      std::cerr << "Ended a batch of transactions that was never begun." << std::endl;
+      return;
+    }
+    
+    if (--m_batchDepth > 0) {
+      return;
+    }
+    
+    m_undoLog.endStep(*m_document, m_selections);
+    m_document->endBatch();
+    if (m_isBatchApplied) {
+      m_damageTracker.trackSelections(m_selections);
+      m_onTransactionApplied.transmit(ChangeType::Do);
+    }
   }
   
   bool EditContext::canUndo() const noexcept {
-    return m_undoStack.size() > 0;
+    return m_undoLog.canUndo();
   }
   
   void EditContext::undo() {
-    if (canUndo()) {
-      m_undoStack.top()->rollback(*this);
+    m_isCoalescing = false;
+    if (m_undoLog.undo(*m_document, m_selections)) {
+      m_damageTracker.trackSelections(m_selections);
       m_onTransactionApplied.transmit(ChangeType::Undo);
-      m_redoStack.push(m_undoStack.top());
-      
-      m_undoStack.pop();
     }
   }
   
   bool EditContext::canRedo() const noexcept {
-    return m_redoStack.size() > 0;
+    return m_undoLog.canRedo();
   }
   
   void EditContext::redo() {
-    if (canRedo()) {
-      m_redoStack.top()->perform(*this);
+    m_isCoalescing = false;
+    if (m_undoLog.redo(*m_document, m_selections)) {
+      m_damageTracker.trackSelections(m_selections);
       m_onTransactionApplied.transmit(ChangeType::Redo);
-      m_undoStack.push(m_redoStack.top());
-
-      m_redoStack.pop();
     }
   }
   
+  void EditContext::travelTo(UndoLog::Clock::time_point time) {
+    m_isCoalescing = false;
+    std::size_t step = m_undoLog.findStep(time);
+    if (step != m_undoLog.currentStep() && m_undoLog.travel(*m_document, m_selections, step)) {
+      m_damageTracker.trackSelections(m_selections);
+      m_onTransactionApplied.transmit(ChangeType::Undo);
+    }
+  }
+  
+  UndoLog& EditContext::undoLog() {
+    return m_undoLog;
+  }
+  
   bool EditContext::processKeyEvent(Key key, Modifiers modifiers) {
     return mode().processKeyEvent(key, modifiers, *this);
   }
   
   bool EditContext::processKeyEvent(Key key, Modifiers modifiers, const std::string& text) {
+    // Keys already waiting go first, so keys are always processed in the order they're pressed.
+    if (mode().defersKeys() || !m_deferredKeys.empty()) {
+      m_deferredKeys.push_back(KeyEvent{key, modifiers, text});
+      return true;
+    }
+    
     return mode().processKeyEvent(key, modifiers, text, *this);
   }
   
@@ -146,6 +258,10 @@ namespace quip {
     return m_fileTypeDatabase;
   }
   
+  DamageTracker& EditContext::damageTracker() {
+    return m_damageTracker;
+  }
+  
   Signal<void (ChangeType)>& EditContext::onTransactionApplied() {
     return m_onTransactionApplied;
   }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ChangeType.hpp"
+#include "DamageTracker.hpp"
 #include "FileTypeDatabase.hpp"
 #include "Key.hpp"
 #include "Modifiers.hpp"
@@ -9,8 +10,10 @@
 #include "SelectionSet.hpp"
 #include "Signal.hpp"
 #include "StatusService.hpp"
+#include "UndoLog.hpp"
 #include "ViewController.hpp"
 
+#include <deque>
 #include <map>
 #include <memory>
 #include <stack>
@@ -38,12 +41,35 @@ namespace quip {
     void enterMode (const std::string & name, std::uint64_t how);
     void leaveMode ();
     
+    // Perform periodic work for the current mode, then process any keys it was deferring once
+    // it's done. Returns true if the view should be redrawn.
+    bool tick ();
+    
     void performTransaction (std::shared_ptr<Transaction> transaction);
     
+    // Perform a transaction, merging it into the previous step of history if that was coalesced
+    // too. Runs of typing are coalesced this way, so that they're undone all at once. Changing
+    // modes, moving the selections or performing any other transaction starts a new step.
+    void coalesceTransaction (std::shared_ptr<Transaction> transaction);
+    
+    // Group the transactions performed until the batch ends, and any changes of mode or
+    // selection made in between, into a single step of history. The document's modifications are
+    // reported as one change and transactions as one application when the batch ends, so
+    // listeners run once for the whole batch. Batches may be nested.
+    void beginBatch ();
+    void endBatch ();
+    
     bool canUndo () const noexcept;
     void undo ();
     bool canRedo () const noexcept;
     void redo ();
+    
+    // Bring the document back to how it was just after the last step made at or before the
+    // given time, on whichever branch of history that step is.
+    void travelTo (UndoLog::Clock::time_point time);
+    
+    // The history of transactions performed, for undo and redo.
+    UndoLog & undoLog ();
 
     bool processKeyEvent(Key key, Modifiers modifiers);
     bool processKeyEvent(Key key, Modifiers modifiers, const std::string& text);
@@ -54,10 +80,22 @@ namespace quip {
     
     const FileTypeDatabase& fileTypeDatabase () const;
     
+    // The rows of the document that need to be drawn again. Modifications of the document,
+    // overlays and modes damage rows by themselves, as do changes of selection made by
+    // transactions; other changes of selection are found by tracking the selections.
+    DamageTracker & damageTracker ();
+    
     Signal<void (ChangeType)> & onTransactionApplied ();
     
   private:
+    struct KeyEvent {
+      Key key;
+      Modifiers modifiers;
+      std::string text;
+    };
+    
     std::shared_ptr<Document> m_document;
+    DamageTracker m_damageTracker;
     FileTypeDatabase m_fileTypeDatabase;
     
     SelectionSet m_selections;
@@ -66,8 +104,14 @@ namespace quip {
     std::map<std::string, std::shared_ptr<Mode>> m_modes;
     std::stack<std::shared_ptr<Mode>> m_modeHistory;
     
-    std::stack<std::shared_ptr<Transaction>> m_undoStack;
-    std::stack<std::shared_ptr<Transaction>> m_redoStack;
+    // Keys pressed while the current mode was deferring them, in the order they were pressed.
+    std::deque<KeyEvent> m_deferredKeys;
+    
+    UndoLog m_undoLog;
+    bool m_isCoalescing;
+    std::size_t m_batchDepth;
+    bool m_isBatchApplied;
+    SelectionSet m_coalescedSelections;
     
     ViewController m_controller;
     PopupService* m_popupService;
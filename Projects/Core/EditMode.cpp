@@ -27,7 +27,7 @@ namespace quip {
             continue;
           }
           
-          origin = Location(context.document().row(origin.row() - 1).length() - 1, origin.row() - 1);
+          origin = Location(context.document().rowLength(origin.row() - 1) - 1, origin.row() - 1);
         }
         else {
           origin = origin.adjustBy(-bias, 0);
@@ -45,8 +45,7 @@ namespace quip {
       
       SelectionSet set(adjusted);
       if (set.count() > 0) {
-        context.document().erase(set);
-        context.selections().replace(SelectionSet(replacement));
+        context.coalesceTransaction(EraseTransaction::create(set, SelectionSet(replacement)));
       }
     }
   }
@@ -89,9 +88,9 @@ namespace quip {
     switch (key) {
       case Key::Tab:
         if (m_useAppendBehavior) {
-          context.performTransaction(AppendTransaction::create(context.selections(), "  "));
+          context.coalesceTransaction(AppendTransaction::create(context.selections(), "  "));
         } else {
-          context.performTransaction(InsertTransaction::create(context.selections(), "  "));
+          context.coalesceTransaction(InsertTransaction::create(context.selections(), "  "));
         }
         return true;
       case Key::Delete:
@@ -113,15 +112,15 @@ namespace quip {
             }
             
             if (m_useAppendBehavior) {
-              context.performTransaction(AppendTransaction::create(context.selections(), indented));
+              context.coalesceTransaction(AppendTransaction::create(context.selections(), indented));
             } else {
-              context.performTransaction(InsertTransaction::create(context.selections(), indented));
+              context.coalesceTransaction(InsertTransaction::create(context.selections(), indented));
             }
           } else {
             if (m_useAppendBehavior) {
-              context.performTransaction(AppendTransaction::create(context.selections(), text));
+              context.coalesceTransaction(AppendTransaction::create(context.selections(), text));
             } else {
-              context.performTransaction(InsertTransaction::create(context.selections(), text));
+              context.coalesceTransaction(InsertTransaction::create(context.selections(), text));
             }
           }
           
@@ -2,28 +2,35 @@
 
 #include "Document.hpp"
 #include "EditContext.hpp"
+#include "UndoLog.hpp"
 
 namespace quip {
   EraseTransaction::EraseTransaction(const SelectionSet& selections)
   : m_selections(selections) {
   }
   
-  EraseTransaction::~EraseTransaction() {
+  EraseTransaction::EraseTransaction(const SelectionSet& selections, const SelectionSet& replacement)
+  : m_selections(selections)
+  , m_replacement(replacement) {
   }
   
-  void EraseTransaction::perform(EditContext& context) {
-    // Capture the text covered by the selections prior to erasing it so that it
-    // can be restored later.
-    m_text = context.document().contents(m_selections);
-    
-    context.selections().replace(context.document().erase(m_selections));
+  EraseTransaction::~EraseTransaction() {
   }
   
-  void EraseTransaction::rollback(EditContext& context) {
-    context.selections().replace(context.document().insert(m_selections, m_text));
+  void EraseTransaction::perform(EditContext& context) {
+    // The text covered by the selections is recorded prior to erasing it so that it can be
+    // restored later.
+    Document& document = context.document();
+    context.undoLog().recordErasure(document, m_selections);
+    SelectionSet erased = document.erase(m_selections);
+    context.selections().replace(m_replacement ? *m_replacement : erased);
   }
   
   std::shared_ptr<Transaction> EraseTransaction::create(const SelectionSet& selections) {
     return std::make_shared<EraseTransaction>(selections);
   }
+  
+  std::shared_ptr<Transaction> EraseTransaction::create(const SelectionSet& selections, const SelectionSet& replacement) {
+    return std::make_shared<EraseTransaction>(selections, replacement);
+  }
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Optional.hpp"
 #include "SelectionSet.hpp"
 #include "Transaction.hpp"
 
@@ -11,15 +12,18 @@ namespace quip {
   
   struct EraseTransaction : Transaction {
     EraseTransaction (const SelectionSet & selections);
+    EraseTransaction (const SelectionSet & selections, const SelectionSet & replacement);
     ~EraseTransaction ();
     
     void perform (EditContext & context) override;
-    void rollback (EditContext & context) override;
     
     static std::shared_ptr<Transaction> create (const SelectionSet & selections);
     
+    // Erase the selections, leaving the given selections behind rather than the collapsed ones.
+    static std::shared_ptr<Transaction> create (const SelectionSet & selections, const SelectionSet & replacement);
+    
   private:
     SelectionSet m_selections;
-    std::vector<std::string> m_text;
+    Optional<SelectionSet> m_replacement;
   };
 }
\ No newline at end of file
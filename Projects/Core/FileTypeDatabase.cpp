@@ -6,7 +6,7 @@ namespace quip {
   FileTypeDatabase::FileTypeDatabase(ScriptHost& scriptHost)
   : m_scriptHost(scriptHost) {
     m_unknownFileType.name = "?";
-    m_unknownFileType.syntax = m_scriptHost.getScript(m_scriptHost.scriptRootPath() + "/syntax/text.lua");
+    m_unknownFileType.syntax = getSyntax("text");
   }
   
   void FileTypeDatabase::registerFileType(const std::string& displayName, const std::string& canonicalName, const std::vector<std::string>& extensions) {
@@ -14,13 +14,34 @@ namespace quip {
     
     FileType* type = m_knownTypes.back().get();
     type->name = displayName;
-    type->syntax = m_scriptHost.getScript(m_scriptHost.scriptRootPath() + "/syntax/" + canonicalName + ".lua");
+    type->syntax = getSyntax(canonicalName);
+    type->tokenizer = getTokenizer(canonicalName);
     
     for (const std::string & extension : extensions) {
       m_knownExtensions.emplace(extension, type);
     }
   }
   
+  void FileTypeDatabase::registerTokenizer(const std::string& canonicalName, std::shared_ptr<const Tokenizer> tokenizer) {
+    m_tokenizers[canonicalName] = tokenizer;
+    
+    std::map<std::string, Script>::const_iterator cursor = m_syntaxes.find(canonicalName);
+    if (cursor == std::end(m_syntaxes)) {
+      return;
+    }
+    
+    const std::string& identifier = cursor->second.identifier();
+    if (m_unknownFileType.syntax.identifier() == identifier) {
+      m_unknownFileType.tokenizer = tokenizer;
+    }
+    
+    for (const std::unique_ptr<FileType>& type : m_knownTypes) {
+      if (type->syntax.identifier() == identifier) {
+        type->tokenizer = tokenizer;
+      }
+    }
+  }
+  
   const FileType* FileTypeDatabase::lookupByExtension(const std::string& extension) const {
     std::map<std::string, FileType*>::const_iterator cursor = m_knownExtensions.find(extension);
     if (cursor != std::end(m_knownExtensions)) {
@@ -29,4 +50,25 @@ namespace quip {
     
     return &m_unknownFileType;
   }
+  
+  Script FileTypeDatabase::getSyntax(const std::string& canonicalName) {
+    std::map<std::string, Script>::const_iterator cursor = m_syntaxes.find(canonicalName);
+    if (cursor != std::end(m_syntaxes)) {
+      return cursor->second;
+    }
+    
+    Script syntax = m_scriptHost.getSyntax(m_scriptHost.scriptRootPath() + "/syntax/" + canonicalName + ".lua");
+    m_syntaxes.emplace(canonicalName, syntax);
+    return syntax;
+  }
+  
+  std::shared_ptr<const Tokenizer> FileTypeDatabase::getTokenizer(const std::string& canonicalName) const {
+    // Syntaxes without a native tokenizer are parsed by their scripts.
+    std::map<std::string, std::shared_ptr<const Tokenizer>>::const_iterator cursor = m_tokenizers.find(canonicalName);
+    if (cursor != std::end(m_tokenizers)) {
+      return cursor->second;
+    }
+    
+    return nullptr;
+  }
 }
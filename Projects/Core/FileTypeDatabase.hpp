@@ -1,8 +1,10 @@
 #pragma once
 
 #include "Script.hpp"
+#include "Tokenizer.hpp"
 
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -12,6 +14,9 @@ namespace quip {
   struct FileType {
     std::string name;
     Script syntax;
+    
+    // A native tokenizer for the syntax, which is used instead of the script when there is one.
+    std::shared_ptr<const Tokenizer> tokenizer;
   };
   
   struct FileTypeDatabase {
@@ -19,6 +24,11 @@ namespace quip {
     
     void registerFileType(const std::string& displayName, const std::string& canonicalName, const std::vector<std::string>& extensions);
     
+    // Parse a syntax with a native tokenizer instead of its script, for the file types already
+    // registered with it as well as those registered later. The tokenizer must mark rows exactly
+    // as the script does. Registering a null tokenizer goes back to the script.
+    void registerTokenizer(const std::string& canonicalName, std::shared_ptr<const Tokenizer> tokenizer);
+    
     const FileType* lookupByExtension(const std::string& extension) const;
     
   private:
@@ -27,5 +37,12 @@ namespace quip {
     FileType m_unknownFileType;
     std::vector<std::unique_ptr<FileType>> m_knownTypes;
     std::map<std::string, FileType*> m_knownExtensions;
+    
+    // Several file types may share a syntax, whose grammar only needs to be built once.
+    std::map<std::string, Script> m_syntaxes;
+    std::map<std::string, std::shared_ptr<const Tokenizer>> m_tokenizers;
+    
+    Script getSyntax(const std::string& canonicalName);
+    std::shared_ptr<const Tokenizer> getTokenizer(const std::string& canonicalName) const;
   };
 }
@@ -0,0 +1,175 @@
+#include "IncrementalSearch.hpp"
+
+#include "Document.hpp"
+#include "LiteralSearchEngine.hpp"
+#include "SearchExpression.hpp"
+#include "Selection.hpp"
+#include "SubstringSearch.hpp"
+
+#include <cstring>
+
+namespace {
+  // Roughly how many bytes of text are searched between passing results to a visitor.
+  const std::size_t ReportInterval = 1024 * 1024;
+  
+  // Roughly how many bytes of results are remembered for earlier expressions.
+  const std::size_t HistoryCapacity = 32 * 1024 * 1024;
+}
+
+namespace quip {
+  IncrementalSearch::IncrementalSearch() {
+  }
+  
+  bool IncrementalSearch::update(const Document& document, const std::string& expression) {
+    return update(document, expression, [] (const std::vector<Selection>& found) {
+      return true;
+    });
+  }
+  
+  bool IncrementalSearch::update(const Document& document, const std::string& expression, const std::function<bool (const std::vector<Selection>&)>& visitor) {
+    // Only earlier expressions that the new expression extends are worth keeping.
+    while (!m_steps.empty() && expression.compare(0, m_steps.back().expression.size(), m_steps.back().expression) != 0) {
+      m_steps.pop_back();
+    }
+    
+    if (!m_steps.empty() && m_steps.back().expression == expression) {
+      const Step& step = m_steps.back();
+      return step.isValid && visitor(std::vector<Selection>(step.matches.begin(), step.matches.end()));
+    }
+    
+    Step step;
+    step.expression = expression;
+    step.isValid = expression.size() > 0;
+    step.isLiteral = step.isValid && LiteralSearchEngine::findLiteralPrefix(expression, step.literal) && step.literal.find('\n') == std::string::npos;
+    step.isRefinable = step.isLiteral;
+    std::vector<Selection> matches;
+    if (step.isLiteral) {
+      // Matches are the occurrences that don't overlap an earlier match. They're passed to the
+      // visitor whenever enough work has been done since the last time.
+      const std::size_t length = step.literal.size();
+      std::size_t reported = 0;
+      std::size_t work = 0;
+      auto addOccurrence = [&] (const Location& occurrence) {
+        step.occurrences.emplace_back(occurrence);
+        if (matches.empty() || matches.back().extent().row() != occurrence.row() || matches.back().extent().column() < occurrence.column()) {
+          matches.emplace_back(occurrence, Location(occurrence.column() + length - 1, occurrence.row()));
+        }
+      };
+      
+      auto report = [&] () {
+        work = 0;
+        std::vector<Selection> found(matches.begin() + reported, matches.end());
+        reported = matches.size();
+        return visitor(found);
+      };
+      
+      const Step* refinable = findRefinableStep(step.literal);
+      if (refinable != nullptr) {
+        for (const Location& occurrence : refinable->occurrences) {
+          std::size_t column = occurrence.column();
+          if (column + length <= document.rowLength(occurrence.row()) && std::memcmp(document.rowData(occurrence.row()) + column, step.literal.data(), length) == 0) {
+            addOccurrence(occurrence);
+          }
+          
+          work += length;
+          if (work >= ReportInterval && !report()) {
+            return false;
+          }
+        }
+      } else {
+        for (std::size_t row = 0; row < document.rows(); ++row) {
+          const char* data = document.rowData(row);
+          std::size_t size = document.rowLength(row);
+          std::size_t column = findSubstring(data, size, step.literal.data(), length);
+          while (column < size) {
+            addOccurrence(Location(column, row));
+            ++column;
+            column += findSubstring(data + column, size - column, step.literal.data(), length);
+          }
+          
+          work += size + 1;
+          if (work >= ReportInterval && !report()) {
+            return false;
+          }
+        }
+      }
+      
+      if (!report()) {
+        return false;
+      }
+    } else if (step.isValid) {
+      SearchExpression search(expression);
+      step.isValid = search.valid();
+      if (step.isValid) {
+        bool isComplete = document.matches(search, [&] (const std::vector<Selection>& found) {
+          matches.insert(matches.end(), found.begin(), found.end());
+          return visitor(found);
+        });
+        
+        if (!isComplete) {
+          return false;
+        }
+      }
+    }
+    
+    step.matches = SelectionSet(matches);
+    addStep(step);
+    return m_steps.back().isValid;
+  }
+  
+  void IncrementalSearch::clear() {
+    m_steps.clear();
+  }
+  
+  const SelectionSet& IncrementalSearch::matches() const {
+    if (m_steps.empty() || !m_steps.back().isValid) {
+      return m_empty;
+    }
+    
+    return m_steps.back().matches;
+  }
+  
+  const IncrementalSearch::Step* IncrementalSearch::findRefinableStep(const std::string& literal) const {
+    // Every occurrence of the new literal is also an occurrence of any literal it extends.
+    // Only the last literal step can have kept its occurrences. When characters are deleted,
+    // an earlier literal step can become the last one again, having already given them up.
+    for (auto step = m_steps.rbegin(); step != m_steps.rend(); ++step) {
+      if (step->isLiteral) {
+        return step->isRefinable && literal.compare(0, step->literal.size(), step->literal) == 0 ? &*step : nullptr;
+      }
+    }
+    
+    return nullptr;
+  }
+  
+  void IncrementalSearch::addStep(Step& step) {
+    // A new literal step can refine anything an earlier one could, since its literal extends
+    // theirs.
+    if (step.isLiteral) {
+      for (Step& earlier : m_steps) {
+        if (earlier.isRefinable) {
+          earlier.isRefinable = false;
+          std::vector<Location>().swap(earlier.occurrences);
+        }
+      }
+    }
+    
+    m_steps.emplace_back(std::move(step));
+    
+    std::size_t footprint = 0;
+    for (const Step& earlier : m_steps) {
+      footprint += earlier.footprint();
+    }
+    
+    std::size_t forgotten = 0;
+    while (forgotten + 1 < m_steps.size() && footprint > m_steps.back().footprint() + HistoryCapacity) {
+      footprint -= m_steps[forgotten++].footprint();
+    }
+    
+    m_steps.erase(m_steps.begin(), m_steps.begin() + forgotten);
+  }
+  
+  std::size_t IncrementalSearch::Step::footprint() const {
+    return occurrences.capacity() * sizeof(Location) + matches.count() * sizeof(Selection);
+  }
+}
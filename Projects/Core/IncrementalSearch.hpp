@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Location.hpp"
+#include "SelectionSet.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace quip {
+  struct Document;
+  struct Selection;
+  
+  // The results of a search that is refined as its expression is typed.
+  //
+  // Every expression searched for is remembered along with its results, so deleting characters
+  // restores the results of an earlier expression without searching again, until the results
+  // remembered grow too large and the oldest are forgotten. When an expression is literal text
+  // extending the last literal expression, only the places where that text occurred are
+  // checked, so refining a search costs time proportional to the number of results rather than
+  // the size of the document.
+  //
+  // Results are only valid as long as the document isn't modified.
+  struct IncrementalSearch {
+    IncrementalSearch();
+    
+    // Update the results for a new expression. Returns false if the expression isn't valid, in
+    // which case there are no results.
+    bool update(const Document& document, const std::string& expression);
+    
+    // Update the results for a new expression, passing them to a visitor a portion at a time,
+    // in order, as they're found. Returning false from the visitor abandons the update and
+    // records no results for the expression, in which case this returns false as well.
+    bool update(const Document& document, const std::string& expression, const std::function<bool (const std::vector<Selection>&)>& visitor);
+    void clear();
+    
+    const SelectionSet& matches() const;
+    
+  private:
+    struct Step {
+      std::string expression;
+      bool isValid;
+      
+      // The last literal expression also keeps every place its text occurs, including those
+      // that overlap other occurrences and so aren't matches, since they may start a match of a
+      // longer literal. Earlier literal expressions give theirs up.
+      bool isLiteral;
+      bool isRefinable;
+      std::string literal;
+      std::vector<Location> occurrences;
+      
+      SelectionSet matches;
+      
+      std::size_t footprint() const;
+    };
+    
+    std::vector<Step> m_steps;
+    SelectionSet m_empty;
+    
+    const Step* findRefinableStep(const std::string& literal) const;
+    void addStep(Step& step);
+  };
+}
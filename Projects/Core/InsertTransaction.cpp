@@ -2,6 +2,7 @@
 
 #include "Document.hpp"
 #include "EditContext.hpp"
+#include "UndoLog.hpp"
 
 namespace quip {
   InsertTransaction::InsertTransaction(const SelectionSet& selections, const std::vector<std::string>& text)
@@ -13,11 +14,9 @@ namespace quip {
   }
   
   void InsertTransaction::perform(EditContext& context) {
-    context.selections().replace(context.document().insert(m_selections, m_text));
-  }
-  
-  void InsertTransaction::rollback(EditContext& context) {
-    context.selections().replace(context.document().erase(m_selections));
+    Document& document = context.document();
+    context.undoLog().recordInsertion(document, m_selections, m_text);
+    context.selections().replace(document.insert(m_selections, m_text));
   }
   
   std::shared_ptr<Transaction> InsertTransaction::create(const SelectionSet& selections, const std::string& text) {
@@ -15,7 +15,6 @@ namespace quip {
     ~InsertTransaction ();
     
     void perform (EditContext & context) override;
-    void rollback (EditContext & context) override;
     
     static std::shared_ptr<Transaction> create (const SelectionSet & selections, const std::string & text);
     static std::shared_ptr<Transaction> create (const SelectionSet & selections, const std::vector<std::string> & text);
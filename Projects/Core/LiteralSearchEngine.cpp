@@ -0,0 +1,101 @@
+#include "LiteralSearchEngine.hpp"
+
+#include "SubstringSearch.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace quip {
+  LiteralSearchEngine::LiteralSearchEngine(const std::string& literal, bool ignoresCase)
+  : m_literal(literal)
+  , m_ignoresCase(ignoresCase) {
+  }
+  
+  bool LiteralSearchEngine::search(const char* text, std::size_t size, std::size_t start, bool, bool, State&, SearchMatch& match) const {
+    if (m_literal.empty() || start >= size) {
+      return false;
+    }
+    
+    std::size_t offset = findLiteral(text + start, size - start, m_literal, m_ignoresCase);
+    if (offset == size - start) {
+      return false;
+    }
+    
+    match.position = start + offset;
+    match.length = m_literal.size();
+    return true;
+  }
+  
+  std::size_t LiteralSearchEngine::maximumNewlines() const {
+    return std::count(m_literal.begin(), m_literal.end(), '\n');
+  }
+  
+  bool LiteralSearchEngine::findLiteralPrefix(const std::string& expression, std::string& prefix) {
+    prefix.clear();
+    
+    // An alternation outside of any group or class means matches needn't share a prefix.
+    std::size_t depth = 0;
+    bool isInClass = false;
+    for (std::size_t index = 0; index < expression.size(); ++index) {
+      char character = expression[index];
+      if (character == '\\') {
+        ++index;
+      } else if (isInClass) {
+        isInClass = character != ']';
+      } else if (character == '[') {
+        isInClass = true;
+      } else if (character == '(') {
+        ++depth;
+      } else if (character == ')' && depth > 0) {
+        --depth;
+      } else if (character == '|' && depth == 0) {
+        return false;
+      }
+    }
+    
+    std::size_t index = 0;
+    while (index < expression.size()) {
+      char character = expression[index];
+      std::size_t next = index + 1;
+      if (character == '\\') {
+        if (next == expression.size()) {
+          break;
+        }
+        
+        char escaped = expression[next++];
+        if (escaped == 'n') {
+          character = '\n';
+        } else if (escaped == 't') {
+          character = '\t';
+        } else if (escaped == 'r') {
+          character = '\r';
+        } else if (!std::isalnum(static_cast<unsigned char>(escaped))) {
+          character = escaped;
+        } else {
+          break;
+        }
+      } else if (std::strchr("^$.*+?()[]{}|", character) != nullptr) {
+        break;
+      }
+      
+      if (next < expression.size() && std::strchr("*+?{", expression[next]) != nullptr) {
+        // The character is optional or repeated, so it's not part of the prefix.
+        break;
+      }
+      
+      prefix.push_back(character);
+      index = next;
+    }
+    
+    return index == expression.size();
+  }
+  
+  std::size_t findLiteral(const char* text, std::size_t size, const std::string& literal, bool ignoresCase) {
+    if (ignoresCase) {
+      return findSubstringIgnoringCase(text, size, literal.data(), literal.size());
+    }
+    
+    return findSubstring(text, size, literal.data(), literal.size());
+  }
+}
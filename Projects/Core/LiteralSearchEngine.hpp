@@ -0,0 +1,31 @@
+#pragma once
+
+#include "SearchEngine.hpp"
+
+#include <memory>
+#include <string>
+
+namespace quip {
+  // A search engine for expressions that are entirely literal text, which are found with a
+  // vectorized substring search rather than by running a regular expression.
+  struct LiteralSearchEngine : SearchEngine {
+    LiteralSearchEngine(const std::string& literal, bool ignoresCase);
+    
+    using SearchEngine::search;
+    bool search(const char* text, std::size_t size, std::size_t start, bool isDocumentStart, bool isDocumentEnd, State& state, SearchMatch& match) const override;
+    std::size_t maximumNewlines() const override;
+    
+    // Find the literal text that every match of an expression must begin with, returning true
+    // if the whole expression is literal text. The prefix is empty if there isn't one, such as
+    // when the expression has an alternation at the top level.
+    static bool findLiteralPrefix(const std::string& expression, std::string& prefix);
+    
+  private:
+    std::string m_literal;
+    bool m_ignoresCase;
+  };
+  
+  // Find the first occurrence of a literal in a text, ignoring case if requested, returning the
+  // size of the text if there is none.
+  std::size_t findLiteral(const char* text, std::size_t size, const std::string& literal, bool ignoresCase);
+}
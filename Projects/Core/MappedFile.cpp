@@ -0,0 +1,68 @@
+#include "MappedFile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace quip {
+  MappedFile::MappedFile(void* data, std::size_t size)
+  : m_data(data)
+  , m_size(size) {
+  }
+  
+  MappedFile::~MappedFile() {
+    if (m_data != nullptr) {
+      munmap(m_data, m_size);
+    }
+  }
+  
+  const char* MappedFile::data() const {
+    return static_cast<const char*>(m_data);
+  }
+  
+  std::size_t MappedFile::size() const {
+    return m_size;
+  }
+  
+  void MappedFile::adviseSequential() const {
+    if (m_data != nullptr) {
+      madvise(m_data, m_size, MADV_SEQUENTIAL);
+    }
+  }
+  
+  void MappedFile::adviseRandom() const {
+    if (m_data != nullptr) {
+      madvise(m_data, m_size, MADV_RANDOM);
+      madvise(m_data, m_size, MADV_DONTNEED);
+    }
+  }
+  
+  std::shared_ptr<MappedFile> MappedFile::open(const std::string& path) {
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+      return nullptr;
+    }
+    
+    struct stat status;
+    if (fstat(descriptor, &status) != 0 || !S_ISREG(status.st_mode)) {
+      close(descriptor);
+      return nullptr;
+    }
+    
+    // Empty files can't be mapped, but are still perfectly valid to open.
+    std::size_t size = static_cast<std::size_t>(status.st_size);
+    void* data = nullptr;
+    if (size > 0) {
+      data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+      if (data == MAP_FAILED) {
+        close(descriptor);
+        return nullptr;
+      }
+    }
+    
+    // The mapping remains valid after the descriptor is closed.
+    close(descriptor);
+    return std::shared_ptr<MappedFile>(new MappedFile(data, size));
+  }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace quip {
+  // A read-only memory mapping of a file.
+  //
+  // The mapping is private, so edits made through a document never reach the file. The
+  // file must not be truncated by another process while mapped; saving through a temporary
+  // file and renaming it over the original (as NSDocument does) is safe, since the mapping
+  // keeps referring to the original file.
+  struct MappedFile {
+    ~MappedFile();
+    
+    MappedFile(const MappedFile& other) = delete;
+    MappedFile& operator=(const MappedFile& other) = delete;
+    
+    const char* data() const;
+    std::size_t size() const;
+    
+    // Hint that the mapping is about to be read front to back, once.
+    void adviseSequential() const;
+    
+    // Hint that the mapping will be read in no particular order, and let the system
+    // drop any pages already read so that they stop counting against resident memory.
+    // Dropped pages are read back in from the file on demand.
+    void adviseRandom() const;
+    
+    static std::shared_ptr<MappedFile> open(const std::string& path);
+    
+  private:
+    MappedFile(void* data, std::size_t size);
+    
+    void* m_data;
+    std::size_t m_size;
+  };
+}
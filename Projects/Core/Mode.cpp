@@ -84,6 +84,14 @@ namespace quip {
     onExit(context);
   }
   
+  bool Mode::tick(EditContext& context) {
+    return onTick(context);
+  }
+  
+  bool Mode::defersKeys() const {
+    return false;
+  }
+  
   bool Mode::allowsRepeats() const {
     return true;
   }
@@ -98,6 +106,10 @@ namespace quip {
   void Mode::onExit(EditContext& context) {
   }
   
+  bool Mode::onTick(EditContext& context) {
+    return false;
+  }
+  
   bool Mode::onUnmappedKey (Key key, const std::string& text, EditContext& context) {
     context.popupService().createPopupAtLocation(context.selections().primary().origin(), "No mapping.");
     return false;
@@ -29,6 +29,15 @@ namespace quip {
     void enter(EditContext& context, std::uint64_t how);
     void exit(EditContext& context);
     
+    // Perform periodic work, such as collecting the results of background tasks. Returns true
+    // if anything visible changed.
+    bool tick(EditContext& context);
+    
+    // Whether keys should be held back while the mode finishes background work. The context
+    // queues them and processes them once the mode stops deferring, by which time a different
+    // mode may be current.
+    virtual bool defersKeys() const;
+    
   protected:
     template<typename ModeType>
     void addMapping(KeySequence sequence, void (ModeType::*callback)(EditContext&)) {
@@ -41,6 +50,7 @@ namespace quip {
     
     virtual void onEnter(EditContext& context, std::uint64_t how);
     virtual void onExit(EditContext& context);
+    virtual bool onTick(EditContext& context);
     
     virtual bool onUnmappedKey(Key key, const std::string& text, EditContext& context);
     
@@ -0,0 +1,98 @@
+#include "NewlineScanner.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define QUIP_NEWLINE_SCANNER_X86 1
+#endif
+
+namespace quip {
+  namespace {
+    void scanScalar(const char* data, std::size_t size, std::size_t base, std::vector<std::size_t>& offsets) {
+      const char* cursor = data;
+      const char* end = data + size;
+      while (cursor < end) {
+        const void* newline = std::memchr(cursor, '\n', end - cursor);
+        if (newline == nullptr) {
+          break;
+        }
+        
+        cursor = static_cast<const char*>(newline);
+        offsets.push_back(base + (cursor - data));
+        ++cursor;
+      }
+    }
+
+#if defined(QUIP_NEWLINE_SCANNER_X86)
+    // Each block comparison produces a bit mask with one bit per byte; the set bits are the
+    // newlines, and are visited lowest first so offsets stay in order.
+    void appendMask(std::uint32_t mask, std::size_t base, std::vector<std::size_t>& offsets) {
+      while (mask != 0) {
+        offsets.push_back(base + __builtin_ctz(mask));
+        mask &= mask - 1;
+      }
+    }
+    
+    __attribute__((target("sse2")))
+    void scanSSE2(const char* data, std::size_t size, std::size_t base, std::vector<std::size_t>& offsets) {
+      const __m128i newline = _mm_set1_epi8('\n');
+      std::size_t index = 0;
+      for (; index + 16 <= size; index += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index));
+        appendMask(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)), base + index, offsets);
+      }
+      
+      scanScalar(data + index, size - index, base + index, offsets);
+    }
+    
+    __attribute__((target("avx2")))
+    void scanAVX2(const char* data, std::size_t size, std::size_t base, std::vector<std::size_t>& offsets) {
+      const __m256i newline = _mm256_set1_epi8('\n');
+      std::size_t index = 0;
+      for (; index + 64 <= size; index += 64) {
+        // Two blocks per iteration keeps both load ports busy.
+        __m256i lower = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index));
+        __m256i upper = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index + 32));
+        std::uint32_t lowerMask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(lower, newline));
+        std::uint32_t upperMask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(upper, newline));
+        if ((lowerMask | upperMask) != 0) {
+          appendMask(lowerMask, base + index, offsets);
+          appendMask(upperMask, base + index + 32, offsets);
+        }
+      }
+      
+      scanSSE2(data + index, size - index, base + index, offsets);
+    }
+    
+    typedef void (*ScanFunction)(const char*, std::size_t, std::size_t, std::vector<std::size_t>&);
+    
+    ScanFunction selectScanFunction() {
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2")) {
+        return &scanAVX2;
+      }
+      
+      if (__builtin_cpu_supports("sse2")) {
+        return &scanSSE2;
+      }
+      
+      return &scanScalar;
+    }
+#endif
+  }
+  
+  void findNewlines(const char* data, std::size_t size, std::vector<std::size_t>& offsets) {
+#if defined(QUIP_NEWLINE_SCANNER_X86)
+    static const ScanFunction scan = selectScanFunction();
+    scan(data, size, 0, offsets);
+#else
+    findNewlinesScalar(data, size, offsets);
+#endif
+  }
+  
+  void findNewlinesScalar(const char* data, std::size_t size, std::vector<std::size_t>& offsets) {
+    scanScalar(data, size, 0, offsets);
+  }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace quip {
+  // Append the offset of every newline character in a buffer to a list of offsets.
+  //
+  // The buffer is scanned in a single pass using the widest vector instructions the processor
+  // supports (AVX2 or SSE2 on x86), falling back to a portable scalar scan elsewhere.
+  void findNewlines(const char* data, std::size_t size, std::vector<std::size_t>& offsets);
+  
+  // Append the offset of every newline character in a buffer to a list of offsets, using
+  // only the portable scalar scan.
+  void findNewlinesScalar(const char* data, std::size_t size, std::vector<std::size_t>& offsets);
+}
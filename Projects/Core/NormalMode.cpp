@@ -5,6 +5,7 @@
 #include "EditContext.hpp"
 #include "EditMode.hpp"
 #include "EraseTransaction.hpp"
+#include "InsertTransaction.hpp"
 #include "Location.hpp"
 #include "Selection.hpp"
 #include "SelectionSet.hpp"
@@ -95,8 +96,8 @@ namespace quip {
     column = std::max(column, m_virtualColumn);
     
     std::uint64_t row = location.row() + 1;
-    if (column >= context.document().row(row).length()) {
-      column = context.document().row(row).length() - 1;
+    if (column >= context.document().rowLength(row)) {
+      column = context.document().rowLength(row) - 1;
     }
     
     Location target(column, row);
@@ -112,7 +113,7 @@ namespace quip {
     }
     
     Location location = context.selections().primary().extent();
-    if (location.column() + 1 == context.document().row(location.row()).size()) {
+    if (location.column() + 1 == context.document().rowLength(location.row())) {
       return;
     }
     
@@ -139,8 +140,8 @@ namespace quip {
     column = std::max(column, m_virtualColumn);
     
     std::uint64_t row = location.row() - 1;
-    if (column >= context.document().row(row).length()) {
-      column = context.document().row(row).length() - 1;
+    if (column >= context.document().rowLength(row)) {
+      column = context.document().rowLength(row) - 1;
     }
     
     Location target(column, row);
@@ -182,8 +183,8 @@ namespace quip {
       }
       
       Location target = selection.extent().adjustBy(0, 1);
-      if (target.column() > document.row(target.row()).size()) {
-        target = Location(document.row(target.row()).size() - 1, target.row());
+      if (target.column() > document.rowLength(target.row())) {
+        target = Location(document.rowLength(target.row()) - 1, target.row());
       }
 
       results.emplace_back(selection.origin(), target);
@@ -204,8 +205,8 @@ namespace quip {
       }
       
       Location target = selection.extent().adjustBy(0, -1);
-      if (target.column() > document.row(target.row()).size()) {
-        target = Location(document.row(target.row()).size() - 1, target.row());
+      if (target.column() > document.rowLength(target.row())) {
+        target = Location(document.rowLength(target.row()) - 1, target.row());
       }
       
       if (target < selection.origin()) {
@@ -264,8 +265,8 @@ namespace quip {
         results.emplace_back(selection);
       } else {
         Location target = selection.origin().adjustBy(0, 1);
-        if (target.column() > document.row(target.row()).size()) {
-          target = Location(document.row(target.row()).size() - 1, target.row());
+        if (target.column() > document.rowLength(target.row())) {
+          target = Location(document.rowLength(target.row()) - 1, target.row());
         }
         
         results.emplace_back(target, selection.extent());
@@ -286,8 +287,8 @@ namespace quip {
         results.emplace_back(selection);
       } else {
         Location target = selection.origin().adjustBy(0, -1);
-        if (target.column() > document.row(target.row()).size()) {
-          target = Location(document.row(target.row()).size() - 1, target.row());
+        if (target.column() > document.rowLength(target.row())) {
+          target = Location(document.rowLength(target.row()) - 1, target.row());
         }
         
         if (target > selection.extent()) {
@@ -322,28 +323,33 @@ namespace quip {
   }
   
   void NormalMode::doIncreaseSelectionIndentLevel(EditContext& context) {
-    Document& document = context.document();
-    SelectionSet& selections = context.selections();
+    SelectionSet selections = context.selections();
     std::vector<Selection> results;
     results.reserve(selections.count());
+    
+    // The indentation of every row is shifted as one step of history.
+    context.beginBatch();
     for (const Selection& selection : selections) {
       Location target(0, selection.origin().row());
-      document.insert(Selection(target), "  ");
+      context.performTransaction(InsertTransaction::create(SelectionSet(Selection(target)), "  "));
       
       results.emplace_back(selection.origin().adjustBy(2, 0), selection.extent().adjustBy(2, 0));
     }
     
-    selections.replace(SelectionSet(results));
+    context.selections().replace(SelectionSet(results));
+    context.endBatch();
   }
   
   void NormalMode::doDecreaseSelectionIndentLevel(EditContext& context) {
     Document& document = context.document();
-    SelectionSet& selections = context.selections();
+    SelectionSet selections = context.selections();
     std::vector<Selection> results;
     results.reserve(selections.count());
+    
+    context.beginBatch();
     for (const Selection& selection : selections) {
       std::uint64_t row = selection.origin().row();
-      const std::string& text = document.row(row);
+      std::string text = document.row(row);
       
       std::uint64_t size = 0;
       if (!std::isspace(text[size])) {
@@ -357,12 +363,13 @@ namespace quip {
       
       Location start(0, row);
       Location end(size, row);
-      document.erase(Selection(start, end));
+      context.performTransaction(EraseTransaction::create(SelectionSet(Selection(start, end))));
       
       results.emplace_back(selection.origin().adjustBy(-size - 1, 0), selection.extent().adjustBy(-size - 1, 0));
     }
     
-    selections.replace(SelectionSet(results));
+    context.selections().replace(SelectionSet(results));
+    context.endBatch();
   }
   
   void NormalMode::doSelectWord(EditContext& context) {
@@ -475,7 +482,7 @@ namespace quip {
     std::vector<Selection> adjusted;
     adjusted.reserve(context.selections().count());
     for (const Selection& selection : context.selections()) {
-      Location location(context.document().row(selection.extent().row()).size() - 2, selection.extent().row());
+      Location location(context.document().rowLength(selection.extent().row()) - 2, selection.extent().row());
       adjusted.emplace_back(location);
     }
     
@@ -488,7 +495,9 @@ namespace quip {
   }
   
   void NormalMode::changeSelections(EditContext& context) {
+    context.beginBatch();
     context.performTransaction(EraseTransaction::create(context.selections()));
     context.enterMode("EditMode");
+    context.endBatch();
   }
 }
@@ -0,0 +1,426 @@
+#include "PieceTable.hpp"
+
+#include "MappedFile.hpp"
+#include "NewlineScanner.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace quip {
+  constexpr std::size_t PieceTable::ChunkCapacity;
+  constexpr std::size_t PieceTable::BlockCapacity;
+  constexpr std::size_t PieceTable::ScanWindow;
+  
+  PieceTable::PieceTable()
+  : m_state(std::make_shared<State>())
+  , m_blockRemaining(0) {
+  }
+  
+  PieceTable::PieceTable(const std::string& text)
+  : PieceTable(std::string(text)) {
+  }
+  
+  PieceTable::PieceTable(std::string&& text)
+  : m_state(std::make_shared<State>())
+  , m_blockRemaining(0) {
+    std::shared_ptr<std::string> original = std::make_shared<std::string>(std::move(text));
+    m_state->original = original;
+    load(original->data(), original->size());
+  }
+  
+  PieceTable::PieceTable(std::shared_ptr<const MappedFile> file)
+  : m_state(std::make_shared<State>())
+  , m_blockRemaining(0) {
+    m_state->original = file;
+    file->adviseSequential();
+    load(file->data(), file->size());
+    file->adviseRandom();
+  }
+  
+  PieceTable::PieceTable(const PieceTable& other)
+  : m_state(other.m_state)
+  , m_blockRemaining(0) {
+    // The unused space at the end of the current block still belongs to the other table, so
+    // this one starts a new block the next time it writes.
+  }
+  
+  PieceTable& PieceTable::operator=(const PieceTable& other) {
+    m_state = other.m_state;
+    m_blockRemaining = 0;
+    return *this;
+  }
+  
+  std::size_t PieceTable::rows() const {
+    return m_state->rows;
+  }
+  
+  std::size_t PieceTable::length() const {
+    return m_state->length;
+  }
+  
+  const char* PieceTable::rowData(std::size_t index) const {
+    return piece(index).data;
+  }
+  
+  std::size_t PieceTable::rowLength(std::size_t index) const {
+    return piece(index).length;
+  }
+  
+  std::string PieceTable::row(std::size_t index) const {
+    const Piece& result = piece(index);
+    return std::string(result.data, result.length);
+  }
+  
+  void PieceTable::replace(std::size_t index, std::size_t count, const std::vector<std::string>& rows) {
+    detachState();
+    if (m_state->chunks.empty()) {
+      m_state->chunks.emplace_back(std::make_shared<Chunk>());
+      m_state->chunkStarts.emplace_back(0);
+    }
+    
+    std::size_t first = findChunk(index);
+    std::size_t offset = index - m_state->chunkStarts[first];
+    
+    // Remove the replaced pieces, which may span several chunks.
+    std::size_t chunk = first;
+    std::size_t position = offset;
+    std::size_t remaining = count;
+    while (remaining > 0 && chunk < m_state->chunks.size()) {
+      Chunk& pieces = mutableChunk(chunk);
+      std::size_t removed = std::min(remaining, pieces.pieces.size() - position);
+      for (std::size_t cursor = position; cursor < position + removed; ++cursor) {
+        m_state->length -= pieces.pieces[cursor].length;
+        pieces.length -= pieces.pieces[cursor].length;
+      }
+      
+      pieces.pieces.erase(pieces.pieces.begin() + position, pieces.pieces.begin() + position + removed);
+      remaining -= removed;
+      m_state->rows -= removed;
+      
+      ++chunk;
+      position = 0;
+    }
+    
+    // Write the replacement rows to the add buffer and splice their pieces in.
+    std::vector<Piece> inserted;
+    inserted.reserve(rows.size());
+    for (const std::string& text : rows) {
+      inserted.emplace_back(write(text));
+      m_state->length += text.size();
+    }
+    
+    Chunk& target = mutableChunk(first);
+    target.pieces.insert(target.pieces.begin() + offset, inserted.begin(), inserted.end());
+    for (const Piece& piece : inserted) {
+      target.length += piece.length;
+    }
+    
+    m_state->rows += inserted.size();
+    
+    // Keep chunks bounded in size: oversized chunks are split in half and emptied
+    // chunks are discarded.
+    if (target.pieces.size() > ChunkCapacity) {
+      std::vector<std::shared_ptr<Chunk>> split;
+      for (std::size_t start = 0; start < target.pieces.size(); start += ChunkCapacity / 2) {
+        std::size_t end = std::min(start + ChunkCapacity / 2, target.pieces.size());
+        std::shared_ptr<Chunk> half = std::make_shared<Chunk>();
+        half->pieces.assign(target.pieces.begin() + start, target.pieces.begin() + end);
+        half->length = 0;
+        for (const Piece& piece : half->pieces) {
+          half->length += piece.length;
+        }
+        
+        split.emplace_back(half);
+      }
+      
+      m_state->chunks.erase(m_state->chunks.begin() + first);
+      m_state->chunks.insert(m_state->chunks.begin() + first, split.begin(), split.end());
+    }
+    
+    std::vector<std::shared_ptr<Chunk>>::iterator emptied = std::remove_if(m_state->chunks.begin() + first, m_state->chunks.end(), [] (const std::shared_ptr<Chunk>& pieces) {
+      return pieces->pieces.empty();
+    });
+    
+    m_state->chunks.erase(emptied, m_state->chunks.end());
+    reindex(first);
+  }
+  
+  PieceTable::Builder::Builder(PieceTable& table)
+  : m_table(table)
+  , m_isLastChunkShared(false)
+  , m_rows(0)
+  , m_length(0) {
+  }
+  
+  std::size_t PieceTable::Builder::rows() const {
+    return m_rows;
+  }
+  
+  void PieceTable::Builder::copyRows(std::size_t index, std::size_t count) {
+    if (count == 0) {
+      return;
+    }
+    
+    std::size_t chunk = m_table.findChunk(index);
+    std::size_t offset = index - m_table.m_state->chunkStarts[chunk];
+    while (count > 0) {
+      const std::shared_ptr<Chunk>& pieces = m_table.m_state->chunks[chunk];
+      std::size_t copied = std::min(count, pieces->pieces.size() - offset);
+      if (copied == pieces->pieces.size()) {
+        share(pieces);
+      } else {
+        append(pieces->pieces.data() + offset, copied);
+      }
+      
+      count -= copied;
+      offset = 0;
+      ++chunk;
+    }
+  }
+  
+  void PieceTable::Builder::appendRow(const std::string& text) {
+    Piece piece = m_table.write(text);
+    append(&piece, 1);
+  }
+  
+  void PieceTable::Builder::commit() {
+    m_table.detachState();
+    m_table.m_state->chunks = std::move(m_chunks);
+    m_table.m_state->rows = m_rows;
+    m_table.m_state->length = m_length;
+    m_table.reindex(0);
+    
+    m_chunks.clear();
+    m_isLastChunkShared = false;
+    m_rows = 0;
+    m_length = 0;
+  }
+  
+  void PieceTable::Builder::append(const Piece* pieces, std::size_t count) {
+    m_rows += count;
+    while (count > 0) {
+      if (m_chunks.empty() || m_isLastChunkShared || m_chunks.back()->pieces.size() == ChunkCapacity) {
+        m_chunks.emplace_back(std::make_shared<Chunk>());
+        m_chunks.back()->pieces.reserve(ChunkCapacity);
+        m_chunks.back()->length = 0;
+        m_isLastChunkShared = false;
+      }
+      
+      Chunk& target = *m_chunks.back();
+      std::size_t appended = std::min(count, ChunkCapacity - target.pieces.size());
+      target.pieces.insert(target.pieces.end(), pieces, pieces + appended);
+      for (std::size_t index = 0; index < appended; ++index) {
+        target.length += pieces[index].length;
+        m_length += pieces[index].length;
+      }
+      
+      pieces += appended;
+      count -= appended;
+    }
+  }
+  
+  void PieceTable::Builder::share(const std::shared_ptr<Chunk>& chunk) {
+    // A whole chunk is shared with the table rather than copied, unless it fits in the
+    // partially filled chunk before it; merging keeps edits from leaving a trail of small
+    // chunks behind.
+    if (!m_chunks.empty() && !m_isLastChunkShared && m_chunks.back()->pieces.size() + chunk->pieces.size() <= ChunkCapacity) {
+      append(chunk->pieces.data(), chunk->pieces.size());
+      return;
+    }
+    
+    m_chunks.emplace_back(chunk);
+    m_isLastChunkShared = true;
+    m_rows += chunk->pieces.size();
+    m_length += chunk->length;
+  }
+  
+  void PieceTable::clear() {
+    detachState();
+    m_state->chunks.clear();
+    m_state->chunkStarts.clear();
+    m_state->rows = 0;
+    m_state->length = 0;
+  }
+  
+  std::size_t PieceTable::commonPrefix(const PieceTable& other) const {
+    // Chunks the tables share are skipped whole; only the first chunk that differs is
+    // compared row by row.
+    std::size_t rows = std::min(m_state->rows, other.m_state->rows);
+    std::size_t prefix = 0;
+    for (std::size_t chunk = 0; chunk < m_state->chunks.size() && chunk < other.m_state->chunks.size() && m_state->chunks[chunk] == other.m_state->chunks[chunk]; ++chunk) {
+      prefix += m_state->chunks[chunk]->pieces.size();
+    }
+    
+    while (prefix < rows && isSamePiece(piece(prefix), other.piece(prefix))) {
+      ++prefix;
+    }
+    
+    return prefix;
+  }
+  
+  std::size_t PieceTable::commonSuffix(const PieceTable& other, std::size_t limit) const {
+    limit = std::min(limit, std::min(m_state->rows, other.m_state->rows));
+    
+    std::size_t suffix = 0;
+    for (std::size_t count = 1; count <= m_state->chunks.size() && count <= other.m_state->chunks.size(); ++count) {
+      const std::shared_ptr<Chunk>& chunk = m_state->chunks[m_state->chunks.size() - count];
+      if (chunk != other.m_state->chunks[other.m_state->chunks.size() - count] || suffix + chunk->pieces.size() > limit) {
+        break;
+      }
+      
+      suffix += chunk->pieces.size();
+    }
+    
+    while (suffix < limit && isSamePiece(piece(m_state->rows - suffix - 1), other.piece(other.m_state->rows - suffix - 1))) {
+      ++suffix;
+    }
+    
+    return suffix;
+  }
+  
+  std::size_t PieceTable::unsharedFootprint(const PieceTable& other) const {
+    std::size_t result = sizeof(State);
+    result += m_state->blocks.capacity() * sizeof(std::shared_ptr<char>);
+    result += m_state->chunks.capacity() * sizeof(std::shared_ptr<Chunk>);
+    result += m_state->chunkStarts.capacity() * sizeof(std::size_t);
+    
+    std::vector<const Chunk*> shared;
+    shared.reserve(other.m_state->chunks.size());
+    for (const std::shared_ptr<Chunk>& chunk : other.m_state->chunks) {
+      shared.push_back(chunk.get());
+    }
+    
+    std::sort(shared.begin(), shared.end());
+    for (const std::shared_ptr<Chunk>& chunk : m_state->chunks) {
+      if (!std::binary_search(shared.begin(), shared.end(), chunk.get())) {
+        result += sizeof(Chunk) + chunk->pieces.capacity() * sizeof(Piece);
+      }
+    }
+    
+    return result;
+  }
+  
+  void PieceTable::load(const char* data, std::size_t size) {
+    Chunk pieces;
+    pieces.pieces.reserve(ChunkCapacity);
+    pieces.length = 0;
+    
+    // The text is scanned in windows so that the list of newline offsets stays small
+    // regardless of the size of the text.
+    std::vector<std::size_t> newlines;
+    std::size_t start = 0;
+    for (std::size_t window = 0; window < size; window += ScanWindow) {
+      newlines.clear();
+      findNewlines(data + window, std::min(ScanWindow, size - window), newlines);
+      
+      for (std::size_t newline : newlines) {
+        std::size_t end = window + newline + 1;
+        pieces.pieces.push_back(Piece { data + start, end - start });
+        pieces.length += end - start;
+        if (pieces.pieces.size() == ChunkCapacity) {
+          m_state->chunks.emplace_back(std::make_shared<Chunk>(std::move(pieces)));
+          pieces = Chunk();
+          pieces.pieces.reserve(ChunkCapacity);
+          pieces.length = 0;
+        }
+        
+        start = end;
+      }
+    }
+    
+    if (start < size) {
+      pieces.pieces.push_back(Piece { data + start, size - start });
+      pieces.length += size - start;
+    }
+    
+    if (!pieces.pieces.empty()) {
+      m_state->chunks.emplace_back(std::make_shared<Chunk>(std::move(pieces)));
+    }
+    
+    m_state->rows = m_state->chunks.empty() ? 0 : (m_state->chunks.size() - 1) * ChunkCapacity + m_state->chunks.back()->pieces.size();
+    m_state->length = size;
+    reindex(0);
+  }
+  
+  PieceTable::Piece PieceTable::write(const std::string& text) {
+    if (text.empty()) {
+      return Piece { "", 0 };
+    }
+    
+    detachState();
+    
+    char* destination = nullptr;
+    if (text.size() > BlockCapacity) {
+      // Oversized text gets a block of its own, leaving the current block available
+      // for subsequent writes.
+      m_state->blocks.emplace(m_state->blocks.begin(), new char[text.size()], std::default_delete<char[]>());
+      destination = m_state->blocks.front().get();
+    } else {
+      if (text.size() > m_blockRemaining) {
+        m_state->blocks.emplace_back(new char[BlockCapacity], std::default_delete<char[]>());
+        m_blockRemaining = BlockCapacity;
+      }
+      
+      destination = m_state->blocks.back().get() + (BlockCapacity - m_blockRemaining);
+      m_blockRemaining -= text.size();
+    }
+    
+    std::memcpy(destination, text.data(), text.size());
+    return Piece { destination, text.size() };
+  }
+  
+  const PieceTable::Piece& PieceTable::piece(std::size_t index) const {
+    std::size_t chunk = findChunk(index);
+    return m_state->chunks[chunk]->pieces[index - m_state->chunkStarts[chunk]];
+  }
+  
+  bool PieceTable::isSamePiece(const Piece& left, const Piece& right) {
+    return left.length == right.length && (left.data == right.data || std::memcmp(left.data, right.data, left.length) == 0);
+  }
+  
+  void PieceTable::detachState() {
+    // A state shared with a copy of the table is duplicated, sharing its chunks and blocks,
+    // before it's modified. A copy on another thread may have just been released, in which
+    // case the fence orders that thread's reads of the state before the writes to come.
+    if (m_state.use_count() > 1) {
+      m_state = std::make_shared<State>(*m_state);
+    } else {
+      std::atomic_thread_fence(std::memory_order_acquire);
+    }
+  }
+  
+  PieceTable::Chunk& PieceTable::mutableChunk(std::size_t index) {
+    // A chunk shared with a copy of the table is duplicated before it's modified.
+    if (m_state->chunks[index].use_count() > 1) {
+      m_state->chunks[index] = std::make_shared<Chunk>(*m_state->chunks[index]);
+    } else {
+      std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    
+    return *m_state->chunks[index];
+  }
+  
+  std::size_t PieceTable::findChunk(std::size_t index) const {
+    // The chunk index is sorted by starting row; the containing chunk is the last one
+    // that starts at or before the requested row.
+    std::vector<std::size_t>::const_iterator cursor = std::upper_bound(m_state->chunkStarts.begin(), m_state->chunkStarts.end(), index);
+    return cursor == m_state->chunkStarts.begin() ? 0 : (cursor - m_state->chunkStarts.begin()) - 1;
+  }
+  
+  void PieceTable::reindex(std::size_t firstChunk) {
+    m_state->chunkStarts.resize(m_state->chunks.size());
+    
+    std::size_t start = 0;
+    if (firstChunk > 0 && firstChunk <= m_state->chunks.size()) {
+      start = m_state->chunkStarts[firstChunk - 1] + m_state->chunks[firstChunk - 1]->pieces.size();
+    } else {
+      firstChunk = 0;
+    }
+    
+    for (std::size_t chunk = firstChunk; chunk < m_state->chunks.size(); ++chunk) {
+      m_state->chunkStarts[chunk] = start;
+      start += m_state->chunks[chunk]->pieces.size();
+    }
+  }
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace quip {
+  struct MappedFile;
+  
+  // Backing storage for the text of a document.
+  //
+  // A piece table never modifies text in place. The text the table was created from lives
+  // in the original buffer, and any text written afterwards is appended to the add buffer.
+  // Each row of the document is a piece: a span of characters in one of those two buffers.
+  // Editing a row appends its new text to the add buffer and replaces the row's piece,
+  // so untouched rows are never copied.
+  //
+  // The original buffer may be a memory-mapped file, in which case rows that have not been
+  // edited are read straight from the mapping.
+  //
+  // Pieces are grouped into chunks of bounded size so that inserting or removing rows only
+  // shifts the pieces of the affected chunk, instead of every subsequent row.
+  //
+  // Copying a table takes constant time: the copy shares the table's state, including its
+  // chunks and buffers, and the state is only duplicated when one of the tables sharing it is
+  // edited, and a chunk only when it is itself edited. Since neither buffer is ever modified
+  // in place, a copy can be read on another thread while the original continues to be edited.
+  // Edits rebuild only the chunks they touch, so successive versions of a table share most of
+  // their chunks, and comparing two versions only has to look inside the chunks that differ.
+  struct PieceTable {
+    PieceTable();
+    explicit PieceTable(const std::string& text);
+    explicit PieceTable(std::string&& text);
+    explicit PieceTable(std::shared_ptr<const MappedFile> file);
+    
+    PieceTable(const PieceTable& other);
+    PieceTable& operator=(const PieceTable& other);
+    
+    std::size_t rows() const;
+    std::size_t length() const;
+    
+    const char* rowData(std::size_t index) const;
+    std::size_t rowLength(std::size_t index) const;
+    std::string row(std::size_t index) const;
+    
+    // Replace the given number of rows, starting at the specified row, with new rows.
+    void replace(std::size_t index, std::size_t count, const std::vector<std::string>& rows);
+    void clear();
+    
+    // The number of leading rows, and of trailing rows up to the given limit, that have the
+    // same text in this table as in another one.
+    std::size_t commonPrefix(const PieceTable& other) const;
+    std::size_t commonSuffix(const PieceTable& other, std::size_t limit) const;
+    
+    // Roughly how many bytes of memory the table uses that another table doesn't share with it:
+    // the table's own index of chunks, and the chunks the other table doesn't also have. The
+    // text isn't counted, since the buffers holding it are shared by every copy of a table.
+    std::size_t unsharedFootprint(const PieceTable& other) const;
+    
+  private:
+    struct Piece {
+      const char* data;
+      std::size_t length;
+    };
+    
+    struct Chunk {
+      std::vector<Piece> pieces;
+      std::size_t length;
+    };
+    
+  public:
+    // Assembles a new sequence of rows for a table in a single pass, taking each row either
+    // from the table's existing rows (without copying their text) or from new text. The table
+    // is unchanged until the result is committed.
+    struct Builder {
+      explicit Builder(PieceTable& table);
+      
+      // The number of rows assembled so far.
+      std::size_t rows() const;
+      
+      void copyRows(std::size_t index, std::size_t count);
+      void appendRow(const std::string& text);
+      
+      void commit();
+      
+    private:
+      PieceTable& m_table;
+      std::vector<std::shared_ptr<Chunk>> m_chunks;
+      bool m_isLastChunkShared;
+      std::size_t m_rows;
+      std::size_t m_length;
+      
+      void append(const Piece* pieces, std::size_t count);
+      void share(const std::shared_ptr<Chunk>& chunk);
+    };
+    
+  private:
+    static constexpr std::size_t ChunkCapacity = 1024;
+    static constexpr std::size_t BlockCapacity = 64 * 1024;
+    static constexpr std::size_t ScanWindow = 1024 * 1024;
+    
+    struct State {
+      std::shared_ptr<const void> original;
+      std::vector<std::shared_ptr<char>> blocks;
+      
+      std::vector<std::shared_ptr<Chunk>> chunks;
+      std::vector<std::size_t> chunkStarts;
+      std::size_t rows;
+      std::size_t length;
+    };
+    
+    std::shared_ptr<State> m_state;
+    
+    // The space left in the last block, which only this table may write to.
+    std::size_t m_blockRemaining;
+    
+    void load(const char* data, std::size_t size);
+    Piece write(const std::string& text);
+    
+    const Piece& piece(std::size_t index) const;
+    static bool isSamePiece(const Piece& left, const Piece& right);
+    void detachState();
+    Chunk& mutableChunk(std::size_t index);
+    std::size_t findChunk(std::size_t index) const;
+    void reindex(std::size_t firstChunk);
+  };
+}
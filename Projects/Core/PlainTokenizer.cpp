@@ -0,0 +1,7 @@
+#include "PlainTokenizer.hpp"
+
+namespace quip {
+  std::string PlainTokenizer::tokenize(const char*, std::size_t, const std::string&, std::vector<AttributeRange>&) const {
+    return std::string();
+  }
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "Tokenizer.hpp"
+
+namespace quip {
+  // A tokenizer for file types without any syntax, such as plain text, which highlights nothing.
+  struct PlainTokenizer : Tokenizer {
+    std::string tokenize(const char* text, std::size_t length, const std::string& state, std::vector<AttributeRange>& attributes) const override;
+  };
+}
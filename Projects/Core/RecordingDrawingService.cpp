@@ -0,0 +1,68 @@
+#include "RecordingDrawingService.hpp"
+
+namespace quip {
+  RecordingDrawingService::RecordingDrawingService(Extent cellSize) {
+    setCellSize(cellSize);
+  }
+  
+  const std::vector<RecordingDrawingService::Command>& RecordingDrawingService::commands() const {
+    return m_commands;
+  }
+  
+  std::string RecordingDrawingService::text(const Command& command) const {
+    return m_text.substr(command.textOffset, command.textLength);
+  }
+  
+  void RecordingDrawingService::clear() {
+    m_commands.clear();
+    m_text.clear();
+  }
+  
+  void RecordingDrawingService::fillRectangle(const Rectangle& rectangle, const Color& color) {
+    record(CommandType::FillRectangle, color).rectangle = rectangle;
+  }
+  
+  void RecordingDrawingService::drawUnderline(std::size_t row, std::size_t firstColumn, std::size_t lastColumn, const Color& color, const Rectangle& frame) {
+    Command& command = record(CommandType::DrawUnderline, color);
+    command.location = Location(firstColumn, row);
+    command.lastColumn = lastColumn;
+    command.rectangle = frame;
+  }
+  
+  void RecordingDrawingService::drawBarBefore(const Location& location, const Color& color, const Rectangle& frame) {
+    Command& command = record(CommandType::DrawBarBefore, color);
+    command.location = location;
+    command.rectangle = frame;
+  }
+  
+  void RecordingDrawingService::drawBarAfter(const Location& location, const Color& color, const Rectangle& frame) {
+    Command& command = record(CommandType::DrawBarAfter, color);
+    command.location = location;
+    command.rectangle = frame;
+  }
+  
+  void RecordingDrawingService::drawText(const std::string& text, const Coordinate& coordinate, AttributeSpan attributes) {
+    Command& command = record(CommandType::DrawText, Color::black());
+    command.coordinate = coordinate;
+    command.attributeCount = attributes.size();
+    command.textOffset = m_text.size();
+    command.textLength = text.size();
+    m_text.append(text);
+  }
+  
+  Rectangle RecordingDrawingService::measureText(const std::string& text) {
+    return Rectangle(0.0f, 0.0f, cellSize().width() * text.size(), cellSize().height());
+  }
+  
+  RecordingDrawingService::Command& RecordingDrawingService::record(CommandType type, const Color& color) {
+    m_commands.emplace_back();
+    Command& command = m_commands.back();
+    command.type = type;
+    command.color = color;
+    command.lastColumn = 0;
+    command.attributeCount = 0;
+    command.textOffset = 0;
+    command.textLength = 0;
+    return command;
+  }
+}
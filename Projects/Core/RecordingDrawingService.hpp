@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Color.hpp"
+#include "Coordinate.hpp"
+#include "DrawingService.hpp"
+#include "Location.hpp"
+#include "Rectangle.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace quip {
+  // A drawing service that draws nothing, but records what it's asked to draw, so that drawing
+  // can be tested and measured without a window.
+  //
+  // Text is measured as one cell per byte. Recording allocates nothing once the service has
+  // recorded as much as it's asked to again after being cleared.
+  struct RecordingDrawingService : DrawingService {
+    enum class CommandType {
+      FillRectangle,
+      DrawUnderline,
+      DrawBarBefore,
+      DrawBarAfter,
+      DrawText
+    };
+    
+    // A recorded call. Only the fields the call has are meaningful: rectangles are filled,
+    // underlines span a location's row from its column to the last column, bars are drawn at a
+    // location, and text is drawn at a coordinate.
+    struct Command {
+      CommandType type;
+      Color color;
+      Rectangle rectangle;
+      Location location;
+      std::size_t lastColumn;
+      Coordinate coordinate;
+      std::size_t attributeCount;
+      
+      std::size_t textOffset;
+      std::size_t textLength;
+    };
+    
+    explicit RecordingDrawingService(Extent cellSize);
+    
+    const std::vector<Command>& commands() const;
+    
+    // The text drawn by a command.
+    std::string text(const Command& command) const;
+    
+    void clear();
+    
+    void fillRectangle(const Rectangle& rectangle, const Color& color) override;
+    
+    void drawUnderline(std::size_t row, std::size_t firstColumn, std::size_t lastColumn, const Color& color, const Rectangle& frame) override;
+    void drawBarBefore(const Location& location, const Color& color, const Rectangle& frame) override;
+    void drawBarAfter(const Location& location, const Color& color, const Rectangle& frame) override;
+    
+    void drawText(const std::string& text, const Coordinate& coordinate, AttributeSpan attributes) override;
+    Rectangle measureText(const std::string& text) override;
+    
+  private:
+    std::vector<Command> m_commands;
+    std::string m_text;
+    
+    Command& record(CommandType type, const Color& color);
+  };
+}
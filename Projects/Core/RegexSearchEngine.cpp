@@ -0,0 +1,92 @@
+#include "RegexSearchEngine.hpp"
+
+#include "LiteralSearchEngine.hpp"
+
+namespace quip {
+  RegexSearchEngine::RegexSearchEngine(const std::regex& pattern, const std::string& prefix, bool ignoresCase)
+  : m_pattern(pattern)
+  , m_prefix(prefix)
+  , m_ignoresCase(ignoresCase) {
+  }
+  
+  bool RegexSearchEngine::search(const char* text, std::size_t size, std::size_t start, bool isDocumentStart, bool isDocumentEnd, State&, SearchMatch& match) const {
+    if (m_prefix.empty()) {
+      return search(text, size, start, std::regex_constants::match_default, isDocumentStart, isDocumentEnd, match);
+    }
+    
+    // Every match begins with the prefix, so the expression only needs to be tried, anchored,
+    // where the prefix occurs.
+    std::size_t candidate = start;
+    while (candidate < size) {
+      candidate += findLiteral(text + candidate, size - candidate, m_prefix, m_ignoresCase);
+      if (candidate == size) {
+        break;
+      }
+      
+      if (search(text, size, candidate, std::regex_constants::match_continuous, isDocumentStart, isDocumentEnd, match)) {
+        return true;
+      }
+      
+      ++candidate;
+    }
+    
+    return false;
+  }
+  
+  std::size_t RegexSearchEngine::maximumNewlines() const {
+    return UnboundedNewlines;
+  }
+  
+  std::shared_ptr<RegexSearchEngine> RegexSearchEngine::create(const std::string& expression, bool ignoresCase) {
+    if (expression.length() > 0 && expression[expression.length() - 1] == '\\') {
+      // libc++ doesn't throw on trailing slashes like it should.
+      // See: https://llvm.org/bugs/show_bug.cgi?id=26175
+      return nullptr;
+    }
+    
+    std::regex_constants::syntax_option_type options = std::regex_constants::ECMAScript;
+    if (ignoresCase) {
+      options |= std::regex_constants::icase;
+    }
+    
+    std::string prefix;
+    LiteralSearchEngine::findLiteralPrefix(expression, prefix);
+    
+    try {
+      return std::make_shared<RegexSearchEngine>(std::regex(expression, options), prefix, ignoresCase);
+    } catch (const std::regex_error&) {
+      return nullptr;
+    }
+  }
+  
+  bool RegexSearchEngine::search(const char* text, std::size_t size, std::size_t start, std::regex_constants::match_flag_type flags, bool isDocumentStart, bool isDocumentEnd, SearchMatch& match) const {
+    flags |= std::regex_constants::match_not_null;
+    if (start > 0) {
+      flags |= std::regex_constants::match_prev_avail;
+    } else if (!isDocumentStart) {
+      flags |= std::regex_constants::match_not_bol | std::regex_constants::match_not_bow;
+    }
+    
+    if (!isDocumentEnd) {
+      flags |= std::regex_constants::match_not_eol | std::regex_constants::match_not_eow;
+    }
+    
+    std::cmatch result;
+    if (!std::regex_search(text + start, text + size, result, m_pattern, flags)) {
+      return false;
+    }
+    
+    if (result.length() == 0) {
+      // https://llvm.org/bugs/show_bug.cgi?id=21597 notes that libc++ doesn't currently
+      // respect the "ignore empty matches" flag passed above. This can cause partially-entered
+      // expressions containing \b assertions to generate an infinite loop, since searching again
+      // from the end of the match will never actually advance. As a workaround, empty matches
+      // are treated as no match at all, since that should only occur in the context of the bug.
+      return false;
+    }
+    
+    match.position = start + result.position();
+    match.length = result.length();
+    return true;
+  }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "SearchEngine.hpp"
+
+#include <memory>
+#include <regex>
+#include <string>
+
+namespace quip {
+  // A search engine backed by std::regex, which supports the full ECMAScript syntax but
+  // matches by backtracking, and so can take exponential time on some expressions.
+  struct RegexSearchEngine : SearchEngine {
+    RegexSearchEngine(const std::regex& pattern, const std::string& prefix, bool ignoresCase);
+    
+    using SearchEngine::search;
+    bool search(const char* text, std::size_t size, std::size_t start, bool isDocumentStart, bool isDocumentEnd, State& state, SearchMatch& match) const override;
+    
+    // Lookahead and backreferences make it impractical to bound the text a match depends on.
+    std::size_t maximumNewlines() const override;
+    
+    // Returns null if the expression is not valid.
+    static std::shared_ptr<RegexSearchEngine> create(const std::string& expression, bool ignoresCase);
+    
+  private:
+    std::regex m_pattern;
+    
+    // If every match begins with the same literal text, the expression is only tried where
+    // that text occurs.
+    std::string m_prefix;
+    bool m_ignoresCase;
+    
+    bool search(const char* text, std::size_t size, std::size_t start, std::regex_constants::match_flag_type flags, bool isDocumentStart, bool isDocumentEnd, SearchMatch& match) const;
+  };
+}
@@ -0,0 +1,10 @@
+#include "RowAttributeRange.hpp"
+
+namespace quip {
+  RowAttributeRange::RowAttributeRange(AttributeId attribute, std::size_t row, std::size_t start, std::size_t length)
+  : attribute(attribute)
+  , row(row)
+  , start(static_cast<std::uint32_t>(start))
+  , length(static_cast<std::uint32_t>(length)) {
+  }
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "AttributeRegistry.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace quip {
+  // An attribute range within a particular row of a document.
+  struct RowAttributeRange {
+    AttributeId attribute;
+    std::size_t row;
+    std::uint32_t start;
+    std::uint32_t length;
+    
+    RowAttributeRange(AttributeId attribute, std::size_t row, std::size_t start, std::size_t length);
+  };
+}
@@ -1,10 +1,62 @@
 #include "ScriptHost.hpp"
 
 #include "AttributeRange.hpp"
+#include "Document.hpp"
 #include "Script.hpp"
 
 #include <iostream>
 
+namespace {
+  // Creates the function that runs a syntax script over a table of rows, threading the state
+  // from one row to the next. The tokens of every row are returned in a single flat table of
+  // sets of four integers: the attribute group's ID, the row's index in the table, and the first
+  // and last character. The state each row ended in is returned in a second table.
+  //
+  // Attribute groups are interned through the given function the first time they're seen, and
+  // their IDs are remembered, so no names need to leave Lua.
+  const char* ParseRangeSource = R"(
+    local intern = ...
+    local ids = {}
+    
+    return function (script, rows, state)
+      local results = {}
+      local states = {}
+      local count = 0
+      for row = 1, #rows do
+        local tokens, endState = script(rows[row], state)
+        if type(tokens) == "table" then
+          for item = 1, #tokens, 3 do
+            local name = tokens[item]
+            local id = ids[name]
+            if id == nil then
+              id = intern(name)
+              ids[name] = id
+            end
+            
+            results[count + 1] = id
+            results[count + 2] = row
+            results[count + 3] = tokens[item + 1]
+            results[count + 4] = tokens[item + 2]
+            count = count + 4
+          end
+        end
+        
+        state = (type(endState) == "string" or type(endState) == "number") and tostring(endState) or ""
+        states[row] = state
+      end
+      
+      return results, states
+    end
+  )";
+  
+  int internAttribute(lua_State* state) {
+    std::size_t length = 0;
+    const char* name = luaL_checklstring(state, 1, &length);
+    lua_pushinteger(state, quip::AttributeRegistry::shared().intern(name, length));
+    return 1;
+  }
+}
+
 namespace quip {
   ScriptHost::ScriptHost(const std::string& rootPath)
   : m_lua(luaL_newstate())
@@ -17,6 +69,25 @@ namespace quip {
     
     // Store the quip object globally.
     lua_setglobal(m_lua, "quip");
+    
+    // Keep the range parser in the registry, where scripts can't reach it.
+    int result = luaL_loadstring(m_lua, ParseRangeSource);
+    if (result == 0) {
+      lua_pushcfunction(m_lua, internAttribute);
+      result = lua_pcall(m_lua, 1, 1, 0);
+    }
+    
+    if (result != 0) {
+      std::cerr << lua_tostring(m_lua, -1) << std::endl;
+      lua_pop(m_lua, 1);
+      m_parseRangeReference = LUA_NOREF;
+    } else {
+      m_parseRangeReference = luaL_ref(m_lua, LUA_REGISTRYINDEX);
+    }
+    
+    // Syntax functions are kept in the registry too, keyed by the path they were loaded from.
+    lua_newtable(m_lua);
+    m_syntaxTableReference = luaL_ref(m_lua, LUA_REGISTRYINDEX);
   }
   
   ScriptHost::~ScriptHost() {
@@ -43,6 +114,34 @@ namespace quip {
     return Script(path);
   }
   
+  Script ScriptHost::getSyntax(const std::string& path) {
+    lua_rawgeti(m_lua, LUA_REGISTRYINDEX, m_syntaxTableReference);
+    lua_getfield(m_lua, -1, path.c_str());
+    bool isLoaded = lua_isfunction(m_lua, -1);
+    lua_pop(m_lua, 1);
+    
+    if (!isLoaded) {
+      // Run the module once; whatever grammar it builds is captured by the function it returns.
+      int result = luaL_loadfile(m_lua, path.c_str());
+      if (result == 0) {
+        result = lua_pcall(m_lua, 0, 1, 0);
+      }
+      
+      if (result != 0) {
+        std::cerr << lua_tostring(m_lua, -1) << std::endl;
+        lua_pop(m_lua, 1);
+      } else if (!lua_isfunction(m_lua, -1)) {
+        std::cerr << path << " does not return a syntax function." << std::endl;
+        lua_pop(m_lua, 1);
+      } else {
+        lua_setfield(m_lua, -2, path.c_str());
+      }
+    }
+    
+    lua_pop(m_lua, 1);
+    return Script(path);
+  }
+  
   void ScriptHost::runScript(const Script& script) {
     lua_getglobal(m_lua, script.identifier().c_str());
     if (lua_isnil(m_lua, -1)) {
@@ -58,28 +157,44 @@ namespace quip {
   }
   
   std::vector<AttributeRange> ScriptHost::parseSyntax(const Script& script, const std::string& text) {
+    std::string endState;
+    return parseSyntax(script, text, "", endState);
+  }
+  
+  std::vector<AttributeRange> ScriptHost::parseSyntax(const Script& script, const std::string& text, const std::string& state, std::string& endState) {
     std::vector<AttributeRange> results;
+    endState.clear();
 
-    // Recover the function from the global table and push it into the stack.
-    lua_getglobal(m_lua, script.identifier().c_str());
-    if (lua_isnil(m_lua, -1)) {
-      lua_pop(m_lua, 1);
+    if (!pushSyntax(script)) {
       std::cerr << "Script not found.\n";
     }
     else {
       // Push the function's arguments and call the function.
-      lua_pushstring(m_lua, text.c_str());
-      int result = lua_pcall(m_lua, 1, LUA_MULTRET, 0);
+      lua_pushlstring(m_lua, text.data(), text.size());
+      lua_pushlstring(m_lua, state.data(), state.size());
+      int result = lua_pcall(m_lua, 2, 2, 0);
       if (result != 0) {
         std::cerr << lua_tostring(m_lua, -1);
+        lua_pop(m_lua, 1);
       } else {
-        // The result of a syntax script is a table containing the matches.
+        // The first result of a syntax script is a table containing the matches. The second,
+        // if present, is the state the row ended in.
+        if (lua_isstring(m_lua, -1)) {
+          std::size_t length = 0;
+          const char* data = lua_tolstring(m_lua, -1, &length);
+          endState.assign(data, length);
+        }
+        
+        lua_pop(m_lua, 1);
+        
         // The table will contain sets of three items: the attribute group, the first character and the last character.
         if (lua_istable(m_lua, -1)) {
           std::size_t count = lua_rawlen(m_lua, -1);
           for (std::size_t item = 0; item < count; item += 3) {
             lua_geti(m_lua, -1, item + 1);
-            std::string name = lua_tostring(m_lua, -1);
+            std::size_t nameLength = 0;
+            const char* name = lua_tolstring(m_lua, -1, &nameLength);
+            AttributeId attribute = AttributeRegistry::shared().intern(name != nullptr ? name : "", name != nullptr ? nameLength : 0);
             lua_pop(m_lua, 1);
 
             lua_geti(m_lua, -1, item + 2);
@@ -94,25 +209,120 @@ namespace quip {
             
             // Length is actually a position at this point, so adjust it.
             length -= start;
-            results.emplace_back(name, start, length);
+            results.emplace_back(attribute, start, length);
           }
-          
-          // Pop the table.
-          lua_pop(m_lua, 1);
         }
         
+        // Pop the table.
+        lua_pop(m_lua, 1);
       }
     }
     
     return results;
   }
   
+  std::vector<RowAttributeRange> ScriptHost::parseSyntaxRange(const Script& script, const Document& document, std::size_t firstRow, std::size_t lastRow) {
+    std::vector<std::string> endStates;
+    return parseSyntaxRange(script, document, firstRow, lastRow, "", endStates);
+  }
+  
+  std::vector<RowAttributeRange> ScriptHost::parseSyntaxRange(const Script& script, const Document& document, std::size_t firstRow, std::size_t lastRow, const std::string& state, std::vector<std::string>& endStates) {
+    std::vector<RowAttributeRange> results;
+    endStates.clear();
+    if (firstRow > lastRow || lastRow >= document.rows()) {
+      return results;
+    }
+    
+    lua_rawgeti(m_lua, LUA_REGISTRYINDEX, m_parseRangeReference);
+    if (lua_isnil(m_lua, -1) || !pushSyntax(script)) {
+      lua_pop(m_lua, 1);
+      std::cerr << "Script not found.\n";
+      return results;
+    }
+    
+    // Push the rows and the starting state, and make the only call into Lua.
+    std::size_t count = lastRow - firstRow + 1;
+    lua_createtable(m_lua, static_cast<int>(count), 0);
+    for (std::size_t index = 0; index < count; ++index) {
+      lua_pushlstring(m_lua, document.rowData(firstRow + index), document.rowLength(firstRow + index));
+      lua_rawseti(m_lua, -2, index + 1);
+    }
+    
+    lua_pushlstring(m_lua, state.data(), state.size());
+    int result = lua_pcall(m_lua, 3, 2, 0);
+    if (result != 0) {
+      std::cerr << lua_tostring(m_lua, -1);
+      lua_pop(m_lua, 1);
+      return results;
+    }
+    
+    // The states table is on top of the stack, with the tokens table beneath it.
+    endStates.reserve(count);
+    for (std::size_t index = 0; index < count; ++index) {
+      lua_rawgeti(m_lua, -1, index + 1);
+      std::size_t length = 0;
+      const char* data = lua_tolstring(m_lua, -1, &length);
+      endStates.emplace_back(data != nullptr ? std::string(data, length) : std::string());
+      lua_pop(m_lua, 1);
+    }
+    
+    lua_pop(m_lua, 1);
+    
+    std::size_t items = lua_rawlen(m_lua, -1);
+    results.reserve(items / 4);
+    for (std::size_t item = 0; item + 4 <= items; item += 4) {
+      lua_rawgeti(m_lua, -1, item + 1);
+      AttributeId attribute = static_cast<AttributeId>(lua_tointeger(m_lua, -1));
+      lua_pop(m_lua, 1);
+      
+      lua_rawgeti(m_lua, -1, item + 2);
+      std::size_t row = firstRow + lua_tointeger(m_lua, -1) - 1;
+      lua_pop(m_lua, 1);
+      
+      // As with single rows, the last "character" is actually the position after the token.
+      lua_rawgeti(m_lua, -1, item + 3);
+      std::size_t start = lua_tointeger(m_lua, -1) - 1;
+      lua_pop(m_lua, 1);
+      
+      lua_rawgeti(m_lua, -1, item + 4);
+      std::size_t end = lua_tointeger(m_lua, -1) - 1;
+      lua_pop(m_lua, 1);
+      
+      results.emplace_back(attribute, row, start, end - start);
+    }
+    
+    lua_pop(m_lua, 1);
+    return results;
+  }
+  
   void ScriptHost::addScriptPackagePath(const std::string& path) {
     addPackagePath("path", path + "/?.lua");
+    m_scriptPackagePaths.emplace_back(path);
   }
   
   void ScriptHost::addNativePackagePath(const std::string& path) {
     addPackagePath("cpath", path + "/?.so");
+    m_nativePackagePaths.emplace_back(path);
+  }
+  
+  const std::vector<std::string>& ScriptHost::scriptPackagePaths() const {
+    return m_scriptPackagePaths;
+  }
+  
+  const std::vector<std::string>& ScriptHost::nativePackagePaths() const {
+    return m_nativePackagePaths;
+  }
+  
+  bool ScriptHost::pushSyntax(const Script& script) {
+    lua_rawgeti(m_lua, LUA_REGISTRYINDEX, m_syntaxTableReference);
+    lua_getfield(m_lua, -1, script.identifier().c_str());
+    lua_remove(m_lua, -2);
+    if (!lua_isfunction(m_lua, -1)) {
+      lua_pop(m_lua, 1);
+      return false;
+    }
+    
+    return true;
   }
   
   void ScriptHost::addPackagePath(const std::string& variable, const std::string& path) {
@@ -2,6 +2,7 @@
 
 #include "AttributeRange.hpp"
 #include "Lua.hpp"
+#include "RowAttributeRange.hpp"
 #include "ScriptBoundObject.hpp"
 
 #include <string>
@@ -10,6 +11,7 @@
 #include <memory>
 
 namespace quip {
+  struct Document;
   struct Script;
   
   struct ScriptHost {
@@ -21,11 +23,32 @@ namespace quip {
     Script getScript(const std::string& path);
     void runScript(const Script& script);
     
+    // Load a syntax script. A syntax script is a module that builds its grammar once and returns
+    // the function that matches a row against it; the function is kept, and is what the parse
+    // methods call. Loading the same path again reuses the function.
+    Script getSyntax(const std::string& path);
+    
     std::vector<AttributeRange> parseSyntax(const Script& script, const std::string& text);
     
+    // Parse a row that begins in the given state, which is the state the script ended the
+    // previous row in (or empty for the first row), and store the state the row ends in.
+    std::vector<AttributeRange> parseSyntax(const Script& script, const std::string& text, const std::string& state, std::string& endState);
+    
+    // Parse the rows of a document from the first row to the last, inclusive, with a single
+    // call into Lua. The attributes of every row are returned together, in order.
+    std::vector<RowAttributeRange> parseSyntaxRange(const Script& script, const Document& document, std::size_t firstRow, std::size_t lastRow);
+    
+    // Parse a range of rows, the first of which begins in the given state, and store the state
+    // each row ends in.
+    std::vector<RowAttributeRange> parseSyntaxRange(const Script& script, const Document& document, std::size_t firstRow, std::size_t lastRow, const std::string& state, std::vector<std::string>& endStates);
+    
     void addScriptPackagePath(const std::string& path);
     void addNativePackagePath(const std::string& path);
     
+    // The package paths added so far, so that another host can be configured the same way.
+    const std::vector<std::string>& scriptPackagePaths() const;
+    const std::vector<std::string>& nativePackagePaths() const;
+    
     template<typename ObjectType>
     void bind(ObjectType* object, const std::string& name) {
       m_objects.emplace_back(std::make_unique<ScriptBoundObject>(object, name, ObjectType::binding(), m_lua));
@@ -38,11 +61,16 @@ namespace quip {
     
   private:
     lua_State* m_lua;
+    int m_parseRangeReference;
+    int m_syntaxTableReference;
     std::string m_root;
     std::unordered_map<std::string, Script> m_cache;
+    std::vector<std::string> m_scriptPackagePaths;
+    std::vector<std::string> m_nativePackagePaths;
     
     std::vector<std::unique_ptr<ScriptBoundObject>> m_objects;
     
     void addPackagePath(const std::string& variable, const std::string& path);
+    bool pushSyntax(const Script& script);
   };
 }
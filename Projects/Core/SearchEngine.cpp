@@ -0,0 +1,22 @@
+#include "SearchEngine.hpp"
+
+#include <limits>
+
+namespace quip {
+  const std::size_t SearchEngine::UnboundedNewlines = std::numeric_limits<std::size_t>::max();
+  
+  SearchEngine::State::~State() {
+  }
+  
+  SearchEngine::~SearchEngine() {
+  }
+  
+  bool SearchEngine::search(const char* text, std::size_t size, std::size_t start, bool isDocumentStart, bool isDocumentEnd, SearchMatch& match) const {
+    std::unique_ptr<State> state = createState();
+    return search(text, size, start, isDocumentStart, isDocumentEnd, *state, match);
+  }
+  
+  std::unique_ptr<SearchEngine::State> SearchEngine::createState() const {
+    return std::make_unique<State>();
+  }
+}
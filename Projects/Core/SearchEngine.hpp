@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+namespace quip {
+  // The location of a match within a searched text.
+  struct SearchMatch {
+    std::size_t position;
+    std::size_t length;
+  };
+  
+  // Finds matches for a compiled search expression.
+  //
+  // Documents are searched a window at a time, so an engine is told whether the text it's
+  // given begins or ends the document. Anchors only match at the edges of the text when
+  // they are also the edges of the document.
+  struct SearchEngine {
+    // Scratch space an engine keeps from one search to the next, so that searching a text
+    // for every match doesn't allocate it again for each one. A state may only be used by
+    // one search at a time, and only with the engine that created it.
+    struct State {
+      virtual ~State();
+    };
+    
+    virtual ~SearchEngine();
+    
+    // Find the first non-empty match that begins at or after the start offset of the text. The
+    // text before the start offset is only examined by assertions, such as word boundaries.
+    bool search(const char* text, std::size_t size, std::size_t start, bool isDocumentStart, bool isDocumentEnd, SearchMatch& match) const;
+    virtual bool search(const char* text, std::size_t size, std::size_t start, bool isDocumentStart, bool isDocumentEnd, State& state, SearchMatch& match) const = 0;
+    
+    // Engines that don't need any scratch space share this empty state.
+    virtual std::unique_ptr<State> createState() const;
+    
+    // The most newlines a match can contain, or UnboundedNewlines if there's no limit or the
+    // engine can't tell. A match is only certain to be the one the whole document would give if
+    // the text it was found in continues for at least that many rows past the row it begins on.
+    virtual std::size_t maximumNewlines() const = 0;
+    
+    static const std::size_t UnboundedNewlines;
+  };
+}
@@ -1,33 +1,47 @@
 #include "SearchExpression.hpp"
 
+#include "AutomatonSearchEngine.hpp"
+#include "LiteralSearchEngine.hpp"
+#include "RegexSearchEngine.hpp"
+
 namespace quip {
   SearchExpression::SearchExpression(const std::string& expression)
-  : m_valid(true)
-  , m_expression(expression) {
-    if (expression.length() == 0) {
-      m_valid = false;
-    } else if (expression[expression.length() - 1] == '\\') {
-      // libc++ doesn't throw on trailing slashes like it should.
-      // See: https://llvm.org/bugs/show_bug.cgi?id=26175
-      m_valid = false;
-    } else {
-      try {
-        m_pattern = std::regex(expression);
-      } catch (const std::regex_error&) {
-        m_valid = false;
+  : SearchExpression(expression, false) {
+  }
+  
+  SearchExpression::SearchExpression(const std::string& expression, bool ignoresCase)
+  : m_expression(expression)
+  , m_ignoresCase(ignoresCase) {
+    if (expression.length() > 0) {
+      // Expressions that are just literal text, which is most of them, are found with a
+      // substring search. The automaton engine always runs in linear time, so std::regex is
+      // only used for expressions the automaton can't handle. That's also how invalid
+      // expressions are ultimately rejected.
+      std::string literal;
+      if (LiteralSearchEngine::findLiteralPrefix(expression, literal)) {
+        m_engine = std::make_shared<LiteralSearchEngine>(literal, ignoresCase);
+      } else {
+        m_engine = AutomatonSearchEngine::create(expression, ignoresCase);
+        if (m_engine == nullptr) {
+          m_engine = RegexSearchEngine::create(expression, ignoresCase);
+        }
       }
     }
   }
   
   bool SearchExpression::valid() const {
-    return m_valid;
+    return m_engine != nullptr;
+  }
+  
+  bool SearchExpression::ignoresCase() const {
+    return m_ignoresCase;
   }
   
   const std::string& SearchExpression::expression() const {
     return m_expression;
   }
   
-  const std::regex& SearchExpression::pattern() const {
-    return m_pattern;
+  const SearchEngine& SearchExpression::engine() const {
+    return *m_engine;
   }
 }
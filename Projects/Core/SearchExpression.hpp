@@ -1,20 +1,26 @@
 #pragma once
 
-#include <regex>
+#include <memory>
 #include <string>
 
 namespace quip {
+  struct SearchEngine;
+  
   struct SearchExpression {
     SearchExpression (const std::string & expression);
+    SearchExpression (const std::string & expression, bool ignoresCase);
     
     bool valid () const;
+    bool ignoresCase () const;
     
     const std::string & expression () const;
-    const std::regex & pattern () const;
+    
+    // The engine that finds matches for the expression. Only available if the expression is valid.
+    const SearchEngine & engine () const;
     
   private:
-    bool m_valid;
     std::string m_expression;
-    std::regex m_pattern;
+    bool m_ignoresCase;
+    std::shared_ptr<const SearchEngine> m_engine;
   };
-}
\ No newline at end of file
+}
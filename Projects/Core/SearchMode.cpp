@@ -3,11 +3,11 @@
 #include "Color.hpp"
 #include "Document.hpp"
 #include "EditContext.hpp"
-#include "SearchExpression.hpp"
 #include "SelectionDrawInfo.hpp"
 
 namespace quip {
-  SearchMode::SearchMode() {
+  SearchMode::SearchMode()
+  : m_isCommitting(false) {
     addMapping(Key::Escape, &SearchMode::abortSearch);
     addMapping(Key::Return, &SearchMode::commitSearch);
   }
@@ -16,6 +16,40 @@ namespace quip {
     return "s/" + m_search;
   }
   
+  bool SearchMode::defersKeys() const {
+    return m_isCommitting;
+  }
+  
+  void SearchMode::onEnter(EditContext& context, std::uint64_t how) {
+    // The document can't be edited while searching, so every search can share one snapshot,
+    // which lets each search refine the results of the last.
+    m_snapshot = context.document().snapshot();
+    m_isCommitting = false;
+  }
+  
+  bool SearchMode::onTick(EditContext& context) {
+    if (!m_results.poll()) {
+      return false;
+    }
+    
+    if (m_isCommitting && !m_results.isSearching()) {
+      finishSearch(context);
+      return true;
+    }
+    
+    if (m_results.isSearching() || m_results.isValid()) {
+      SelectionDrawInfo overlay;
+      overlay.selections = m_results.matches();
+      overlay.flags = CursorFlags::None;
+      overlay.style = CursorStyle::VerticalBlock;
+      overlay.primaryColor = Color(1.0f, 1.0f, 0.2f);
+      overlay.secondaryColor = Color(1.0f, 1.0f, 0.8f);
+      context.setOverlay("Search", overlay);
+    }
+    
+    return true;
+  }
+  
   bool SearchMode::onUnmappedKey(Key key, const std::string& text, EditContext& context) {
     if (text.size() == 0 && key != Key::Delete) {
       return false;
@@ -29,33 +63,47 @@ namespace quip {
       m_search += text;
     }
     
+    // Searching happens in the background; the overlay is updated as results arrive.
     if (m_search.size() > 0) {
-      SearchExpression expression(m_search);
-      if (expression.valid()) {
-        SelectionDrawInfo overlay;
-        overlay.selections = context.document().matches(expression);
-        overlay.flags = CursorFlags::None;
-        overlay.style = CursorStyle::VerticalBlock;
-        overlay.primaryColor = Color(1.0f, 1.0f, 0.2f);
-        overlay.secondaryColor = Color(1.0f, 1.0f, 0.8f);
-        context.setOverlay("Search", overlay);
-      }
+      m_results.start(m_snapshot, m_search);
+    } else {
+      m_results.cancel();
+      context.clearOverlay("Search");
     }
     
     return true;
   }
   
   void SearchMode::abortSearch(EditContext& context) {
+    m_isCommitting = false;
     m_search = "";
+    m_snapshot = nullptr;
+    m_results.cancel();
     
     context.clearOverlay("Search");
     context.leaveMode();
   }
   
   void SearchMode::commitSearch(EditContext& context) {
-    context.selections().replace(context.document().matches(SearchExpression(m_search)));
+    // Committing never waits on the search. If it's still running, the mode stays open until the
+    // rest of the matches arrive, and onTick finishes the commit; the context holds on to keys
+    // pressed until then.
+    m_results.poll();
+    if (m_results.isSearching()) {
+      m_isCommitting = true;
+      return;
+    }
+    
+    finishSearch(context);
+  }
+  
+  void SearchMode::finishSearch(EditContext& context) {
+    m_isCommitting = false;
+    context.selections().replace(m_results.matches());
     m_search = "";
-
+    m_snapshot = nullptr;
+    m_results.cancel();
+    
     context.clearOverlay("Search");
     context.leaveMode();
   }
@@ -1,22 +1,38 @@
 #pragma once
 
 #include "Mode.hpp"
+#include "SearchService.hpp"
+
+#include <memory>
 
 namespace quip {
+  struct Document;
   struct EditContext;
   
   struct SearchMode : Mode {
     SearchMode ();
     
     std::string status () const override;
+    bool defersKeys () const override;
     
   protected:
+    void onEnter (EditContext & context, std::uint64_t how) override;
+    bool onTick (EditContext & context) override;
     bool onUnmappedKey (Key key, const std::string & text, EditContext & context) override;
     
   private:
     void abortSearch (EditContext & context);
     void commitSearch (EditContext & context);
+    void finishSearch (EditContext & context);
     
     std::string m_search;
+    std::shared_ptr<const Document> m_snapshot;
+    SearchService m_results;
+    
+    // Set when the search was committed before it finished searching, in which case the matches
+    // are committed once the rest of them arrive. Keys pressed in the meantime are deferred until
+    // then, so they act on the committed matches just as they would have had the search been
+    // finished.
+    bool m_isCommitting;
   };
 }
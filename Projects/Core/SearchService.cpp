@@ -0,0 +1,154 @@
+#include "SearchService.hpp"
+
+#include "Document.hpp"
+
+namespace quip {
+  SearchService::SearchService()
+  : m_state(std::make_shared<State>())
+  , m_isSearching(false)
+  , m_isValid(false) {
+    std::thread(&SearchService::run, m_state).detach();
+  }
+  
+  SearchService::~SearchService() {
+    {
+      std::lock_guard<std::mutex> lock(m_state->mutex);
+      m_state->isStopping = true;
+      ++m_state->generation;
+    }
+    
+    m_state->requested.notify_one();
+  }
+  
+  void SearchService::start(std::shared_ptr<const Document> document, const std::string& expression) {
+    post(document, expression);
+    m_isSearching = true;
+  }
+  
+  void SearchService::cancel() {
+    post(nullptr, "");
+    m_isSearching = false;
+  }
+  
+  bool SearchService::poll() {
+    std::vector<Selection> collected;
+    bool wasSearching = m_isSearching;
+    {
+      std::lock_guard<std::mutex> lock(m_state->mutex);
+      collected.swap(m_state->published);
+      
+      m_isSearching = m_isSearching && !m_state->isPublishedFinished;
+      m_isValid = m_state->isPublishedValid;
+    }
+    
+    if (collected.empty() && m_isSearching == wasSearching) {
+      return false;
+    }
+    
+    m_matches.append(collected);
+    return true;
+  }
+  
+  void SearchService::wait() {
+    {
+      std::unique_lock<std::mutex> lock(m_state->mutex);
+      m_state->finished.wait(lock, [this] () {
+        return m_state->isPublishedFinished;
+      });
+    }
+    
+    poll();
+  }
+  
+  bool SearchService::isSearching() const {
+    return m_isSearching;
+  }
+  
+  bool SearchService::isValid() const {
+    return m_isValid;
+  }
+  
+  const SelectionSet& SearchService::matches() const {
+    return m_matches;
+  }
+  
+  SearchService::State::State()
+  : isStopping(false)
+  , hasRequest(false)
+  , generation(0)
+  , isPublishedFinished(true)
+  , isPublishedValid(false) {
+  }
+  
+  void SearchService::post(std::shared_ptr<const Document> document, const std::string& expression) {
+    {
+      std::lock_guard<std::mutex> lock(m_state->mutex);
+      m_state->request.document = document;
+      m_state->request.expression = expression;
+      m_state->request.generation = ++m_state->generation;
+      m_state->hasRequest = true;
+      
+      m_state->published.clear();
+      m_state->isPublishedFinished = document == nullptr;
+      m_state->isPublishedValid = false;
+    }
+    
+    m_state->requested.notify_one();
+    m_matches = SelectionSet();
+    m_isValid = false;
+  }
+  
+  void SearchService::run(std::shared_ptr<State> state) {
+    // The snapshot being searched and its results belong to the worker alone.
+    std::shared_ptr<const Document> document;
+    IncrementalSearch search;
+    for (;;) {
+      Request request;
+      {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->requested.wait(lock, [&state] () {
+          return state->isStopping || state->hasRequest;
+        });
+        
+        if (state->isStopping) {
+          return;
+        }
+        
+        request = std::move(state->request);
+        state->hasRequest = false;
+      }
+      
+      if (request.document == nullptr) {
+        search.clear();
+        document = nullptr;
+        continue;
+      }
+      
+      // Earlier results are only reusable while the same snapshot is being searched.
+      if (request.document != document) {
+        search.clear();
+        document = request.document;
+      }
+      
+      bool isValid = search.update(*document, request.expression, [&state, &request] (const std::vector<Selection>& found) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->generation != request.generation) {
+          return false;
+        }
+        
+        state->published.insert(state->published.end(), found.begin(), found.end());
+        return true;
+      });
+      
+      {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->generation == request.generation) {
+          state->isPublishedFinished = true;
+          state->isPublishedValid = isValid;
+        }
+      }
+      
+      state->finished.notify_all();
+    }
+  }
+}
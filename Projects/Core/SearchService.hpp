@@ -0,0 +1,89 @@
+#pragma once
+
+#include "IncrementalSearch.hpp"
+#include "Selection.hpp"
+#include "SelectionSet.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace quip {
+  struct Document;
+  
+  // Searches documents on a worker thread.
+  //
+  // Each search runs over a snapshot of a document, so the document can continue to be edited
+  // while it's searched. Matches are published as they're found and collected by polling, and
+  // starting a new search cancels the one in progress as soon as it has finished searching its
+  // current window of text. Successive searches of the same snapshot are refined incrementally
+  // (see IncrementalSearch).
+  //
+  // Destroying a service never waits on the worker. A search in progress is abandoned, and the
+  // worker, which shares its state with the service rather than belonging to it, exits on its
+  // own once it finishes its current window.
+  //
+  // Apart from the worker, a service must only be used from the thread that created it.
+  struct SearchService {
+    SearchService();
+    ~SearchService();
+    
+    SearchService(const SearchService& other) = delete;
+    SearchService& operator=(const SearchService& other) = delete;
+    
+    void start(std::shared_ptr<const Document> document, const std::string& expression);
+    void cancel();
+    
+    // Collect the matches published since the last poll. Returns true if the results changed.
+    bool poll();
+    
+    // Block until the current search finishes, then collect its results.
+    void wait();
+    
+    // The state of the current search, as of the last poll.
+    bool isSearching() const;
+    bool isValid() const;
+    const SelectionSet& matches() const;
+    
+  private:
+    // A request with no document releases the worker's snapshot.
+    struct Request {
+      std::shared_ptr<const Document> document;
+      std::string expression;
+      std::uint64_t generation;
+    };
+    
+    // The state shared by the service and its worker.
+    struct State {
+      State();
+      
+      std::mutex mutex;
+      std::condition_variable requested;
+      std::condition_variable finished;
+      
+      // Guarded by the mutex.
+      bool isStopping;
+      bool hasRequest;
+      Request request;
+      std::uint64_t generation;
+      std::vector<Selection> published;
+      bool isPublishedFinished;
+      bool isPublishedValid;
+    };
+    
+    std::shared_ptr<State> m_state;
+    
+    // Used only by the owning thread. The worker publishes matches in order, so they're appended
+    // to the set as they're collected.
+    SelectionSet m_matches;
+    bool m_isSearching;
+    bool m_isValid;
+    
+    void post(std::shared_ptr<const Document> document, const std::string& expression);
+    static void run(std::shared_ptr<State> state);
+  };
+}
@@ -2,6 +2,8 @@
 
 #include "Selection.hpp"
 
+#include <algorithm>
+
 namespace {
   static bool compareSelectionsByLowestLocation(const quip::Selection& left, const quip::Selection& right) {
     return left.origin() < right.origin();
@@ -131,4 +133,23 @@ namespace quip {
     m_selections.insert(m_selections.begin(), selections.begin(), selections.end());
     m_primary = selections.m_primary;
   }
+  
+  void SelectionSet::append(const std::vector<Selection>& selections) {
+    m_selections.reserve(m_selections.size() + selections.size());
+    for (const Selection& selection : selections) {
+      if (!m_selections.empty() && m_selections.back().extent() >= selection.origin()) {
+        m_selections.back() = Selection(m_selections.back().origin(), selection.extent());
+      } else {
+        m_selections.emplace_back(selection);
+      }
+    }
+  }
+  
+  bool operator==(const SelectionSet& left, const SelectionSet& right) {
+    return left.m_primary == right.m_primary && left.m_selections == right.m_selections;
+  }
+  
+  bool operator!=(const SelectionSet& left, const SelectionSet& right) {
+    return !(left == right);
+  }
 }
@@ -34,8 +34,17 @@ namespace quip {
     void replace (const Selection & primary);
     void replace (const SelectionSet & selections);
     
+    // Add selections that are in order and follow every selection already in the set, without
+    // sorting the set again. Overlapping selections are collapsed, as on construction.
+    void append (const std::vector<Selection> & selections);
+    
+    // Selection sets are equal if they have the same selections and the same primary selection.
+    friend bool operator== (const SelectionSet & left, const SelectionSet & right);
+    
   private:
     std::vector<Selection> m_selections;
     std::size_t m_primary;
   };
+  
+  bool operator!= (const SelectionSet & left, const SelectionSet & right);
 }
\ No newline at end of file
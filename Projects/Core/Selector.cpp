@@ -125,7 +125,7 @@ namespace quip {
     Location origin(0, basis.origin().row());
     
     std::uint64_t row = basis.extent().row();
-    Location extent(document.row(row).size() - 1, row);
+    Location extent(document.rowLength(row) - 1, row);
     return Optional<Selection>(Selection(origin, extent));
   }
   
@@ -138,7 +138,7 @@ namespace quip {
     if (row + 1 < document.rows()) {
       ++row;
       Location origin(0, row);
-      Location extent(document.row(row).size() - 1, row);
+      Location extent(document.rowLength(row) - 1, row);
       return Optional<Selection>(Selection(origin, extent));
     }
     
@@ -154,7 +154,7 @@ namespace quip {
     if (row > 0) {
       --row;
       Location origin(0, row);
-      Location extent(document.row(row).size() - 1, row);
+      Location extent(document.rowLength(row) - 1, row);
       return Optional<Selection>(Selection(origin, extent));
     }
     
@@ -0,0 +1,182 @@
+#include "SubstringSearch.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define QUIP_SUBSTRING_SEARCH_X86 1
+#endif
+
+namespace quip {
+  namespace {
+    unsigned char foldCase(unsigned char byte) {
+      return byte >= 'A' && byte <= 'Z' ? byte + ('a' - 'A') : byte;
+    }
+    
+    bool isLetter(unsigned char byte) {
+      return foldCase(byte) >= 'a' && foldCase(byte) <= 'z';
+    }
+    
+    bool equalIgnoringCase(const char* left, const char* right, std::size_t length) {
+      for (std::size_t index = 0; index < length; ++index) {
+        if (foldCase(left[index]) != foldCase(right[index])) {
+          return false;
+        }
+      }
+      
+      return true;
+    }
+    
+    bool equal(const char* left, const char* right, std::size_t length, bool ignoresCase) {
+      return ignoresCase ? equalIgnoringCase(left, right, length) : std::memcmp(left, right, length) == 0;
+    }
+    
+    std::size_t searchScalar(const char* data, std::size_t size, const char* needle, std::size_t length, bool ignoresCase) {
+      if (length > size) {
+        return size;
+      }
+      
+      std::size_t last = size - length;
+      if (!ignoresCase || !isLetter(needle[0])) {
+        const char* cursor = data;
+        while (cursor <= data + last) {
+          const void* candidate = std::memchr(cursor, needle[0], data + last - cursor + 1);
+          if (candidate == nullptr) {
+            break;
+          }
+          
+          cursor = static_cast<const char*>(candidate);
+          if (equal(cursor + 1, needle + 1, length - 1, ignoresCase)) {
+            return cursor - data;
+          }
+          
+          ++cursor;
+        }
+        
+        return size;
+      }
+      
+      for (std::size_t offset = 0; offset <= last; ++offset) {
+        if (equalIgnoringCase(data + offset, needle, length)) {
+          return offset;
+        }
+      }
+      
+      return size;
+    }
+
+#if defined(QUIP_SUBSTRING_SEARCH_X86)
+    // Letters are compared ignoring case by setting the bit that distinguishes lowercase from
+    // uppercase ASCII letters in both the buffer and the needle's byte. Other bytes are
+    // compared exactly.
+    struct Probe {
+      Probe(unsigned char byte, bool ignoresCase)
+      : value(ignoresCase ? foldCase(byte) : byte)
+      , mask(ignoresCase && isLetter(byte) ? 0x20 : 0) {
+      }
+      
+      unsigned char value;
+      unsigned char mask;
+    };
+    
+    __attribute__((target("sse2")))
+    std::size_t searchSSE2(const char* data, std::size_t size, const char* needle, std::size_t length, bool ignoresCase) {
+      Probe first(needle[0], ignoresCase);
+      Probe last(needle[length - 1], ignoresCase);
+      const __m128i firstValue = _mm_set1_epi8(first.value);
+      const __m128i firstMask = _mm_set1_epi8(first.mask);
+      const __m128i lastValue = _mm_set1_epi8(last.value);
+      const __m128i lastMask = _mm_set1_epi8(last.mask);
+      
+      std::size_t offset = 0;
+      for (; offset + length - 1 + 16 <= size; offset += 16) {
+        __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset));
+        __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset + length - 1));
+        __m128i headMatches = _mm_cmpeq_epi8(_mm_or_si128(head, firstMask), firstValue);
+        __m128i tailMatches = _mm_cmpeq_epi8(_mm_or_si128(tail, lastMask), lastValue);
+        std::uint32_t candidates = _mm_movemask_epi8(_mm_and_si128(headMatches, tailMatches));
+        while (candidates != 0) {
+          std::size_t candidate = offset + __builtin_ctz(candidates);
+          if (equal(data + candidate, needle, length, ignoresCase)) {
+            return candidate;
+          }
+          
+          candidates &= candidates - 1;
+        }
+      }
+      
+      return offset + searchScalar(data + offset, size - offset, needle, length, ignoresCase);
+    }
+    
+    __attribute__((target("avx2")))
+    std::size_t searchAVX2(const char* data, std::size_t size, const char* needle, std::size_t length, bool ignoresCase) {
+      Probe first(needle[0], ignoresCase);
+      Probe last(needle[length - 1], ignoresCase);
+      const __m256i firstValue = _mm256_set1_epi8(first.value);
+      const __m256i firstMask = _mm256_set1_epi8(first.mask);
+      const __m256i lastValue = _mm256_set1_epi8(last.value);
+      const __m256i lastMask = _mm256_set1_epi8(last.mask);
+      
+      std::size_t offset = 0;
+      for (; offset + length - 1 + 32 <= size; offset += 32) {
+        __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + offset));
+        __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + offset + length - 1));
+        __m256i headMatches = _mm256_cmpeq_epi8(_mm256_or_si256(head, firstMask), firstValue);
+        __m256i tailMatches = _mm256_cmpeq_epi8(_mm256_or_si256(tail, lastMask), lastValue);
+        std::uint32_t candidates = _mm256_movemask_epi8(_mm256_and_si256(headMatches, tailMatches));
+        while (candidates != 0) {
+          std::size_t candidate = offset + __builtin_ctz(candidates);
+          if (equal(data + candidate, needle, length, ignoresCase)) {
+            return candidate;
+          }
+          
+          candidates &= candidates - 1;
+        }
+      }
+      
+      return offset + searchSSE2(data + offset, size - offset, needle, length, ignoresCase);
+    }
+    
+    typedef std::size_t (*SearchFunction)(const char*, std::size_t, const char*, std::size_t, bool);
+    
+    SearchFunction selectSearchFunction() {
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2")) {
+        return &searchAVX2;
+      }
+      
+      if (__builtin_cpu_supports("sse2")) {
+        return &searchSSE2;
+      }
+      
+      return &searchScalar;
+    }
+#endif
+    
+    std::size_t search(const char* data, std::size_t size, const char* needle, std::size_t length, bool ignoresCase) {
+      if (length == 0) {
+        return 0;
+      }
+      
+      if (length > size) {
+        return size;
+      }
+
+#if defined(QUIP_SUBSTRING_SEARCH_X86)
+      static const SearchFunction function = selectSearchFunction();
+      return function(data, size, needle, length, ignoresCase);
+#else
+      return searchScalar(data, size, needle, length, ignoresCase);
+#endif
+    }
+  }
+  
+  std::size_t findSubstring(const char* data, std::size_t size, const char* needle, std::size_t length) {
+    return search(data, size, needle, length, false);
+  }
+  
+  std::size_t findSubstringIgnoringCase(const char* data, std::size_t size, const char* needle, std::size_t length) {
+    return search(data, size, needle, length, true);
+  }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+
+namespace quip {
+  // Find the first occurrence of a needle in a buffer, returning its offset, or the size of the
+  // buffer if the needle doesn't occur.
+  //
+  // Candidate positions are found by comparing the first and last bytes of the needle against
+  // a whole vector of the buffer at a time (using AVX2 or SSE2 on x86), and only candidates are
+  // compared in full. Elsewhere, candidates are found with memchr.
+  std::size_t findSubstring(const char* data, std::size_t size, const char* needle, std::size_t length);
+  
+  // Find the first occurrence of a needle in a buffer, ignoring the case of ASCII letters.
+  std::size_t findSubstringIgnoringCase(const char* data, std::size_t size, const char* needle, std::size_t length);
+}
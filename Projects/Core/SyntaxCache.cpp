@@ -0,0 +1,192 @@
+#include "SyntaxCache.hpp"
+
+#include "Document.hpp"
+#include "DocumentChange.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+  // The most rows parsed together.
+  const std::size_t ParseBatchSize = 256;
+  
+  // The state at the start of the document is empty, and is interned first.
+  const std::uint32_t InitialState = 0;
+  
+  // The state of a row that hasn't been parsed.
+  const std::uint32_t UnparsedState = std::numeric_limits<std::uint32_t>::max();
+}
+
+namespace quip {
+  SyntaxCache::SyntaxCache(Document& document, const Parser& parser)
+  : SyntaxCache(document, [&document, parser] (std::size_t firstRow, std::size_t lastRow, const std::string& state, std::vector<std::string>& endStates) {
+    std::vector<RowAttributeRange> results;
+    std::string current = state;
+    for (std::size_t row = firstRow; row <= lastRow; ++row) {
+      std::string endState;
+      for (const AttributeRange& range : parser(document.row(row), current, endState)) {
+        results.emplace_back(range.attribute, row, range.start, range.length);
+      }
+      
+      endStates.emplace_back(endState);
+      current = endState;
+    }
+    
+    return results;
+  }) {
+  }
+  
+  SyntaxCache::SyntaxCache(Document& document, const RangeParser& parser)
+  : m_document(&document)
+  , m_parser(parser)
+  , m_documentRows(document.rows())
+  , m_validRows(0) {
+    internState("");
+    m_documentModifiedToken = m_document->onDocumentModified().connect([this] (const DocumentChange& change) {
+      apply(change);
+    });
+  }
+  
+  SyntaxCache::SyntaxCache(std::size_t rows, const RangeParser& parser)
+  : m_document(nullptr)
+  , m_parser(parser)
+  , m_documentRows(rows)
+  , m_validRows(0)
+  , m_documentModifiedToken(0) {
+    internState("");
+  }
+  
+  SyntaxCache::~SyntaxCache() {
+    if (m_document != nullptr) {
+      m_document->onDocumentModified().disconnect(m_documentModifiedToken);
+    }
+  }
+  
+  AttributeSpan SyntaxCache::attributes(std::size_t row) {
+    prepare(row);
+    return m_attributes.attributes(row);
+  }
+  
+  void SyntaxCache::prepare(std::size_t lastRow) {
+    if (m_documentRows == 0) {
+      return;
+    }
+    
+    lastRow = std::min(lastRow, m_documentRows - 1);
+    if (lastRow >= m_rows.size()) {
+      m_rows.resize(lastRow + 1);
+      m_attributes.resize(lastRow + 1);
+    }
+    
+    while (m_validRows <= lastRow) {
+      const Row& cached = m_rows[m_validRows];
+      std::uint32_t state = m_validRows == 0 ? InitialState : m_rows[m_validRows - 1].endState;
+      if (cached.isParsed() && cached.state == state) {
+        ++m_validRows;
+        continue;
+      }
+      
+      // The rows after this one that have never been parsed certainly need to be, so they're
+      // parsed along with it.
+      std::size_t last = m_validRows;
+      while (last < lastRow && last + 1 - m_validRows < ParseBatchSize && !m_rows[last + 1].isParsed()) {
+        ++last;
+      }
+      
+      parse(m_validRows, last, state);
+      m_validRows = last + 1;
+    }
+  }
+  
+  void SyntaxCache::invalidate() {
+    m_rows.clear();
+    m_attributes = AttributeArena();
+    m_validRows = 0;
+  }
+  
+  SyntaxCache::Row::Row()
+  : state(UnparsedState)
+  , endState(UnparsedState) {
+  }
+  
+  bool SyntaxCache::Row::isParsed() const {
+    return state != UnparsedState;
+  }
+  
+  std::uint32_t SyntaxCache::internState(const std::string& state) {
+    std::unordered_map<std::string, std::uint32_t>::const_iterator cursor = m_stateIds.find(state);
+    if (cursor != m_stateIds.end()) {
+      return cursor->second;
+    }
+    
+    std::uint32_t id = static_cast<std::uint32_t>(m_states.size());
+    m_states.emplace_back(state);
+    m_stateIds.emplace(state, id);
+    return id;
+  }
+  
+  void SyntaxCache::parse(std::size_t firstRow, std::size_t lastRow, std::uint32_t state) {
+    std::vector<std::string> endStates;
+    std::vector<RowAttributeRange> ranges = m_parser(firstRow, lastRow, m_states[state], endStates);
+    endStates.resize(lastRow - firstRow + 1);
+    
+    // Each row's ranges are stored together, so they're grouped by row first (parsers produce
+    // them in order, so this rarely has any work to do).
+    auto isBefore = [] (const RowAttributeRange& left, const RowAttributeRange& right) {
+      return left.row < right.row;
+    };
+    
+    if (!std::is_sorted(ranges.begin(), ranges.end(), isBefore)) {
+      std::stable_sort(ranges.begin(), ranges.end(), isBefore);
+    }
+    
+    std::vector<RowAttributeRange>::const_iterator range = ranges.begin();
+    while (range != ranges.end() && range->row < firstRow) {
+      ++range;
+    }
+    
+    std::uint32_t startState = state;
+    for (std::size_t row = firstRow; row <= lastRow; ++row) {
+      Row& cached = m_rows[row];
+      cached.state = startState;
+      cached.endState = internState(endStates[row - firstRow]);
+      startState = cached.endState;
+      
+      std::vector<RowAttributeRange>::const_iterator first = range;
+      while (range != ranges.end() && range->row == row) {
+        ++range;
+      }
+      
+      m_attributes.assign(row, first, range);
+    }
+  }
+  
+  void SyntaxCache::apply(const DocumentChange& change) {
+    m_documentRows = m_documentRows - change.removedRows + change.insertedRows;
+    m_validRows = std::min(m_validRows, change.firstRow);
+    
+    // Rows past the last one prepared aren't cached, so a change reaching them leaves nothing
+    // from its first row on worth keeping.
+    if (change.firstRow + change.removedRows > m_rows.size()) {
+      std::size_t rows = std::min(change.firstRow, m_rows.size());
+      m_rows.resize(rows);
+      m_attributes.resize(rows);
+      return;
+    }
+    
+    // Rows replaced one for one are discarded in place; only the difference shifts the rows
+    // that follow.
+    std::size_t replaced = std::min(change.removedRows, change.insertedRows);
+    std::vector<Row>::iterator first = m_rows.begin() + change.firstRow;
+    std::fill(first, first + replaced, Row());
+    
+    first += replaced;
+    if (change.removedRows > replaced) {
+      m_rows.erase(first, first + (change.removedRows - replaced));
+    } else {
+      m_rows.insert(first, change.insertedRows - replaced, Row());
+    }
+    
+    m_attributes.apply(change);
+  }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "AttributeArena.hpp"
+#include "AttributeRange.hpp"
+#include "RowAttributeRange.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace quip {
+  struct Document;
+  struct DocumentChange;
+  
+  // Remembers the syntax attributes of each row of a document, so that a row is only parsed
+  // again after it's been modified. The cache follows the document's modifications, discarding
+  // the attributes of the rows each one affected and shifting the rest along with their rows.
+  //
+  // Rows are parsed in order, each starting in the state the previous row ended in, so that
+  // constructs spanning rows (such as block comments) can be recognized. A row whose text is
+  // unchanged and which starts in the same state as when it was last parsed isn't parsed again,
+  // so after an edit, parsing stops at the first row whose state is unaffected by it.
+  //
+  // Consecutive rows that need parsing are parsed in batches of bounded size, which lets a
+  // parser that crosses into a scripting language do so once per batch instead of once per row.
+  //
+  // Only the rows up to the last one prepared are cached, and each stores its states as small
+  // identifiers for the strings, which are interned by the cache.
+  struct SyntaxCache {
+    // Parses the text of a row that begins in the given state, and stores the state the row
+    // ends in. The state at the start of the document is empty.
+    typedef std::function<std::vector<AttributeRange> (const std::string& text, const std::string& state, std::string& endState)> Parser;
+    
+    // Parses the rows of the document from the first row to the last, inclusive, the first of
+    // which begins in the given state, and stores the state each row ends in.
+    typedef std::function<std::vector<RowAttributeRange> (std::size_t firstRow, std::size_t lastRow, const std::string& state, std::vector<std::string>& endStates)> RangeParser;
+    
+    SyntaxCache(Document& document, const Parser& parser);
+    SyntaxCache(Document& document, const RangeParser& parser);
+    
+    // A cache with the given number of rows that isn't attached to a document, such as one
+    // for a series of snapshots of a document. Its owner applies the document's changes.
+    SyntaxCache(std::size_t rows, const RangeParser& parser);
+    ~SyntaxCache();
+    
+    SyntaxCache(const SyntaxCache& other) = delete;
+    SyntaxCache& operator=(const SyntaxCache& other) = delete;
+    
+    // The attributes of a row, parsing it (and any earlier rows that need it) if necessary. The
+    // span is invalidated by the next modification of the cache.
+    AttributeSpan attributes(std::size_t row);
+    
+    // Parse every row up to and including the given row that needs it, such as the rows about
+    // to be drawn, so that they can be parsed together.
+    void prepare(std::size_t lastRow);
+    
+    // Discard every row's attributes, such as when the document's syntax changes.
+    void invalidate();
+    
+    // Follow a modification of the document.
+    void apply(const DocumentChange& change);
+    
+  private:
+    // The identifiers of the states a row was last parsed in and ended in.
+    struct Row {
+      Row();
+      
+      bool isParsed() const;
+      
+      std::uint32_t state;
+      std::uint32_t endState;
+    };
+    
+    Document* m_document;
+    RangeParser m_parser;
+    std::size_t m_documentRows;
+    std::vector<Row> m_rows;
+    AttributeArena m_attributes;
+    
+    // Every state seen so far, indexed by identifier, and the identifier of each.
+    std::vector<std::string> m_states;
+    std::unordered_map<std::string, std::uint32_t> m_stateIds;
+    
+    // Every row before this one has been parsed in the state the row before it ended in.
+    std::size_t m_validRows;
+    
+    std::uint32_t m_documentModifiedToken;
+    
+    std::uint32_t internState(const std::string& state);
+    void parse(std::size_t firstRow, std::size_t lastRow, std::uint32_t state);
+  };
+}
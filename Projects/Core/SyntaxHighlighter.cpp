@@ -0,0 +1,250 @@
+#include "SyntaxHighlighter.hpp"
+
+#include "Document.hpp"
+#include "ScriptHost.hpp"
+#include "SyntaxCache.hpp"
+
+#include <algorithm>
+
+namespace {
+  // The number of rows the worker parses between checks for a newer request.
+  const std::size_t WorkerStepSize = 256;
+}
+
+namespace quip {
+  SyntaxHighlighter::SyntaxHighlighter(Document& document, const ScriptHost& host)
+  : m_document(document)
+  , m_rootPath(host.scriptRootPath())
+  , m_scriptPackagePaths(host.scriptPackagePaths())
+  , m_nativePackagePaths(host.nativePackagePaths())
+  , m_isStopping(false)
+  , m_hasRequest(false)
+  , m_isBusy(false)
+  , m_attributes(document.rows())
+  , m_hasSyntaxChanged(false)
+  , m_version(0)
+  , m_requestedVersion(0)
+  , m_requestedFirstRow(0)
+  , m_requestedLastRow(0) {
+    m_documentModifiedToken = m_document.onDocumentModified().connect([this] (const DocumentChange& change) {
+      onDocumentModified(change);
+    });
+    
+    m_worker = std::thread(&SyntaxHighlighter::run, this);
+  }
+  
+  SyntaxHighlighter::~SyntaxHighlighter() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_isStopping = true;
+    }
+    
+    m_requested.notify_one();
+    m_worker.join();
+    
+    m_document.onDocumentModified().disconnect(m_documentModifiedToken);
+  }
+  
+  void SyntaxHighlighter::setSyntax(const Script& script) {
+    setSyntax(script, nullptr);
+  }
+  
+  void SyntaxHighlighter::setSyntax(const Script& script, std::shared_ptr<const Tokenizer> tokenizer) {
+    if (script.identifier() == m_syntax.identifier() && tokenizer == m_tokenizer) {
+      return;
+    }
+    
+    m_syntax = script;
+    m_tokenizer = tokenizer;
+    m_hasSyntaxChanged = true;
+    m_attributes.clear();
+  }
+  
+  void SyntaxHighlighter::prepare(std::size_t firstRow, std::size_t lastRow) {
+    // Without a syntax, the next one set will be highlighted from scratch.
+    if (m_syntax.identifier().empty() && m_tokenizer == nullptr) {
+      m_changes.clear();
+      return;
+    }
+    
+    if (m_document.rows() == 0) {
+      return;
+    }
+    
+    lastRow = std::min(lastRow, m_document.rows() - 1);
+    firstRow = std::min(firstRow, lastRow);
+    
+    // Nothing needs to be done if these rows of this version of the document have already been
+    // asked for.
+    bool isRequested = m_requestedVersion == m_version && firstRow >= m_requestedFirstRow && lastRow <= m_requestedLastRow;
+    if (isRequested && !m_hasSyntaxChanged) {
+      return;
+    }
+    
+    Request request;
+    request.document = m_document.snapshot();
+    request.changes = std::move(m_changes);
+    request.syntax = m_syntax;
+    request.tokenizer = m_tokenizer;
+    request.hasSyntaxChanged = m_hasSyntaxChanged;
+    request.firstRow = firstRow;
+    request.lastRow = std::min(lastRow + (lastRow - firstRow + 1), m_document.rows() - 1);
+    request.version = m_version;
+    
+    m_changes.clear();
+    m_hasSyntaxChanged = false;
+    m_requestedVersion = m_version;
+    m_requestedFirstRow = request.firstRow;
+    m_requestedLastRow = request.lastRow;
+    
+    {
+      // A request the worker hasn't started yet is replaced, but the changes it carried still
+      // need to be applied.
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_hasRequest) {
+        request.changes.insert(request.changes.begin(), m_request.changes.begin(), m_request.changes.end());
+        request.hasSyntaxChanged = request.hasSyntaxChanged || m_request.hasSyntaxChanged;
+      }
+      
+      m_request = std::move(request);
+      m_hasRequest = true;
+    }
+    
+    m_requested.notify_one();
+  }
+  
+  bool SyntaxHighlighter::poll() {
+    std::shared_ptr<const Results> results;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      results = std::move(m_published);
+      m_published = nullptr;
+    }
+    
+    // Results for an earlier version of the document are discarded, since results for the
+    // current version have been asked for.
+    if (results == nullptr || results->version != m_version) {
+      return false;
+    }
+    
+    for (std::size_t index = 0; index < results->attributes.rows() && results->firstRow + index < m_attributes.rows(); ++index) {
+      AttributeSpan attributes = results->attributes.attributes(index);
+      m_attributes.assign(results->firstRow + index, attributes.begin(), attributes.end());
+    }
+    
+    return true;
+  }
+  
+  void SyntaxHighlighter::wait() {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_idle.wait(lock, [this] () {
+        return !m_hasRequest && !m_isBusy;
+      });
+    }
+    
+    poll();
+  }
+  
+  AttributeSpan SyntaxHighlighter::attributes(std::size_t row) const {
+    return row < m_attributes.rows() ? m_attributes.attributes(row) : AttributeSpan();
+  }
+  
+  void SyntaxHighlighter::onDocumentModified(const DocumentChange& change) {
+    ++m_version;
+    m_changes.emplace_back(change);
+    m_attributes.apply(change);
+  }
+  
+  void SyntaxHighlighter::run() {
+    ScriptHost host(m_rootPath);
+    // The host adds its root path itself.
+    for (const std::string& path : m_scriptPackagePaths) {
+      if (path != m_rootPath) {
+        host.addScriptPackagePath(path);
+      }
+    }
+    
+    for (const std::string& path : m_nativePackagePaths) {
+      host.addNativePackagePath(path);
+    }
+    
+    std::shared_ptr<const Document> document;
+    Script script;
+    std::shared_ptr<const Tokenizer> tokenizer;
+    std::unique_ptr<SyntaxCache> cache;
+    SyntaxCache::RangeParser parser = [&] (std::size_t firstRow, std::size_t lastRow, const std::string& state, std::vector<std::string>& endStates) {
+      if (tokenizer != nullptr) {
+        return tokenizer->tokenizeRange(*document, firstRow, lastRow, state, endStates);
+      }
+      
+      return host.parseSyntaxRange(script, *document, firstRow, lastRow, state, endStates);
+    };
+    
+    for (;;) {
+      Request request;
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_requested.wait(lock, [this] () {
+          return m_isStopping || m_hasRequest;
+        });
+        
+        if (m_isStopping) {
+          return;
+        }
+        
+        request = std::move(m_request);
+        m_hasRequest = false;
+        m_isBusy = true;
+      }
+      
+      // The cache follows the document from one snapshot to the next, unless the syntax changed
+      // and every row needs to be parsed again anyway.
+      document = request.document;
+      if (cache == nullptr || request.hasSyntaxChanged) {
+        script = host.getSyntax(request.syntax.identifier());
+        tokenizer = request.tokenizer;
+        cache = std::make_unique<SyntaxCache>(document->rows(), parser);
+      } else {
+        for (const DocumentChange& change : request.changes) {
+          cache->apply(change);
+        }
+      }
+      
+      // Give up as soon as there's a newer request; it will pick up where this one left off.
+      bool isSuperseded = false;
+      std::size_t target = 0;
+      while (!isSuperseded) {
+        target = std::min(target + WorkerStepSize, request.lastRow);
+        cache->prepare(target);
+        if (target == request.lastRow) {
+          break;
+        }
+        
+        std::lock_guard<std::mutex> lock(m_mutex);
+        isSuperseded = m_hasRequest || m_isStopping;
+      }
+      
+      if (!isSuperseded) {
+        std::shared_ptr<Results> results = std::make_shared<Results>();
+        results->version = request.version;
+        results->firstRow = request.firstRow;
+        results->attributes = AttributeArena(request.lastRow - request.firstRow + 1);
+        for (std::size_t row = request.firstRow; row <= request.lastRow; ++row) {
+          AttributeSpan attributes = cache->attributes(row);
+          results->attributes.assign(row - request.firstRow, attributes.begin(), attributes.end());
+        }
+        
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_published = results;
+      }
+      
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isBusy = false;
+      }
+      
+      m_idle.notify_all();
+    }
+  }
+}
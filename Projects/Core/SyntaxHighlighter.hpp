@@ -0,0 +1,108 @@
+#pragma once
+
+#include "AttributeArena.hpp"
+#include "DocumentChange.hpp"
+#include "Script.hpp"
+#include "Tokenizer.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace quip {
+  struct Document;
+  struct ScriptHost;
+  struct SyntaxCache;
+  
+  // Highlights a document on a worker thread, which runs syntax scripts in a Lua state of its
+  // own so that editing and drawing never wait for them.
+  //
+  // The worker highlights snapshots of the document, following its modifications with a
+  // SyntaxCache, and looks ahead of the rows requested by a viewport's height. Its results are
+  // published as a whole and applied by polling. In the meantime, the attributes of each row
+  // move with the row as the document is modified, and rows that were modified have none.
+  //
+  // Apart from the worker, a highlighter must only be used from the thread that created it.
+  struct SyntaxHighlighter {
+    // The worker's Lua state is configured with the same package paths as the given host.
+    SyntaxHighlighter(Document& document, const ScriptHost& host);
+    ~SyntaxHighlighter();
+    
+    SyntaxHighlighter(const SyntaxHighlighter& other) = delete;
+    SyntaxHighlighter& operator=(const SyntaxHighlighter& other) = delete;
+    
+    void setSyntax(const Script& script);
+    
+    // Highlight with a native tokenizer instead of the script, if one is given.
+    void setSyntax(const Script& script, std::shared_ptr<const Tokenizer> tokenizer);
+    
+    // Ask for the given rows to be highlighted. Never blocks.
+    void prepare(std::size_t firstRow, std::size_t lastRow);
+    
+    // Apply the most recently published results. Returns true if any were applied.
+    bool poll();
+    
+    // Block until the worker has finished every request, then apply its results.
+    void wait();
+    
+    // The attributes of a row, as of the last poll. The span is invalidated by the next poll or
+    // modification of the document.
+    AttributeSpan attributes(std::size_t row) const;
+    
+  private:
+    struct Request {
+      std::shared_ptr<const Document> document;
+      std::vector<DocumentChange> changes;
+      Script syntax;
+      std::shared_ptr<const Tokenizer> tokenizer;
+      bool hasSyntaxChanged;
+      std::size_t firstRow;
+      std::size_t lastRow;
+      std::uint64_t version;
+    };
+    
+    struct Results {
+      std::uint64_t version;
+      std::size_t firstRow;
+      AttributeArena attributes;
+    };
+    
+    Document& m_document;
+    std::uint32_t m_documentModifiedToken;
+    
+    std::string m_rootPath;
+    std::vector<std::string> m_scriptPackagePaths;
+    std::vector<std::string> m_nativePackagePaths;
+    
+    std::mutex m_mutex;
+    std::condition_variable m_requested;
+    std::condition_variable m_idle;
+    
+    // Guarded by the mutex.
+    bool m_isStopping;
+    bool m_hasRequest;
+    bool m_isBusy;
+    Request m_request;
+    std::shared_ptr<const Results> m_published;
+    
+    // Used only by the owning thread. The version counts the document's modifications.
+    AttributeArena m_attributes;
+    std::vector<DocumentChange> m_changes;
+    Script m_syntax;
+    std::shared_ptr<const Tokenizer> m_tokenizer;
+    bool m_hasSyntaxChanged;
+    std::uint64_t m_version;
+    std::uint64_t m_requestedVersion;
+    std::size_t m_requestedFirstRow;
+    std::size_t m_requestedLastRow;
+    
+    std::thread m_worker;
+    
+    void onDocumentModified(const DocumentChange& change);
+    void run();
+  };
+}
@@ -0,0 +1,28 @@
+#include "Tokenizer.hpp"
+
+#include "Document.hpp"
+
+namespace quip {
+  Tokenizer::~Tokenizer() {
+  }
+  
+  std::vector<RowAttributeRange> Tokenizer::tokenizeRange(const Document& document, std::size_t firstRow, std::size_t lastRow, const std::string& state, std::vector<std::string>& endStates) const {
+    std::vector<RowAttributeRange> results;
+    endStates.clear();
+    if (firstRow > lastRow || lastRow >= document.rows()) {
+      return results;
+    }
+    
+    std::vector<AttributeRange> attributes;
+    endStates.reserve(lastRow - firstRow + 1);
+    for (std::size_t row = firstRow; row <= lastRow; ++row) {
+      attributes.clear();
+      endStates.emplace_back(tokenize(document.rowData(row), document.rowLength(row), row == firstRow ? state : endStates.back(), attributes));
+      for (const AttributeRange& attribute : attributes) {
+        results.emplace_back(attribute.attribute, row, attribute.start, attribute.length);
+      }
+    }
+    
+    return results;
+  }
+}
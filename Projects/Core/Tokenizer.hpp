@@ -0,0 +1,29 @@
+#pragma once
+
+#include "AttributeRange.hpp"
+#include "RowAttributeRange.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace quip {
+  struct Document;
+  
+  // Highlights the syntax of a built-in file type natively, producing the same attributes and
+  // states as the file type's syntax script without calling into Lua.
+  //
+  // Tokenizers are immutable, so one can be shared by every thread.
+  struct Tokenizer {
+    virtual ~Tokenizer();
+    
+    // Tokenize a row that begins in the given state, appending its attributes, and return the
+    // state it ends in.
+    virtual std::string tokenize(const char* text, std::size_t length, const std::string& state, std::vector<AttributeRange>& attributes) const = 0;
+    
+    // Tokenize the rows of a document from the first row to the last, inclusive, the first of
+    // which begins in the given state, and store the state each row ends in. This is the native
+    // counterpart to ScriptHost::parseSyntaxRange.
+    std::vector<RowAttributeRange> tokenizeRange(const Document& document, std::size_t firstRow, std::size_t lastRow, const std::string& state, std::vector<std::string>& endStates) const;
+  };
+}
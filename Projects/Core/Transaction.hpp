@@ -3,10 +3,11 @@
 namespace quip {
   struct EditContext;
   
+  // An edit made through an edit context. Transactions record what they change in the
+  // context's undo log as they perform it, so that it can be undone and redone later.
   struct Transaction {
     virtual ~Transaction ();
     
     virtual void perform (EditContext & context) = 0;
-    virtual void rollback (EditContext & context) = 0;
   };
 }
\ No newline at end of file
@@ -0,0 +1,630 @@
+#include "UndoLog.hpp"
+
+#include "Document.hpp"
+#include "Location.hpp"
+#include "Selection.hpp"
+#include "SelectionSet.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+  // The default capacity of a history, in bytes.
+  const std::size_t DefaultCapacity = 16 * 1024 * 1024;
+  
+  // A snapshot of the document is kept after every step this many steps down a branch.
+  const std::size_t CheckpointInterval = 64;
+  
+  // Each operation in a step begins with a tag; the last is followed by an end tag.
+  const std::uint8_t EndTag = 0;
+  const std::uint8_t InsertionTag = 1;
+  const std::uint8_t ErasureTag = 2;
+  
+  // Integers are written seven bits at a time, low bits first, with the high bit of each byte
+  // set if more bytes follow. Signed integers are interleaved so that small magnitudes of
+  // either sign stay short.
+  void writeVarint(std::vector<std::uint8_t>& bytes, std::uint64_t value) {
+    while (value >= 0x80) {
+      bytes.push_back(static_cast<std::uint8_t>(value | 0x80));
+      value >>= 7;
+    }
+    
+    bytes.push_back(static_cast<std::uint8_t>(value));
+  }
+  
+  void writeSignedVarint(std::vector<std::uint8_t>& bytes, std::int64_t value) {
+    writeVarint(bytes, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+  }
+  
+  std::uint64_t readVarint(const std::uint8_t*& cursor) {
+    std::uint64_t value = 0;
+    for (unsigned shift = 0; ; shift += 7) {
+      std::uint8_t byte = *cursor++;
+      value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+  }
+  
+  std::int64_t readSignedVarint(const std::uint8_t*& cursor) {
+    std::uint64_t value = readVarint(cursor);
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+  }
+  
+  // Selections are written in order, each row relative to the row before it.
+  void writeSelections(std::vector<std::uint8_t>& bytes, const quip::SelectionSet& selections) {
+    writeVarint(bytes, selections.count());
+    if (selections.count() == 0) {
+      return;
+    }
+    
+    writeVarint(bytes, &selections.primary() - &selections[0]);
+    
+    std::uint64_t previousRow = 0;
+    for (const quip::Selection& selection : selections) {
+      writeSignedVarint(bytes, selection.origin().row() - previousRow);
+      writeVarint(bytes, selection.origin().column());
+      writeSignedVarint(bytes, selection.extent().row() - selection.origin().row());
+      writeVarint(bytes, selection.extent().column());
+      previousRow = selection.extent().row();
+    }
+  }
+  
+  quip::SelectionSet readSelections(const std::uint8_t*& cursor) {
+    std::uint64_t count = readVarint(cursor);
+    if (count == 0) {
+      return quip::SelectionSet();
+    }
+    
+    std::uint64_t primary = readVarint(cursor);
+    
+    std::vector<quip::Selection> selections;
+    selections.reserve(count);
+    
+    std::uint64_t previousRow = 0;
+    for (std::uint64_t index = 0; index < count; ++index) {
+      std::uint64_t originRow = previousRow + readSignedVarint(cursor);
+      std::uint64_t originColumn = readVarint(cursor);
+      std::uint64_t extentRow = originRow + readSignedVarint(cursor);
+      std::uint64_t extentColumn = readVarint(cursor);
+      selections.emplace_back(quip::Location(originColumn, originRow), quip::Location(extentColumn, extentRow));
+      previousRow = extentRow;
+    }
+    
+    quip::SelectionSet result(selections);
+    for (std::uint64_t index = 0; index < primary; ++index) {
+      result.rotateForward();
+    }
+    
+    return result;
+  }
+  
+  // The location just past text inserted at the given location.
+  quip::Location locationAfter(const quip::Location& location, const char* text, std::size_t length) {
+    std::uint64_t column = location.column();
+    std::uint64_t row = location.row();
+    for (std::size_t index = 0; index < length; ++index) {
+      if (text[index] == '\n') {
+        column = 0;
+        ++row;
+      } else {
+        ++column;
+      }
+    }
+    
+    return quip::Location(column, row);
+  }
+  
+  // The location of the last character of text inserted at the given location.
+  quip::Location locationOfLastCharacter(const quip::Location& location, const char* text, std::size_t length) {
+    return locationAfter(location, text, length - 1);
+  }
+}
+
+namespace quip {
+  const std::size_t UndoLog::NoStep = std::numeric_limits<std::size_t>::max();
+  
+  UndoLog::UndoLog()
+  : UndoLog(DefaultCapacity) {
+  }
+  
+  UndoLog::UndoLog(std::size_t capacity)
+  : m_capacity(capacity)
+  , m_head(0)
+  , m_firstStep(0)
+  , m_current(NoStep)
+  , m_depth(0)
+  , m_rootRedoChild(NoStep)
+  , m_checkpointFootprint(0)
+  , m_isRecording(false)
+  , m_canResume(false)
+  , m_operations(0)
+  , m_previousRow(0)
+  , m_lastOperation(0)
+  , m_lastOperationRow(0)
+  , m_hasPendingOperation(false)
+  , m_isPendingInsertion(false)
+  , m_pendingColumn(0)
+  , m_pendingRow(0) {
+  }
+  
+  std::size_t UndoLog::capacity() const {
+    return m_capacity;
+  }
+  
+  void UndoLog::setCapacity(std::size_t capacity) {
+    m_capacity = capacity;
+    if (!m_isRecording) {
+      evict();
+    }
+  }
+  
+  std::size_t UndoLog::footprint() const {
+    return m_bytes.size() - m_head + m_steps.size() * sizeof(Step) + m_checkpointFootprint;
+  }
+  
+  std::size_t UndoLog::steps() const {
+    return m_steps.size();
+  }
+  
+  void UndoLog::beginStep(const SelectionSet& selections) {
+    if (m_isRecording) {
+      return;
+    }
+    
+    m_steps.push_back(Step{m_bytes.size(), m_current, NoStep, m_depth + 1, Clock::time_point()});
+    m_isRecording = true;
+    m_canResume = false;
+    m_operations = 0;
+    m_previousRow = 0;
+    
+    writeSelections(m_bytes, selections);
+  }
+  
+  void UndoLog::recordInsertion(const Document& document, const SelectionSet& selections, const std::vector<std::string>& text) {
+    if (!m_isRecording) {
+      return;
+    }
+    
+    std::size_t count = std::min<std::size_t>(selections.count(), text.size());
+    if (document.isEmpty()) {
+      // Only the first text is inserted into an empty document, wherever the selections are.
+      for (std::size_t index = 0; index < count; ++index) {
+        if (!text[index].empty()) {
+          record(true, Location(0, 0), text[index].data(), text[index].size());
+          break;
+        }
+      }
+      
+      return;
+    }
+    
+    // The insertions are recorded from last to first, so that each location is still valid
+    // once the insertions recorded before it have been replayed.
+    for (std::size_t index = count; index > 0; --index) {
+      const std::string& insertion = text[index - 1];
+      if (!insertion.empty()) {
+        record(true, selections[index - 1].origin(), insertion.data(), insertion.size());
+      }
+    }
+  }
+  
+  void UndoLog::recordErasure(const Document& document, const SelectionSet& selections) {
+    if (!m_isRecording || document.isEmpty()) {
+      return;
+    }
+    
+    // As with insertions, the erasures are recorded from last to first. The erased text is
+    // copied straight out of the document's rows.
+    for (std::size_t index = selections.count(); index > 0; --index) {
+      Location origin = selections[index - 1].origin();
+      Location extent = selections[index - 1].extent();
+      if (extent.row() >= document.rows()) {
+        continue;
+      }
+      
+      m_erasedText.clear();
+      for (std::size_t row = origin.row(); row <= extent.row(); ++row) {
+        std::size_t first = row == origin.row() ? origin.column() : 0;
+        std::size_t last = row == extent.row() ? std::min<std::size_t>(extent.column() + 1, document.rowLength(row)) : document.rowLength(row);
+        if (last > first) {
+          m_erasedText.append(document.rowData(row) + first, last - first);
+        }
+      }
+      
+      record(false, origin, m_erasedText.data(), m_erasedText.size());
+    }
+  }
+  
+  void UndoLog::endStep(const Document& document, const SelectionSet& selections) {
+    if (!m_isRecording) {
+      return;
+    }
+    
+    writePendingOperation();
+    
+    m_isRecording = false;
+    std::size_t step = m_firstStep + m_steps.size() - 1;
+    if (m_operations == 0) {
+      // A resumed step that's dropped may be the one redo would have moved to, and its
+      // identifier will be given to the next step.
+      if (redoChild() == step) {
+        setRedoChild(m_current, NoStep);
+      }
+      
+      eraseCheckpoint(step);
+      m_bytes.resize(m_steps.back().offset);
+      m_steps.pop_back();
+      return;
+    }
+    
+    m_bytes.push_back(EndTag);
+    writeSelections(m_bytes, selections);
+    
+    Step& finished = m_steps.back();
+    finished.time = Clock::now();
+    setRedoChild(finished.parent, step);
+    m_current = step;
+    m_depth = finished.depth;
+    if (finished.depth % CheckpointInterval == 0) {
+      addCheckpoint(step, document);
+    }
+    
+    m_canResume = true;
+    evict();
+  }
+  
+  bool UndoLog::resumeStep() {
+    if (m_isRecording || !m_canResume || m_current != m_firstStep + m_steps.size() - 1) {
+      return false;
+    }
+    
+    // The step's last operation becomes pending again, and everything after it is dropped so
+    // that the step can be written out again when it ends.
+    std::size_t start = m_steps.back().offset + m_lastOperation;
+    const std::uint8_t* cursor = m_bytes.data() + start;
+    m_isPendingInsertion = *cursor++ == InsertionTag;
+    m_pendingRow = m_lastOperationRow + readSignedVarint(cursor);
+    m_pendingColumn = readVarint(cursor);
+    std::size_t length = readVarint(cursor);
+    m_pendingText.assign(reinterpret_cast<const char*>(cursor), length);
+    m_hasPendingOperation = true;
+    
+    m_bytes.resize(start);
+    m_previousRow = m_lastOperationRow;
+    --m_operations;
+    m_current = m_steps.back().parent;
+    m_depth = m_steps.back().depth - 1;
+    
+    m_isRecording = true;
+    m_canResume = false;
+    return true;
+  }
+  
+  bool UndoLog::isRecording() const {
+    return m_isRecording;
+  }
+  
+  bool UndoLog::canUndo() const {
+    return !m_isRecording && isRetained(m_current);
+  }
+  
+  bool UndoLog::canRedo() const {
+    return !m_isRecording && isRetained(redoChild());
+  }
+  
+  bool UndoLog::undo(Document& document, SelectionSet& selections) {
+    if (!canUndo()) {
+      return false;
+    }
+    
+    std::size_t step = m_current;
+    apply(document, step, false, selections);
+    
+    m_current = stepAt(step).parent;
+    m_depth = stepAt(step).depth - 1;
+    setRedoChild(m_current, step);
+    m_canResume = false;
+    return true;
+  }
+  
+  bool UndoLog::redo(Document& document, SelectionSet& selections) {
+    if (!canRedo()) {
+      return false;
+    }
+    
+    std::size_t step = redoChild();
+    apply(document, step, true, selections);
+    
+    m_current = step;
+    m_depth = stepAt(step).depth;
+    m_canResume = false;
+    return true;
+  }
+  
+  std::size_t UndoLog::currentStep() const {
+    return m_current;
+  }
+  
+  std::size_t UndoLog::findStep(Clock::time_point time) const {
+    // Steps are finished in the order they're made, so their times are in order too, except
+    // for the one being recorded.
+    std::deque<Step>::const_iterator end = m_isRecording ? m_steps.end() - 1 : m_steps.end();
+    std::deque<Step>::const_iterator cursor = std::upper_bound(m_steps.begin(), end, time, [] (Clock::time_point time, const Step& step) {
+      return time < step.time;
+    });
+    
+    return cursor == m_steps.begin() ? NoStep : m_firstStep + (cursor - m_steps.begin()) - 1;
+  }
+  
+  bool UndoLog::travel(Document& document, SelectionSet& selections, std::size_t step) {
+    if (m_isRecording || !isRetained(step)) {
+      return false;
+    }
+    
+    // Walk up from the step to the current one or to the nearest checkpoint, whichever comes
+    // first, collecting the steps to replay on the way.
+    std::vector<std::size_t> replayed;
+    std::size_t base = step;
+    while (isRetained(base) && base != m_current && m_checkpoints.count(base) == 0) {
+      replayed.push_back(base);
+      base = stepAt(base).parent;
+    }
+    
+    if (base != m_current) {
+      // Undoing from the current step up to the step the two branches share, and redoing down
+      // from there, may take fewer steps than replaying from the checkpoint, if there is one.
+      bool hasCheckpoint = isRetained(base);
+      std::size_t limit = hasCheckpoint ? replayed.size() : std::numeric_limits<std::size_t>::max();
+      
+      std::vector<std::size_t> undone;
+      std::vector<std::size_t> redone;
+      std::size_t from = m_current;
+      std::size_t fromDepth = m_depth;
+      std::size_t to = step;
+      std::size_t toDepth = stepAt(step).depth;
+      while (from != to && undone.size() + redone.size() < limit) {
+        if (fromDepth >= toDepth && isRetained(from)) {
+          undone.push_back(from);
+          from = stepAt(from).parent;
+          --fromDepth;
+        } else if (fromDepth < toDepth && isRetained(to)) {
+          redone.push_back(to);
+          to = stepAt(to).parent;
+          --toDepth;
+        } else {
+          break;
+        }
+      }
+      
+      if (from == to) {
+        for (std::size_t undoneStep : undone) {
+          apply(document, undoneStep, false, selections);
+          setRedoChild(stepAt(undoneStep).parent, undoneStep);
+        }
+        
+        replayed = redone;
+      } else if (hasCheckpoint) {
+        document.restore(*m_checkpoints[base].document);
+      } else {
+        return false;
+      }
+    }
+    
+    // Redo follows the branch that was travelled down.
+    for (auto cursor = replayed.rbegin(); cursor != replayed.rend(); ++cursor) {
+      apply(document, *cursor, true, selections);
+      setRedoChild(stepAt(*cursor).parent, *cursor);
+    }
+    
+    SelectionSet before;
+    std::vector<Operation> operations;
+    decodeStep(step, before, operations, selections);
+    
+    m_current = step;
+    m_depth = stepAt(step).depth;
+    m_canResume = false;
+    return true;
+  }
+  
+  void UndoLog::record(bool isInsertion, const Location& location, const char* text, std::size_t length) {
+    if (m_hasPendingOperation) {
+      Location pending(m_pendingColumn, m_pendingRow);
+      if (m_isPendingInsertion && isInsertion) {
+        // Text inserted right after the pending insertion extends it.
+        if (location == locationAfter(pending, m_pendingText.data(), m_pendingText.size())) {
+          m_pendingText.append(text, length);
+          return;
+        }
+      } else if (m_isPendingInsertion) {
+        // Erasing the end of the pending insertion shortens it, and erasing all of it leaves
+        // nothing to record at all.
+        std::size_t remaining = m_pendingText.size() - std::min(length, m_pendingText.size());
+        if (length <= m_pendingText.size() && m_pendingText.compare(remaining, length, text, length) == 0 && location == locationAfter(pending, m_pendingText.data(), remaining)) {
+          m_pendingText.resize(remaining);
+          m_hasPendingOperation = !m_pendingText.empty();
+          return;
+        }
+      } else if (!isInsertion) {
+        // Erasing the text just before the pending erasure, or the text that took its place,
+        // extends it.
+        if (locationAfter(location, text, length) == pending) {
+          m_pendingText.insert(0, text, length);
+          m_pendingColumn = location.column();
+          m_pendingRow = location.row();
+          return;
+        }
+        
+        if (location == pending) {
+          m_pendingText.append(text, length);
+          return;
+        }
+      }
+      
+      writePendingOperation();
+    }
+    
+    m_hasPendingOperation = true;
+    m_isPendingInsertion = isInsertion;
+    m_pendingColumn = location.column();
+    m_pendingRow = location.row();
+    m_pendingText.assign(text, length);
+  }
+  
+  void UndoLog::writePendingOperation() {
+    if (!m_hasPendingOperation) {
+      return;
+    }
+    
+    m_lastOperation = m_bytes.size() - m_steps.back().offset;
+    m_lastOperationRow = m_previousRow;
+    
+    m_bytes.push_back(m_isPendingInsertion ? InsertionTag : ErasureTag);
+    writeSignedVarint(m_bytes, m_pendingRow - m_previousRow);
+    writeVarint(m_bytes, m_pendingColumn);
+    writeVarint(m_bytes, m_pendingText.size());
+    m_bytes.insert(m_bytes.end(), m_pendingText.begin(), m_pendingText.end());
+    
+    m_previousRow = m_pendingRow;
+    m_hasPendingOperation = false;
+    ++m_operations;
+  }
+  
+  bool UndoLog::isRetained(std::size_t step) const {
+    return step != NoStep && step >= m_firstStep && step - m_firstStep < m_steps.size();
+  }
+  
+  UndoLog::Step& UndoLog::stepAt(std::size_t step) {
+    return m_steps[step - m_firstStep];
+  }
+  
+  const UndoLog::Step& UndoLog::stepAt(std::size_t step) const {
+    return m_steps[step - m_firstStep];
+  }
+  
+  std::size_t UndoLog::redoChild() const {
+    return isRetained(m_current) ? stepAt(m_current).redoChild : m_rootRedoChild;
+  }
+  
+  void UndoLog::setRedoChild(std::size_t parent, std::size_t child) {
+    // A step that isn't in the history can only be reached by undoing, so there's only ever
+    // one of them to remember a child for.
+    if (isRetained(parent)) {
+      stepAt(parent).redoChild = child;
+    } else {
+      m_rootRedoChild = child;
+    }
+  }
+  
+  void UndoLog::decodeStep(std::size_t step, SelectionSet& before, std::vector<Operation>& operations, SelectionSet& after) const {
+    const std::uint8_t* cursor = m_bytes.data() + stepAt(step).offset;
+    before = readSelections(cursor);
+    
+    std::uint64_t row = 0;
+    for (std::uint8_t tag = *cursor++; tag != EndTag; tag = *cursor++) {
+      row += readSignedVarint(cursor);
+      std::uint64_t column = readVarint(cursor);
+      std::size_t length = readVarint(cursor);
+      operations.push_back(Operation{tag == InsertionTag, column, row, reinterpret_cast<const char*>(cursor), length});
+      cursor += length;
+    }
+    
+    after = readSelections(cursor);
+  }
+  
+  void UndoLog::apply(Document& document, std::size_t step, bool isForward, SelectionSet& selections) const {
+    SelectionSet before;
+    SelectionSet after;
+    std::vector<Operation> operations;
+    decodeStep(step, before, operations, after);
+    
+    if (isForward) {
+      for (const Operation& operation : operations) {
+        Location location(operation.column, operation.row);
+        if (operation.isInsertion) {
+          document.insert(Selection(location), std::string(operation.text, operation.length));
+        } else {
+          document.erase(Selection(location, locationOfLastCharacter(location, operation.text, operation.length)));
+        }
+      }
+      
+      selections = after;
+    } else {
+      // Each operation is reversed in turn, starting with the last.
+      for (auto cursor = operations.rbegin(); cursor != operations.rend(); ++cursor) {
+        Location location(cursor->column, cursor->row);
+        if (cursor->isInsertion) {
+          document.erase(Selection(location, locationOfLastCharacter(location, cursor->text, cursor->length)));
+        } else {
+          document.insert(Selection(location), std::string(cursor->text, cursor->length));
+        }
+      }
+      
+      selections = before;
+    }
+  }
+  
+  void UndoLog::addCheckpoint(std::size_t step, const Document& document) {
+    // A new checkpoint shares every chunk with the document, but keeps its own index of them
+    // once the document is next edited. The checkpoint before it is left holding the chunks
+    // changed between the two, which neither the document nor the new checkpoint has, so its
+    // estimate is brought up to date.
+    Checkpoint checkpoint { document.snapshot(), 0 };
+    checkpoint.footprint = checkpoint.document->unsharedFootprint(document);
+    if (!m_checkpoints.empty()) {
+      Checkpoint& previous = m_checkpoints.rbegin()->second;
+      m_checkpointFootprint -= previous.footprint;
+      previous.footprint = previous.document->unsharedFootprint(*checkpoint.document);
+      m_checkpointFootprint += previous.footprint;
+    }
+    
+    m_checkpointFootprint += checkpoint.footprint;
+    m_checkpoints[step] = checkpoint;
+  }
+  
+  void UndoLog::eraseCheckpoint(std::size_t step) {
+    auto checkpoint = m_checkpoints.find(step);
+    if (checkpoint != m_checkpoints.end()) {
+      m_checkpointFootprint -= checkpoint->second.footprint;
+      m_checkpoints.erase(checkpoint);
+    }
+  }
+  
+  void UndoLog::evict() {
+    // The oldest steps are evicted first, whichever branch they're on. Their children remain,
+    // and can still be reached by travelling to them from a checkpoint.
+    while (m_steps.size() > 1 && footprint() > m_capacity) {
+      if (m_current == m_firstStep) {
+        m_rootRedoChild = m_steps.front().redoChild;
+      }
+      
+      eraseCheckpoint(m_firstStep);
+      m_steps.pop_front();
+      ++m_firstStep;
+      m_head = m_steps.front().offset;
+    }
+    
+    // The newest step is always kept, but its checkpoint is only a shortcut for travelling to
+    // steps that were evicted, and goes if it doesn't fit.
+    if (footprint() > m_capacity) {
+      eraseCheckpoint(m_firstStep);
+    }
+    
+    if (m_steps.empty()) {
+      m_bytes.clear();
+      m_head = 0;
+    }
+    
+    // The space of evicted steps is reclaimed once there's at least as much of it as there is
+    // of the steps that remain.
+    if (m_head > 0 && m_head >= m_bytes.size() - m_head) {
+      m_bytes.erase(m_bytes.begin(), m_bytes.begin() + m_head);
+      for (Step& step : m_steps) {
+        step.offset -= m_head;
+      }
+      
+      m_head = 0;
+    }
+  }
+}
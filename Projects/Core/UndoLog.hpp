@@ -0,0 +1,179 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace quip {
+  struct Document;
+  struct Location;
+  struct SelectionSet;
+  
+  // A bounded history of the edits made to a document, for undoing and redoing them.
+  //
+  // Each step of history is a run of bytes in a single buffer: the selections before the step,
+  // the operations it made, and the selections after it. Operations are the insertion or
+  // erasure of text at a location, recorded in the order they can be replayed one after
+  // another; locations and lengths are stored as variable-length integers, and the text itself
+  // is stored inline. When the history grows past its capacity, the oldest steps are evicted.
+  //
+  // An operation that continues the one before it, such as typing the next character or
+  // erasing the previous one, is merged into it, so that a run of typing is a single operation.
+  //
+  // History is a tree rather than a line: a step made after others were undone starts a new
+  // branch instead of discarding them, and redoing follows the branch visited last. Every so
+  // many steps down a branch, a snapshot of the document is kept as a checkpoint. Snapshots
+  // share all but the changed chunks of rows with the document, so jumping to any step costs
+  // the difference from its nearest checkpoint plus a few steps of replay, however far away it
+  // is in time.
+  struct UndoLog {
+    typedef std::chrono::steady_clock Clock;
+    
+    // Identifies a step for as long as it's in the history. NoStep stands for the state of the
+    // document before any step was made.
+    static const std::size_t NoStep;
+    
+    UndoLog();
+    explicit UndoLog(std::size_t capacity);
+    
+    UndoLog(const UndoLog& other) = delete;
+    UndoLog& operator=(const UndoLog& other) = delete;
+    
+    // The number of bytes the history may use before the oldest steps are evicted. The newest
+    // step is always kept, whatever its size.
+    std::size_t capacity() const;
+    void setCapacity(std::size_t capacity);
+    
+    // The number of bytes the history currently uses, and the number of steps in it. The
+    // snapshots kept as checkpoints share their text with the document, but each also keeps
+    // its own index of rows, and the chunks of rows changed after it was taken, which are
+    // counted.
+    std::size_t footprint() const;
+    std::size_t steps() const;
+    
+    // Begin recording a step, given the selections as they are before it. The step becomes a
+    // child of the current one.
+    void beginStep(const SelectionSet& selections);
+    
+    // Record inserting each text at the origin of the selection with the same index. Must be
+    // called before the text is inserted.
+    void recordInsertion(const Document& document, const SelectionSet& selections, const std::vector<std::string>& text);
+    
+    // Record erasing the text covered by the selections. Must be called before the text is
+    // erased.
+    void recordErasure(const Document& document, const SelectionSet& selections);
+    
+    // Finish recording the step, given the document and selections as they are after it. A
+    // step that recorded no operations is dropped.
+    void endStep(const Document& document, const SelectionSet& selections);
+    
+    // Resume recording the step that was finished last, so that what's recorded next becomes
+    // part of it. Returns false, without recording anything, if that step was dropped or has
+    // since been undone.
+    bool resumeStep();
+    
+    bool isRecording() const;
+    
+    bool canUndo() const;
+    bool canRedo() const;
+    
+    // Undo or redo a step, modifying the document and restoring the selections as they were
+    // before or after it. Return false if there was nothing to undo or redo.
+    bool undo(Document& document, SelectionSet& selections);
+    bool redo(Document& document, SelectionSet& selections);
+    
+    // The step the document is currently at, which is the one undo would undo.
+    std::size_t currentStep() const;
+    
+    // The newest step finished at or before the given time, or NoStep if there is none.
+    std::size_t findStep(Clock::time_point time) const;
+    
+    // Bring the document and selections to the state they were in just after the given step,
+    // on whichever branch it is. Returns false if the step isn't in the history, or if the
+    // state can no longer be reached because the steps leading to it were evicted.
+    bool travel(Document& document, SelectionSet& selections, std::size_t step);
+    
+  private:
+    struct Operation {
+      bool isInsertion;
+      std::uint64_t column;
+      std::uint64_t row;
+      const char* text;
+      std::size_t length;
+    };
+    
+    struct Step {
+      std::size_t offset;
+      std::size_t parent;
+      std::size_t redoChild;
+      std::size_t depth;
+      Clock::time_point time;
+    };
+    
+    std::size_t m_capacity;
+    
+    // Steps are stored one after another, in the order they were made, starting at the head of
+    // the buffer. The first step in the list is identified by m_firstStep, and the rest follow
+    // it. Undoing the current step moves to its parent, which may have been evicted already.
+    std::vector<std::uint8_t> m_bytes;
+    std::size_t m_head;
+    std::deque<Step> m_steps;
+    std::size_t m_firstStep;
+    std::size_t m_current;
+    std::size_t m_depth;
+    
+    // The step redo moves to when the current one isn't in the history.
+    std::size_t m_rootRedoChild;
+    
+    // Snapshots of the document just after each step whose depth is a multiple of the interval,
+    // along with an estimate of the memory each keeps alive apart from the document.
+    struct Checkpoint {
+      std::shared_ptr<const Document> document;
+      std::size_t footprint;
+    };
+    
+    std::map<std::size_t, Checkpoint> m_checkpoints;
+    std::size_t m_checkpointFootprint;
+    
+    bool m_isRecording;
+    bool m_canResume;
+    std::size_t m_operations;
+    std::uint64_t m_previousRow;
+    
+    // Where the last operation of the newest step starts, relative to the step, and the row its
+    // own row is relative to.
+    std::size_t m_lastOperation;
+    std::uint64_t m_lastOperationRow;
+    
+    // The operation recorded last is held back until the step ends, in case the next one can be
+    // merged into it.
+    bool m_hasPendingOperation;
+    bool m_isPendingInsertion;
+    std::uint64_t m_pendingColumn;
+    std::uint64_t m_pendingRow;
+    std::string m_pendingText;
+    std::string m_erasedText;
+    
+    void record(bool isInsertion, const Location& location, const char* text, std::size_t length);
+    void writePendingOperation();
+    
+    bool isRetained(std::size_t step) const;
+    Step& stepAt(std::size_t step);
+    const Step& stepAt(std::size_t step) const;
+    
+    std::size_t redoChild() const;
+    void setRedoChild(std::size_t parent, std::size_t child);
+    
+    void decodeStep(std::size_t step, SelectionSet& before, std::vector<Operation>& operations, SelectionSet& after) const;
+    void apply(Document& document, std::size_t step, bool isForward, SelectionSet& selections) const;
+    
+    void addCheckpoint(std::size_t step, const Document& document);
+    void eraseCheckpoint(std::size_t step);
+    void evict();
+  };
+}
@@ -0,0 +1,174 @@
+#include "ViewportModel.hpp"
+
+#include "Document.hpp"
+#include "DrawingService.hpp"
+#include "Rectangle.hpp"
+#include "SelectionDrawInfo.hpp"
+#include "SelectionSet.hpp"
+#include "SyntaxHighlighter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+
+namespace quip {
+  ViewportModel::ViewportModel()
+  : m_rows(0)
+  , m_scrollOffset(0.0f)
+  , m_height(0.0f) {
+  }
+  
+  Extent ViewportModel::cellSize() const {
+    return m_cellSize;
+  }
+  
+  void ViewportModel::setCellSize(const Extent& size) {
+    m_cellSize = size;
+  }
+  
+  std::size_t ViewportModel::rows() const {
+    return m_rows;
+  }
+  
+  void ViewportModel::setRows(std::size_t rows) {
+    m_rows = rows;
+  }
+  
+  float ViewportModel::scrollOffset() const {
+    return m_scrollOffset;
+  }
+  
+  float ViewportModel::height() const {
+    return m_height;
+  }
+  
+  void ViewportModel::setViewport(float scrollOffset, float height) {
+    m_scrollOffset = std::max(scrollOffset, 0.0f);
+    m_height = std::max(height, 0.0f);
+  }
+  
+  bool ViewportModel::hasVisibleRows() const {
+    std::size_t firstRow = 0;
+    std::size_t lastRow = 0;
+    return findRows(m_scrollOffset, m_scrollOffset + m_height, firstRow, lastRow);
+  }
+  
+  std::size_t ViewportModel::firstVisibleRow() const {
+    std::size_t firstRow = 0;
+    std::size_t lastRow = 0;
+    findRows(m_scrollOffset, m_scrollOffset + m_height, firstRow, lastRow);
+    return firstRow;
+  }
+  
+  std::size_t ViewportModel::lastVisibleRow() const {
+    std::size_t firstRow = 0;
+    std::size_t lastRow = 0;
+    findRows(m_scrollOffset, m_scrollOffset + m_height, firstRow, lastRow);
+    return lastRow;
+  }
+  
+  bool ViewportModel::findRows(float top, float bottom, std::size_t& firstRow, std::size_t& lastRow) const {
+    // The band is clipped to the viewport, and a row is only within it if it overlaps it rather
+    // than merely touching one of its edges.
+    top = std::max(top, m_scrollOffset);
+    bottom = std::min(bottom, m_scrollOffset + m_height);
+    if (m_rows == 0 || m_cellSize.height() <= 0.0f || bottom <= top) {
+      return false;
+    }
+    
+    float first = std::floor(top / m_cellSize.height());
+    if (first >= m_rows) {
+      return false;
+    }
+    
+    float last = std::ceil(bottom / m_cellSize.height()) - 1.0f;
+    firstRow = static_cast<std::size_t>(first);
+    lastRow = std::min(static_cast<std::size_t>(std::max(last, first)), m_rows - 1);
+    return true;
+  }
+  
+  void ViewportModel::drawText(DrawingService& service, const Document& document, const SyntaxHighlighter& highlighter, const Rectangle& frame, float top, float bottom) const {
+    std::size_t firstRow = 0;
+    std::size_t lastRow = 0;
+    if (!findRows(top, bottom, firstRow, lastRow)) {
+      return;
+    }
+    
+    // Rows are copied into one buffer rather than each into a string of its own.
+    std::string text;
+    for (std::size_t row = firstRow; row <= lastRow && row < document.rows(); ++row) {
+      text.assign(document.rowData(row), document.rowLength(row));
+      service.drawText(text, service.coordinateForLocationInFrame(Location(0, row), frame), highlighter.attributes(row));
+    }
+  }
+  
+  void ViewportModel::drawSelections(DrawingService& service, const Document& document, const SelectionDrawInfo& drawInfo, const Rectangle& frame, bool isCursorShown) const {
+    if (!isCursorShown && (drawInfo.flags & CursorFlags::Blink) != 0) {
+      return;
+    }
+    
+    // Rows out of view are skipped, so a selection of the whole document costs no more to draw
+    // than one of a single row. Without any rows in view, there may still be a cursor to draw.
+    std::size_t firstVisibleRow = 0;
+    std::size_t lastVisibleRow = std::numeric_limits<std::size_t>::max();
+    if (hasVisibleRows()) {
+      firstVisibleRow = this->firstVisibleRow();
+      lastVisibleRow = this->lastVisibleRow();
+    }
+    
+    // The selections are sorted and don't overlap, so the first one to reach the visible rows is
+    // found by bisection, and drawing stops at the first one that starts below them.
+    const SelectionSet& selections = drawInfo.selections;
+    std::size_t firstIndex = 0;
+    std::size_t endIndex = selections.count();
+    while (firstIndex < endIndex) {
+      std::size_t middle = firstIndex + (endIndex - firstIndex) / 2;
+      if (selections[middle].extent().row() < firstVisibleRow) {
+        firstIndex = middle + 1;
+      } else {
+        endIndex = middle;
+      }
+    }
+    
+    for (std::size_t index = firstIndex; index < selections.count() && selections[index].origin().row() <= lastVisibleRow; ++index) {
+      const Selection& selection = selections[index];
+      const Location& lower = selection.origin();
+      const Location& upper = selection.extent();
+      std::size_t lastRow = std::min<std::size_t>(upper.row(), lastVisibleRow);
+      const Color& color = selection == selections.primary() ? drawInfo.primaryColor : drawInfo.secondaryColor;
+      
+      for (std::size_t row = std::max<std::size_t>(lower.row(), firstVisibleRow); row <= lastRow; ++row) {
+        std::size_t firstColumn = row == lower.row() ? lower.column() : 0;
+        std::size_t lastColumn = row == upper.row() ? upper.column() : document.rowLength(row) - 1;
+        
+        Coordinate coordinate = service.coordinateForLocationInFrame(Location(firstColumn, row), frame);
+        float width = m_cellSize.width() * (lastColumn + 1 - firstColumn);
+        float heightFactor = row > lower.row() ? 1.0f : 0.75f;
+        
+        switch (drawInfo.style) {
+          case CursorStyle::VerticalBlock:
+            service.fillRectangle(Rectangle(coordinate.x, coordinate.y - 2.0f, width, heightFactor * m_cellSize.height()), color);
+            break;
+          case CursorStyle::VerticalBlockHalf:
+            service.fillRectangle(Rectangle(coordinate.x, coordinate.y - 2.0f, width, 0.25f * m_cellSize.height()), color);
+            break;
+          case CursorStyle::VerticalBarAtOrigin:
+            service.drawBarBefore(Location(firstColumn, row), color, frame);
+            break;
+          case CursorStyle::VerticalBarAtExtent:
+            if (document.isEmpty() || document.rowLength(row) == 0) {
+              service.drawBarBefore(Location(lastColumn, row), color, frame);
+            } else {
+              service.drawBarAfter(Location(lastColumn, row), color, frame);
+            }
+            break;
+          case CursorStyle::Underline:
+          default:
+            service.drawUnderline(row, firstColumn, lastColumn, color, frame);
+            break;
+        }
+      }
+    }
+  }
+}
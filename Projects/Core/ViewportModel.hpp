@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Extent.hpp"
+
+#include <cstddef>
+
+namespace quip {
+  struct Document;
+  struct DrawingService;
+  struct Rectangle;
+  struct SelectionDrawInfo;
+  struct SyntaxHighlighter;
+  
+  // Maps the scroll position of a view onto the rows of its document, so that drawing and
+  // highlighting visit only the rows that can be seen, however long the document is.
+  //
+  // Offsets are measured down from the top of the document, in the same units as the cell size.
+  struct ViewportModel {
+    ViewportModel();
+    
+    Extent cellSize() const;
+    void setCellSize(const Extent& size);
+    
+    std::size_t rows() const;
+    void setRows(std::size_t rows);
+    
+    // How far the top of the viewport is below the top of the document, and how tall it is.
+    float scrollOffset() const;
+    float height() const;
+    void setViewport(float scrollOffset, float height);
+    
+    // Whether any row is at least partly in view. The visible rows are only meaningful if so.
+    bool hasVisibleRows() const;
+    std::size_t firstVisibleRow() const;
+    std::size_t lastVisibleRow() const;
+    
+    // Find the rows at least partly within the part of the given band of the document that is in
+    // view. Returns false if there are none.
+    bool findRows(float top, float bottom, std::size_t& firstRow, std::size_t& lastRow) const;
+    
+    // Draw the text of the rows found within the given band, placing each row where the drawing
+    // service places its locations in the given frame.
+    void drawText(DrawingService& service, const Document& document, const SyntaxHighlighter& highlighter, const Rectangle& frame, float top, float bottom) const;
+    
+    // Draw the visible rows of a set of selections in their cursor style, placing them as text
+    // is placed. Cursors that blink are only drawn if they're currently shown.
+    void drawSelections(DrawingService& service, const Document& document, const SelectionDrawInfo& drawInfo, const Rectangle& frame, bool isCursorShown) const;
+    
+  private:
+    Extent m_cellSize;
+    std::size_t m_rows;
+    float m_scrollOffset;
+    float m_height;
+  };
+}
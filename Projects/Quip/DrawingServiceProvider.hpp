@@ -1,11 +1,11 @@
 #pragma once
 
-#include "AttributeRange.hpp"
+#include "AttributeArena.hpp"
 #include "Color.hpp"
 #include "DrawingService.hpp"
 #include "Rectangle.hpp"
 
-#include <unordered_map>
+#include <vector>
 
 #import <Cocoa/Cocoa.h>
 
@@ -27,13 +27,14 @@ namespace quip {
     void drawBarBefore (const Location & location, const Color & color, const Rectangle & frame) override;
     void drawBarAfter (const Location & location, const Color & color, const Rectangle & frame) override;
     
-    void drawText (const std::string & text, const Coordinate & coordinate, const std::vector<AttributeRange> & attributes) override;
+    void drawText (const std::string & text, const Coordinate & coordinate, AttributeSpan attributes) override;
     Rectangle measureText (const std::string & text) override;
     
   private:
     CTFontRef m_font;
     CFDictionaryRef m_fontAttributes;
     
-    std::unordered_map<std::string, Highlight> m_highlightAttributes;
+    // Indexed by attribute ID; groups without a highlight have no attributes.
+    std::vector<Highlight> m_highlightAttributes;
   };
 }
@@ -1,11 +1,11 @@
 #import "DrawingServiceProvider.hpp"
 
-#include "AttributeRange.hpp"
+#include "AttributeArena.hpp"
 #include "GlobalSettings.hpp"
 
 namespace quip {
   namespace {
-    static void initializeHighlight(std::unordered_map<std::string, Highlight>& mapping, const std::string& name, quip::Color foreground) {
+    static void initializeHighlight(std::vector<Highlight>& mapping, const std::string& name, quip::Color foreground) {
       Highlight result;
       result.foregroundColor = CGColorCreateGenericRGB(foreground.r(), foreground.g(), foreground.b(), foreground.a());
       
@@ -15,7 +15,12 @@ namespace quip {
       const void** opaqueValues = reinterpret_cast<const void **>(&values);
       result.attributes = CFDictionaryCreate(kCFAllocatorDefault, opaqueKeys, opaqueValues, 1, &kCFCopyStringDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
       
-      mapping[name] = result;
+      AttributeId attribute = AttributeRegistry::shared().intern(name);
+      if (attribute >= mapping.size()) {
+        mapping.resize(attribute + 1, Highlight{nullptr, nullptr});
+      }
+      
+      mapping[attribute] = result;
     }
     
     static void releaseHighlight(Highlight* highlight) {
@@ -50,11 +55,10 @@ namespace quip {
   }
   
   DrawingServiceProvider::~DrawingServiceProvider() {
-    auto cursor = m_highlightAttributes.begin();
-    auto end = m_highlightAttributes.end();
-    while (cursor != end) {
-      releaseHighlight(&cursor->second);
-      ++cursor;
+    for (Highlight& highlight : m_highlightAttributes) {
+      if (highlight.attributes != nullptr) {
+        releaseHighlight(&highlight);
+      }
     }
     
     CFRelease(m_fontAttributes);
@@ -99,7 +103,7 @@ namespace quip {
     CGContextStrokePath(context);
   }
 
-  void DrawingServiceProvider::drawText(const std::string& text, const quip::Coordinate& coordinate, const std::vector<AttributeRange>& attributes) {
+  void DrawingServiceProvider::drawText(const std::string& text, const quip::Coordinate& coordinate, AttributeSpan attributes) {
     CFStringRef string = CFStringCreateWithCStringNoCopy(kCFAllocatorDefault, text.c_str(), kCFStringEncodingUTF8, kCFAllocatorNull);
     CFMutableAttributedStringRef attributed = CFAttributedStringCreateMutable(kCFAllocatorDefault, CFStringGetLength(string));
     
@@ -108,7 +112,11 @@ namespace quip {
     CFAttributedStringSetAttributes(attributed, CFRangeMake(0, CFStringGetLength(string)), m_fontAttributes, YES);
     
     for (const AttributeRange& range : attributes) {
-      CFAttributedStringSetAttributes(attributed, CFRangeMake(range.start, range.length), m_highlightAttributes[range.name].attributes, NO);
+      if (range.attribute >= m_highlightAttributes.size() || m_highlightAttributes[range.attribute].attributes == nullptr) {
+        continue;
+      }
+      
+      CFAttributedStringSetAttributes(attributed, CFRangeMake(range.start, range.length), m_highlightAttributes[range.attribute].attributes, NO);
     }
     
     CFAttributedStringEndEditing(attributed);
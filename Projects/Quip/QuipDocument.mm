@@ -2,9 +2,15 @@
 
 #import "QuipWindowController.h"
 
+// Files at least this large are memory-mapped rather than read into memory.
+static const unsigned long long kMappedFileSize = 64 * 1024 * 1024;
+
 @interface QuipDocument () {
 @private
   std::shared_ptr<quip::Document> m_document;
+  
+  // The document as it was when the save in progress began.
+  std::shared_ptr<const quip::Document> m_snapshot;
 }
 
 @end
@@ -30,12 +36,35 @@
 }
 
 - (NSData *)dataOfType:(NSString *)type error:(NSError **)error {
-  std::string contents = m_document->contents().c_str();
+  // Saving may run on a background thread, so it writes out the snapshot taken when it began
+  // and lets editing carry on in the meantime.
+  std::shared_ptr<const quip::Document> snapshot = m_snapshot != nullptr ? m_snapshot : m_document->snapshot();
+  [self unblockUserInteraction];
+  
+  std::string contents = snapshot->contents().c_str();
   NSData * data = [NSData dataWithBytes:contents.c_str() length:contents.length()];
 
   return data;
 }
 
+- (BOOL)readFromURL:(NSURL *)url ofType:(NSString *)type error:(NSError **)error {
+  // Map huge local files rather than reading them into memory, so that opening them only costs
+  // a scan for line breaks. Another process truncating a mapped file can crash the app, so
+  // ordinary files are still read into memory.
+  if ([url isFileURL]) {
+    NSDictionary * attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:[url path] error:nil];
+    if (attributes != nil && [attributes fileSize] >= kMappedFileSize) {
+      std::shared_ptr<quip::Document> document = quip::Document::openMapped([[url path] fileSystemRepresentation]);
+      if (document != nullptr) {
+        m_document = document;
+        return YES;
+      }
+    }
+  }
+  
+  return [super readFromURL:url ofType:type error:error];
+}
+
 - (BOOL)readFromData:(NSData *)data ofType:(NSString *)type error:(NSError **)error {
   const char * start = reinterpret_cast<const char *>([data bytes]);
   const char * end = start + [data length];
@@ -57,7 +86,15 @@
     [manager createDirectoryAtPath:folder withIntermediateDirectories:YES attributes:nil error:nil];
   }
 
-  [super saveToURL:url ofType:typeName forSaveOperation:saveOperation completionHandler:completionHandler];
+  m_snapshot = m_document->snapshot();
+  [super saveToURL:url ofType:typeName forSaveOperation:saveOperation completionHandler:^(NSError* _Nullable error) {
+    self->m_snapshot = nullptr;
+    completionHandler(error);
+  }];
+}
+
+- (BOOL)canAsynchronouslyWriteToURL:(NSURL *)url ofType:(NSString *)typeName forSaveOperation:(NSSaveOperationType)saveOperation {
+  return YES;
 }
 
 + (BOOL)autosavesInPlace {
@@ -8,6 +8,8 @@
 #include "Mode.hpp"
 #include "PopupServiceProvider.hpp"
 #include "StatusServiceProvider.hpp"
+#include "SyntaxHighlighter.hpp"
+#include "ViewportModel.hpp"
 
 @interface QuipTextView () {
 @private
@@ -20,6 +22,8 @@
   std::unique_ptr<quip::PopupServiceProvider> m_popupServiceProvider;
   std::unique_ptr<quip::StatusServiceProvider> m_statusServiceProvider;
   std::shared_ptr<quip::EditContext> m_context;
+  std::unique_ptr<quip::SyntaxHighlighter> m_syntaxHighlighter;
+  quip::ViewportModel m_viewport;
   
   QuipStatusView* m_statusView;
   
@@ -91,23 +95,31 @@ static CGFloat gCursorBlinkInterval = 0.57;
 
 - (void)performUndo:(id)sender {
   m_context->undo();
-  [self setNeedsDisplay:YES];
+  [self invalidateDamage];
 }
 
 - (void)performRedo:(id)sender {
   m_context->redo();
-  [self setNeedsDisplay:YES];
+  [self invalidateDamage];
 }
 
 - (void)tick:(NSTimer*)timer {
   m_popupServiceProvider->tick(gTickInterval);
+  if (m_context->tick()) {
+    [self setNeedsDisplay:YES];
+  }
+  
+  if (m_syntaxHighlighter != nullptr && m_syntaxHighlighter->poll()) {
+    [self setNeedsDisplay:YES];
+  }
   
   m_cursorTimer -= gTickInterval;
   if (m_cursorTimer <= 0.0) {
     m_cursorTimer = gCursorBlinkInterval;
     m_shouldDrawCursor = !m_shouldDrawCursor;
     
-    [self setNeedsDisplay:YES];
+    [self damageSelections];
+    [self invalidateDamage];
   }
 }
 
@@ -115,7 +127,39 @@ static CGFloat gCursorBlinkInterval = 0.57;
   m_cursorTimer = gCursorBlinkInterval;
   m_shouldDrawCursor = YES;
   
-  [self setNeedsDisplay:YES];
+  [self damageSelections];
+  [self invalidateDamage];
+}
+
+- (void)damageSelections {
+  quip::DamageTracker& tracker = m_context->damageTracker();
+  tracker.damageSelections(m_context->selections());
+  for (auto&& overlay : m_context->overlays()) {
+    tracker.damageSelections(overlay.second.selections);
+  }
+}
+
+- (void)invalidateDamage {
+  // Selections may also have been changed directly rather than by a transaction.
+  quip::DamageTracker& tracker = m_context->damageTracker();
+  tracker.trackSelections(m_context->selections());
+  if (!tracker.isDamaged()) {
+    return;
+  }
+  
+  // Rows are laid out down from the top of the view. Cursors are drawn slightly below their
+  // rows, so each range is padded to include them.
+  const CGFloat padding = 2.0;
+  quip::Extent cellSize = m_drawingService->cellSize();
+  CGFloat height = self.frame.size.height;
+  for (const quip::DamageTracker::Range& range : tracker.ranges()) {
+    CGFloat top = range.firstRow * cellSize.height();
+    CGFloat bottom = range.lastRow == quip::DamageTracker::EndOfView ? height : (range.lastRow + 1.0) * cellSize.height();
+    NSRect rect = NSMakeRect(0.0, height - bottom - padding, self.frame.size.width, bottom - top + (2.0 * padding));
+    [self setNeedsDisplayInRect:NSIntersectionRect(rect, [self visibleRect])];
+  }
+  
+  tracker.clear();
 }
 
 - (void)mouseDown:(NSEvent*)event {
@@ -135,9 +179,9 @@ static CGFloat gCursorBlinkInterval = 0.57;
   }
   
   std::uint64_t column = target.column();
-  const std::string& line = m_context->document().row(row);
-  if (column >= line.size()) {
-    column = line.size() - 1;
+  std::size_t length = m_context->document().rowLength(row);
+  if (column >= length) {
+    column = length - 1;
   }
   
   target = quip::Location(column, row);
@@ -151,7 +195,7 @@ static CGFloat gCursorBlinkInterval = 0.57;
   quip::Rectangle rectangle(self.frame.origin.x, self.frame.origin.y, self.frame.size.width, self.frame.size.height);
   quip::Location target = m_drawingService->locationForCoordinateInFrame(coordinate, rectangle);
   
-  if (target.row() >= m_context->document().rows() || target.column() >= m_context->document().row(target.row()).length()) {
+  if (target.row() >= m_context->document().rows() || target.column() >= m_context->document().rowLength(target.row())) {
     return;
   }
   
@@ -186,6 +230,7 @@ static CGFloat gCursorBlinkInterval = 0.57;
   
   m_context->selections().replace(m_context->document().erase(m_context->selections()));
   [pasteboard writeObjects:items];
+  [self invalidateDamage];
 }
 
 - (void)copy:(id)sender {
@@ -208,16 +253,18 @@ static CGFloat gCursorBlinkInterval = 0.57;
     NSString* item = [items firstObject];
     std::string text = [item cStringUsingEncoding:NSUTF8StringEncoding];
     m_context->selections().replace(m_context->document().insert(m_context->selections(), text));
+    [self invalidateDamage];
   }
 }
 
 - (void)selectAll:(id)sender {
   const quip::Document& document = m_context->document();
   std::uint64_t row = document.rows() - 1;
-  std::uint64_t column = document.row(row).size() - 1;
+  std::uint64_t column = document.rowLength(row) - 1;
   
   quip::Selection selection(quip::Location(0, 0), quip::Location(column, row));
   m_context->selections().replace(selection);
+  [self invalidateDamage];
 }
 
 - (void)attachDrawingService:(quip::DrawingService*)drawingService {
@@ -245,10 +292,16 @@ static CGFloat gCursorBlinkInterval = 0.57;
     
     m_context->onTransactionApplied().disconnect(m_transactionAppliedToken);
     m_transactionAppliedToken = 0;
+    
+    m_syntaxHighlighter.reset();
   }
   
   m_context = std::make_shared<quip::EditContext>(m_popupServiceProvider.get(), m_statusServiceProvider.get(), m_scriptHost, document);
   
+  // Syntax scripts run on the highlighter's worker, so drawing never waits for them; rows are
+  // drawn plainly until their attributes arrive.
+  m_syntaxHighlighter = std::make_unique<quip::SyntaxHighlighter>(*document, *m_scriptHost);
+  
   NSWindowController * controller = [[self window] windowController];
   NSDocument * container = [controller document];
   
@@ -267,9 +320,14 @@ static CGFloat gCursorBlinkInterval = 0.57;
     [self scrollLocationIntoView:location];
   });
   
-  m_documentModifiedToken = m_context->document().onDocumentModified().connect([=] () {
+  m_documentModifiedToken = m_context->document().onDocumentModified().connect([=] (const quip::DocumentChange& change) {
+    // Rows are laid out down from the top of the view, so when its height changes every row
+    // moves within it.
     CGFloat height = MAX(parent.size.height, cellSize.height() * (document->rows() + 1));
-    [self setFrameSize:NSMakeSize(frame.size.width, height)];
+    if (height != self.frame.size.height) {
+      [self setFrameSize:NSMakeSize(frame.size.width, height)];
+      m_context->damageTracker().damageAll();
+    }
   });
   
   m_transactionAppliedToken = m_context->onTransactionApplied().connect([=] (quip::ChangeType type) {
@@ -341,52 +399,16 @@ static CGFloat gCursorBlinkInterval = 0.57;
   [self scrollPoint:CGPointMake(0.0, y - bias)];
 }
 
-- (void)drawSelections:(const quip::SelectionDrawInfo&)drawInfo context:(CGContextRef)context {
-  quip::Extent cellSize = m_drawingService->cellSize();
-  quip::Rectangle viewFrame = quip::Rectangle(self.frame.origin.x + gMargin, self.frame.origin.y, self.frame.size.width - (2.0f * gMargin), self.frame.size.height);
-  quip::Document& document = m_context->document();
-  for (const quip::Selection& selection : drawInfo.selections) {
-    const quip::Location& lower = selection.origin();
-    const quip::Location& upper = selection.extent();
-    std::size_t row = lower.row();
-    
-    do {
-      std::size_t firstColumn = row == lower.row() ? lower.column() : 0;
-      std::size_t lastColumn = row == upper.row() ? upper.column() : document.row(row).size() - 1;
-      
-      CGFloat x = gMargin + (firstColumn * cellSize.width());
-      CGFloat y = self.frame.size.height - cellSize.height() - (row * cellSize.height());
-      const quip::Color& color = selection == drawInfo.selections.primary() ? drawInfo.primaryColor : drawInfo.secondaryColor;
-      float heightFactor = row > lower.row() ? 1.0f : 0.75f;
-      
-      if (m_shouldDrawCursor || (drawInfo.flags & quip::CursorFlags::Blink) == 0) {
-        switch (drawInfo.style) {
-          case quip::CursorStyle::VerticalBlock:
-            m_drawingService->fillRectangle(quip::Rectangle(x, y - 2.0, cellSize.width() * (lastColumn + 1 - firstColumn), heightFactor * cellSize.height()), color);
-            break;
-          case quip::CursorStyle::VerticalBlockHalf:
-            m_drawingService->fillRectangle(quip::Rectangle(x, y - 2.0, cellSize.width() * (lastColumn + 1 - firstColumn), 0.25 * cellSize.height()), color);
-            break;
-          case quip::CursorStyle::VerticalBarAtOrigin:
-            m_drawingService->drawBarBefore(quip::Location(firstColumn, row), color, viewFrame);
-            break;
-          case quip::CursorStyle::VerticalBarAtExtent:
-            if(document.isEmpty() || document.row(row).size() == 0) {
-              m_drawingService->drawBarBefore(quip::Location(lastColumn, row), color, viewFrame);
-            } else {
-              m_drawingService->drawBarAfter(quip::Location(lastColumn, row), color, viewFrame);
-            }
-            break;
-          case quip::CursorStyle::Underline:
-          default:
-            m_drawingService->drawUnderline(row, firstColumn, lastColumn, color, viewFrame);
-            break;
-        }
-      }
-      
-      ++row;
-    } while (row <= upper.row());
+- (const quip::FileType*)fileType {
+  // Find the document's extension.
+  std::size_t index = m_context->document().path().find_last_of('.');
+  std::string extension = "";
+  if (index != std::string::npos) {
+    extension = m_context->document().path().substr(index + 1);
   }
+  
+  // Find the document's type.
+  return m_context->fileTypeDatabase().lookupByExtension(extension);
 }
 
 - (void)drawRect:(NSRect)dirtyRect {
@@ -394,25 +416,22 @@ static CGFloat gCursorBlinkInterval = 0.57;
     return;
   }
   
-  CGContextRef context = [[NSGraphicsContext currentContext] CGContext];
-  
   // Clear the background.
   quip::Rectangle rectangle(dirtyRect.origin.x, dirtyRect.origin.y, dirtyRect.size.width, dirtyRect.size.height);
   m_drawingService->fillRectangle(rectangle, quip::Color::white());
   
   if (m_context != nullptr) {
     quip::Document& document = m_context->document();
-
-    // Find the document's extension.
-    std::size_t index = m_context->document().path().find_last_of('.');
-    std::string extension = "";
-    const quip::FileType* fileType = nullptr;
-    if (index != std::string::npos) {
-      extension = m_context->document().path().substr(index + 1);
-    }
-
-    // Find the document's type.
-    fileType = m_context->fileTypeDatabase().lookupByExtension(extension);
+    const quip::FileType* fileType = [self fileType];
+    
+    // Everything below visits only the rows in view, so drawing costs the same however long the
+    // document is.
+    CGFloat height = self.frame.size.height;
+    NSRect visibleRect = [self visibleRect];
+    m_viewport.setCellSize(m_drawingService->cellSize());
+    m_viewport.setRows(document.rows());
+    m_viewport.setViewport(height - NSMaxY(visibleRect), visibleRect.size.height);
+    quip::Rectangle frame(gMargin, 0.0f, self.frame.size.width - (2.0f * gMargin), height);
     
     // Draw selections and overlays first (text is drawn over them).
     if (m_shouldDrawSelections) {
@@ -426,27 +445,24 @@ static CGFloat gCursorBlinkInterval = 0.57;
       drawInfo.flags = m_context->mode().cursorFlags();
       drawInfo.style = m_context->mode().cursorStyle();
       drawInfo.selections = m_context->selections();
-      [self drawSelections:drawInfo context:context];
+      m_viewport.drawSelections(*m_drawingService, document, drawInfo, frame, m_shouldDrawCursor);
     }
     
     for (auto&& overlay : m_context->overlays()) {
-      [self drawSelections:overlay.second context:context];
+      m_viewport.drawSelections(*m_drawingService, document, overlay.second, frame, m_shouldDrawCursor);
     }
     
-    // Draw text.
-    quip::Extent cellSize = m_drawingService->cellSize();
-    CGFloat y = self.frame.size.height - cellSize.height();
-    for (std::size_t row = 0; row < document.rows(); ++row) {
-      // Only draw the row if it clips into the dirty rectangle.
-      CGRect rowFrame = CGRectMake(gMargin, y, self.frame.size.width - (2.0 *  - gMargin), cellSize.height());
-      if (CGRectIntersectsRect(dirtyRect, rowFrame)) {
-        std::vector<quip::AttributeRange> syntaxAttributes = m_scriptHost->parseSyntax(fileType->syntax, m_context->document().row(row));
-        m_drawingService->drawText(document.row(row), quip::Coordinate(gMargin, y), syntaxAttributes);
-      }
-      
-      y -= cellSize.height();
+    // Draw text. The whole viewport is highlighted, even if only part of it needs drawing, so
+    // that scrolling finds the rows ahead of it ready.
+    m_syntaxHighlighter->setSyntax(fileType->syntax, fileType->tokenizer);
+    if (m_viewport.hasVisibleRows()) {
+      m_syntaxHighlighter->prepare(m_viewport.firstVisibleRow(), m_viewport.lastVisibleRow());
     }
     
+    CGFloat top = height - NSMaxY(dirtyRect);
+    CGFloat bottom = height - NSMinY(dirtyRect);
+    m_viewport.drawText(*m_drawingService, document, *m_syntaxHighlighter, frame, top, bottom);
+    
     quip::StatusService& status = m_context->statusService();
     status.setStatus(m_context->mode().status().c_str());
     status.setFileType(fileType->name);
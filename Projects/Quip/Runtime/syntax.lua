@@ -1,4 +1,10 @@
 -- Provides an API for describing high-level syntax highlighting primitives using LPeg.
+--
+-- A syntax file is a module: it's run once, to build its grammar, and returns a function that
+-- matches a row against that grammar. The function is called once per row with two arguments:
+-- the text of the row and the state the previous row ended in (empty for the first row). It
+-- returns a table of tokens and, optionally, the state the row ends in, which lets constructs
+-- such as block comments span rows.
 
 local L = require("lpeg")
 
@@ -11,4 +17,9 @@ end
 function S.ignore(pattern)
 end
 
+-- Records the state a row ends in, when matched within the table of tokens.
+function S.state(name)
+  return L.Cg(L.Cc(name), "state")
+end
+
 return S
@@ -2,12 +2,23 @@ local L = require("lpeg")
 local S = require("syntax")
 
 local preprocessor_directive = S.token("Preprocessor", L.P("#") * (L.P("ifdef") + L.P("ifndef") + L.P("if") + L.P("else") + L.P("endif") + L.P("include") + L.P("define") + L.P("undef")))
-local item = preprocessor_directive + (L.P(1) / S.ignore)
-local primary = L.Ct(item^1)
 
--- The first and only argument to the function is the text to be matched.
-local line = ...
-local result = primary:match(line)
+-- Block comments may span rows. A row that ends inside one ends in the "comment" state, and
+-- the next row begins by finishing it.
+local comment_body = (1 - L.P("*/"))^0
+local comment_close = comment_body * L.P("*/")
+local comment_open = L.P("/*") * comment_body * -1
+local block_comment = S.token("Comment", L.P("/*") * comment_close) + S.token("Comment", comment_open) * S.state("comment")
 
--- A Quip syntax file returns a table of all the captured tokens.
-return result
+local item = block_comment + preprocessor_directive + (L.P(1) / S.ignore)
+local continued = S.token("Comment", comment_close) + S.token("Comment", comment_body * -1) * S.state("comment")
+
+local primary = L.Ct(item^0)
+local primary_in_comment = L.Ct(continued * item^0)
+
+-- The arguments to the function are the text to be matched and the state the previous row
+-- ended in. It returns a table of all the captured tokens, and the state the row ended in.
+return function (line, state)
+  local result = (state == "comment" and primary_in_comment or primary):match(line)
+  return result, result.state
+end
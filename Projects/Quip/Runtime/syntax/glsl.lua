@@ -1 +1,3 @@
-return {}
+return function (line, state)
+  return {}
+end